@@ -0,0 +1,213 @@
+/*
+ *
+ *  Created on: 18/10/2026
+ *
+ *
+ *  		 This is a tutorial on the class JDCampaign: optimal theta and wobble for many sources,
+ *  		 instruments and candidates in one run
+ */
+
+#include "../source/JDQuadrature.cc"
+#include "../source/JDEvalContext.cc"
+#include "../source/JDAstroProfile.cc"
+#include "../source/JDDarkMatter.cc"
+#include "../source/JDInstrument.cc"
+#include "../source/JDGrid.cc"
+#include "../source/JDTaskScheduler.cc"
+#include "../source/JDBackgroundGeometry.cc"
+#include "../source/JDQFactorKernel.cc"
+#include "../source/JDQFactorExpression.cc"
+#include "../source/JDSurfaceStore.cc"
+#include "../source/JDOptimization.cc"
+#include "../source/JDCancelToken.cc"
+#include "../source/JDCampaign.cc"
+
+
+using namespace std;
+
+// General path
+TString myInstrumentPath = "/home/jpalacio/Work/eclipse/workspace/pic/DarkMatter/ObservationOptimization";
+TString mySourcePath = "/home/jpalacio/Work/eclipse/workspace/pic/DarkMatter/ObservationOptimization";
+
+
+//-------------------------------------
+//  Campaign of every dSph of Bonnivard and Geringer-Sameth, for Annihilation and Decay,
+//  for the ideal instrument and for MAGIC (the caller owns it)
+//
+//  Int_t numThreads		-> Threads running the jobs (0: one per hardware thread)
+//  TString storePath		-> Surface store (empty: none). Running the campaign again only reads the stored results
+JDCampaign* CreateCampaignAllSources(Int_t numThreads, TString storePath)
+{
+	JDCampaign* campaign = new JDCampaign(mySourcePath, myInstrumentPath);
+
+	cout << "   Sources of Bonnivard: " << campaign->AddSourcesFromReferences("Bonnivard") << endl;
+	cout << "   Sources of Geringer-Sameth: " << campaign->AddSourcesFromReferences("Geringer") << endl;
+
+	campaign->AddCandidate("Annihilation");
+	campaign->AddCandidate("Decay");
+
+	Double_t distanceCameraCenterMax=5;	// [deg]
+	Double_t wobbleDist=1.;				// [deg]
+	campaign->AddInstrument("IDEAL", distanceCameraCenterMax, wobbleDist);
+	campaign->AddInstrument("MAGICPointLike", distanceCameraCenterMax, wobbleDist);
+
+	campaign->AddType(0);		// 	J/theta
+	campaign->AddType(1);		//	J_on-J_off/theta
+	campaign->AddType(13);		//	J_on_eff-J_off_eff/theta_eff
+
+	campaign->SetNumThreads(numThreads);
+	campaign->SetSurfaceStore(storePath);
+	campaign->SetOptimizationMode(JDOptimization::kGridScan);
+	campaign->SetTolerance(0.30);
+
+	return campaign;
+}
+
+//-------------------------------------
+//  Optimal theta and wobble of every dSph of Bonnivard and Geringer-Sameth (see CreateCampaignAllSources())
+//
+//  TString resultsFile		-> Table with one line per source, candidate, instrument and QFactor type
+void RunCampaignAllSources(Int_t numThreads=0, TString storePath="campaignStore", TString resultsFile="campaignResults.txt")
+{
+	JDCampaign* campaign = CreateCampaignAllSources(numThreads, storePath);
+
+	campaign->Run(resultsFile);
+
+	cout << "   " << campaign->GetNumJobs() << " jobs, " << campaign->GetJobsPerSecond() << " jobs/s" << endl;
+
+	delete campaign;
+}
+
+//-------------------------------------
+//  RunCampaignAllSources() pipelined (see JDCampaign::SetIsPipelined()): the references of the next jobs are read and
+//  their tables sampled and smeared while the threads scan the previous ones. It prints the time of both ways.
+//
+//  Int_t pipelineCapacity	-> Most jobs set up and waiting for a thread (it caps the memory)
+void RunCampaignPipelined(Int_t numThreads=0, Int_t pipelineCapacity=4, TString resultsFile="campaignResultsPipelined.txt")
+{
+	// no surface store and a campaign for each run (the halos loaded are kept): both runs do everything
+	JDCampaign* campaign = CreateCampaignAllSources(numThreads, "");
+	TStopwatch stopwatch;
+	stopwatch.Start();
+	campaign->Run(resultsFile);
+	Double_t timeSerialSetup = stopwatch.RealTime();
+	delete campaign;
+
+	campaign = CreateCampaignAllSources(numThreads, "");
+	campaign->SetIsPipelined(1, pipelineCapacity);
+	stopwatch.Start();
+	campaign->Run(resultsFile);
+	Double_t timePipelined = stopwatch.RealTime();
+
+	cout << "   " << campaign->GetNumJobs() << " jobs:  setup then scan " << timeSerialSetup << " s,  pipelined " << timePipelined << " s"
+		 << "  (x" << timeSerialSetup/timePipelined << ")" << endl;
+
+	delete campaign;
+}
+
+//-------------------------------------
+//  RunCampaignAllSources() printing every job as soon as it ends (see JDCampaign::SetJobCallback()).
+//  The campaign is cancelled after deadline seconds: the table has the jobs run until then.
+//
+//  Double_t deadline		-> [s] (<=0: no deadline)
+void RunCampaignStreaming(Int_t numThreads=0, Double_t deadline=600., TString resultsFile="campaignResultsStreaming.txt")
+{
+	JDCampaign* campaign = CreateCampaignAllSources(numThreads, "campaignStore");
+
+	JDCancelToken token;
+	token.SetDeadline(deadline);
+	campaign->SetCancelToken(&token);
+
+	Int_t numJobs = 0;
+	campaign->SetJobCallback([&](const JDCampaign::JobResult& result)
+	{
+		numJobs++;
+		for(UInt_t t=0; t<result.vTypes.size(); t++)
+		{
+			const Double_t* optimum = &result.vOptimum[t*JDSurfaceStore::kNumOptimumValues];
+			cout << "   " << TString::Format("job %4d: %s %s %s type %d: theta_opt %.4f deg, wobble_opt %.4f deg",
+					numJobs,result.sSource.Data(),result.sCandidate.Data(),result.sInstrumentName.Data(),result.vTypes[t],
+					optimum[1],optimum[4]) << endl;
+		}
+		return 1;
+	});
+
+	campaign->Run(resultsFile);
+
+	delete campaign;
+}
+
+//-------------------------------------
+//  RunCampaignAllSources() that can be stopped at any time (killed, or at the deadline) and run again to go on from
+//  where it was: the jobs done are read from the progress file (see JDCampaign::SetIsResumed()), the job that was
+//  running goes on from the last checkpoint of its surfaces, and the smeared profiles and acceptances are read
+//  from the store.
+//
+//  Double_t checkpointInterval	-> [s] between the checkpoints of the surfaces of each job
+void RunCampaignResumable(Int_t numThreads=0, Double_t deadline=-1., Double_t checkpointInterval=60., TString resultsFile="campaignResultsResumable.txt")
+{
+	JDCampaign* campaign = CreateCampaignAllSources(numThreads, "campaignStore");
+
+	JDCancelToken token;
+	token.SetDeadline(deadline);
+	campaign->SetCancelToken(&token);
+	campaign->SetIsResumed(1);
+	campaign->SetCheckpointInterval(checkpointInterval);
+
+	campaign->Run(resultsFile);
+
+	cout << "   " << campaign->GetNumJobsResumed() << " of " << campaign->GetNumJobs() << " jobs resumed, "
+		 << campaign->GetNumJobsRun()-campaign->GetNumJobsResumed() << " run now" << endl;
+	if(campaign->GetIsCancelled())
+		cout << "   Not complete: run it again to resume it" << endl;
+
+	delete campaign;
+}
+
+//-------------------------------------
+//  One shard of RunCampaignAllSources(), run as an independent process (see runJDCampaignShards.sh).
+//  It writes the partial table JDCampaign::GetShardFile(resultsFile, shard, numShards).
+//  If the shard fails, ROOT exits with status 1 (root -q would exit with 0), so that the script sees it.
+void RunCampaignShard(Int_t shard, Int_t numShards, Int_t numThreads=1, TString storePath="campaignStore", TString resultsFile="campaignResults.txt")
+{
+	JDCampaign* campaign = CreateCampaignAllSources(numThreads, storePath);
+
+	campaign->SetShard(shard, numShards);
+	Bool_t isDone = campaign->Run(resultsFile);
+
+	delete campaign;
+	if(!isDone) gSystem->Exit(1);
+}
+
+//-------------------------------------
+//  It merges the partial tables of the numShards shards into resultsFile, the table of RunCampaignAllSources().
+//  If they cannot be merged, ROOT exits with status 1 (see RunCampaignShard()).
+void MergeCampaignShards(Int_t numShards, TString resultsFile="campaignResults.txt")
+{
+	if(!JDCampaign::MergeResults(resultsFile, numShards)) gSystem->Exit(1);
+}
+
+//-------------------------------------
+//  The same optimization for a few sources given by hand
+void RunCampaignSomeSources(Int_t numThreads=0)
+{
+	JDCampaign* campaign = new JDCampaign(mySourcePath, myInstrumentPath);
+
+	campaign->AddSource("Bonnivard", "uma2");
+	campaign->AddSource("Bonnivard", "dra");
+	campaign->AddSource("Geringer", "seg1");
+	campaign->AddCandidate("Decay");
+	campaign->AddInstrument("MAGICPointLike", 5., 1.);
+	campaign->AddType(13);
+
+	campaign->SetNumThreads(numThreads);
+	campaign->Run("campaignSomeSources.txt");
+
+	delete campaign;
+}
+
+void exampleJDCampaign()
+{
+	RunCampaignSomeSources();
+//	RunCampaignAllSources();
+}
@@ -26,6 +26,8 @@
 #include <iostream>
 #include <TStyle.h>
 
+#include "/Users/mdoro/Soft/ObservationOptimization/source/JDQuadrature.cc"
+#include "/Users/mdoro/Soft/ObservationOptimization/source/JDEvalContext.cc"
 #include "/Users/mdoro/Soft/ObservationOptimization/source/JDDarkMatter.cc"
 //#include "/Users/mdoro/Soft/ObservationOptimization/source/JDAstroProfile.cc"
 
@@ -26,6 +26,8 @@
 #include <iostream>
 #include <TStyle.h>
 
+#include "../source/JDQuadrature.cc"
+#include "../source/JDEvalContext.cc"
 #include "../source/JDInstrument.cc"
 
 using namespace std;
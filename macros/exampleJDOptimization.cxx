@@ -10,15 +10,27 @@
  *  		 This is a tutorial on the main features of the class JDOptimization
  */
 
+#include "../source/JDQuadrature.cc"
+#include "../source/JDEvalContext.cc"
 #include "../source/JDAstroProfile.cc"
 #include "../source/JDDarkMatter.cc"
 #include "../source/JDInstrument.cc"
+#include "../source/JDGrid.cc"
+#include "../source/JDTaskScheduler.cc"
+#include "../source/JDBackgroundGeometry.cc"
+#include "../source/JDQFactorKernel.cc"
+#include "../source/JDQFactorExpression.cc"
+#include "../source/JDSurfaceStore.cc"
 #include "../source/JDOptimization.cc"
+#include "../source/JDCancelToken.cc"
+#include "../source/JDQFactorScan.cc"
 
 #include <TStyle.h>
 #include <TLegend.h>
 #include <TCanvas.h>
 #include <TF1.h>
+#include <TF2.h>
+#include <TStopwatch.h>
 
 
 using namespace std;
@@ -524,6 +536,255 @@ void PlotQ123Factor()
 
 }
 
+//-------------------------------------
+//  Benchmark of the QFactor vs theta and wobble: time to fill the grid of each type
+//		- evaluating the TF2 at every bin: one disk integral of the kernel per bin, without the radial sweep
+//		  (the TF2 evaluates the kernel, not the original adaptive integrals: see JDQFactorKernel.h)
+//		- with the generic kernel (radial sweep along each wobble row)
+//		- with the kernel specialized for the type
+//  It prints the times, the speedups and the largest difference between the grids (and the utilization of the threads).
+//  The kernels are then compared with the original TF2::Integral() path (adaptive, relative tolerance 1e-2) for the
+//  type 3, the only one whose expression did not change (ON/Sqrt(ACC)): both QFactors at the wobble of the
+//  JDOptimization, normalized at the middle theta of the grid.
+//
+//  Int_t numThreads		-> Threads used to fill the grids (1: serial, to compare the kernels alone)
+void BenchmarkQFactorKernels(Int_t numThreads=1)
+{
+	TString author = "Bonnivard";
+	TString source = "uma2";
+	TString candidate = "Decay";
+	TString instrumentName= "MAGICPointLike";
+	Double_t distanceCameraCenterMax=5;	// [deg]
+	Double_t wobbleDist=1.;	// [deg]
+
+	JDOptimization* QFactor = new JDOptimization(author, source, candidate, mySourcePath, myInstrumentPath, instrumentName, distanceCameraCenterMax, wobbleDist);
+	QFactor->SetNumThreads(numThreads);
+
+	const Int_t numTypes = 6;
+	Int_t types[numTypes] = {0, 1, 3, 13, 123, 1234};
+
+	TStopwatch stopwatch;
+	for(Int_t t=0; t<numTypes; t++)
+	{
+		// The first call samples (and smears) the profiles: it is not timed
+		QFactor->SetIsQFactorKernelSpecialized(1);
+		QFactor->GetGridQFactorVsThetaWobble(types[t]);
+
+		QFactor->SetIsQFactorKernelSpecialized(0);
+		stopwatch.Start();
+		JDGrid2D generic(*QFactor->GetGridQFactorVsThetaWobble(types[t]));
+		Double_t timeGeneric = stopwatch.RealTime();
+
+		QFactor->SetIsQFactorKernelSpecialized(1);
+		stopwatch.Start();
+		const JDGrid2D* specialized = QFactor->GetGridQFactorVsThetaWobble(types[t]);
+		Double_t timeSpecialized = stopwatch.RealTime();
+		if(numThreads!=1) QFactor->PrintThreadUtilization();
+
+		TF2* functionQFactor = QFactor->GetTF2QFactorVsThetaWobble(types[t]);
+		const JDGridAxis& thetaAxis = specialized->GetXaxis();
+		const JDGridAxis& wobbleAxis = specialized->GetYaxis();
+		Double_t maxDifference = 0.;
+		stopwatch.Start();
+		for(Int_t j=0; j<wobbleAxis.GetNumBins(); j++)
+		{
+			for(Int_t i=0; i<thetaAxis.GetNumBins(); i++)
+			{
+				Double_t qFactor = functionQFactor->Eval(thetaAxis.GetBinCenter(i),wobbleAxis.GetBinCenter(j));
+				maxDifference = TMath::Max(maxDifference,TMath::Abs(qFactor-specialized->GetBinContent(i,j)));
+				maxDifference = TMath::Max(maxDifference,TMath::Abs(generic.GetBinContent(i,j)-specialized->GetBinContent(i,j)));
+			}
+		}
+		Double_t timePerBin = stopwatch.RealTime();
+
+		cout << "   QFactor " << types[t] << ":  per bin " << timePerBin << " s,  generic " << timeGeneric << " s,  specialized " << timeSpecialized << " s"
+			 << "  (x" << timePerBin/timeSpecialized << " vs per bin, x" << timeGeneric/timeSpecialized << " vs generic)"
+			 << "  max |diff| / max = " << maxDifference/specialized->GetMaximum() << endl;
+	}
+
+	// The original adaptive integrals of the type 3: ON = dNdOmega·epsilon and ACC = epsilon over the disk of theta
+	JDInstrument* instrument = new JDInstrument(instrumentName, wobbleDist, myInstrumentPath);
+	TF2* functionOn = QFactor->GetTF2dNdOmegaEpsilonThetaVsThetaPhi();
+	TF2* functionAcc = instrument->GetTF2EpsilonVsThetaAndPhi();
+	TF2* functionQFactor = QFactor->GetTF2QFactorVsThetaWobble(3);
+	const JDGridAxis& thetaAxis = QFactor->GetGridQFactorVsThetaWobble(3)->GetXaxis();
+	const Int_t numPoints = 20;
+	Int_t stepBins = TMath::Max(thetaAxis.GetNumBins()/numPoints,1);
+	Double_t thetaNorm = thetaAxis.GetBinCenter(thetaAxis.GetNumBins()/2);
+
+	Double_t adaptiveNorm = functionOn->Integral(0.,thetaNorm,0.,2*TMath::Pi(),1e-2)/TMath::Sqrt(functionAcc->Integral(0.,thetaNorm,0.,2*TMath::Pi(),1e-2));
+	Double_t kernelNorm = functionQFactor->Eval(thetaNorm,wobbleDist);
+	Double_t maxRelDifference = 0., timeAdaptive = 0., timeKernel = 0.;
+	Double_t thetaOptAdaptive = 0., thetaOptKernel = 0., qOptAdaptive = 0., qOptKernel = 0.;
+	for(Int_t i=stepBins/2; i<thetaAxis.GetNumBins(); i+=stepBins)
+	{
+		Double_t theta = thetaAxis.GetBinCenter(i);
+		stopwatch.Start();
+		Double_t adaptive = functionOn->Integral(0.,theta,0.,2*TMath::Pi(),1e-2)/TMath::Sqrt(functionAcc->Integral(0.,theta,0.,2*TMath::Pi(),1e-2))/adaptiveNorm;
+		timeAdaptive += stopwatch.RealTime();
+		stopwatch.Start();
+		Double_t kernel = functionQFactor->Eval(theta,wobbleDist)/kernelNorm;
+		timeKernel += stopwatch.RealTime();
+
+		maxRelDifference = TMath::Max(maxRelDifference,TMath::Abs(kernel-adaptive)/adaptive);
+		if(adaptive>qOptAdaptive) {qOptAdaptive=adaptive; thetaOptAdaptive=theta;}
+		if(kernel>qOptKernel) {qOptKernel=kernel; thetaOptKernel=theta;}
+	}
+	cout << "   QFactor 3 vs the adaptive TF2::Integral():  adaptive " << timeAdaptive << " s,  kernel " << timeKernel << " s"
+		 << "  (x" << timeAdaptive/timeKernel << ")  max |diff| / Q = " << maxRelDifference
+		 << "  optimal theta " << thetaOptAdaptive << " vs " << thetaOptKernel << " deg" << endl;
+
+	delete instrument;
+	delete QFactor;
+}
+
+//-------------------------------------
+//  Benchmark of the sums of the QFactor integrals (see JDReduction): time to fill the grid of each type with the
+//  compensated sums (kDeterministic) and with the plain ones (kFast), and the largest difference between both grids.
+//
+//  Int_t numThreads		-> Threads used to fill the grids
+void BenchmarkReductions(Int_t numThreads=1)
+{
+	TString author = "Bonnivard";
+	TString source = "uma2";
+	TString candidate = "Decay";
+	TString instrumentName= "MAGICPointLike";
+	Double_t distanceCameraCenterMax=5;	// [deg]
+	Double_t wobbleDist=1.;	// [deg]
+
+	JDOptimization* QFactor = new JDOptimization(author, source, candidate, mySourcePath, myInstrumentPath, instrumentName, distanceCameraCenterMax, wobbleDist);
+	QFactor->SetNumThreads(numThreads);
+
+	const Int_t numTypes = 6;
+	Int_t types[numTypes] = {0, 1, 3, 13, 123, 1234};
+
+	TStopwatch stopwatch;
+	for(Int_t t=0; t<numTypes; t++)
+	{
+		// The first call samples (and smears) the profiles: it is not timed
+		QFactor->SetReductionMode(JDReduction::kFast);
+		QFactor->GetGridQFactorVsThetaWobble(types[t]);
+
+		QFactor->SetReductionMode(JDReduction::kFast);
+		stopwatch.Start();
+		JDGrid2D fast(*QFactor->GetGridQFactorVsThetaWobble(types[t]));
+		Double_t timeFast = stopwatch.RealTime();
+
+		QFactor->SetReductionMode(JDReduction::kDeterministic);
+		stopwatch.Start();
+		const JDGrid2D* deterministic = QFactor->GetGridQFactorVsThetaWobble(types[t]);
+		Double_t timeDeterministic = stopwatch.RealTime();
+
+		Double_t maxDifference = 0.;
+		for(Int_t j=0; j<deterministic->GetYaxis().GetNumBins(); j++)
+		{
+			for(Int_t i=0; i<deterministic->GetXaxis().GetNumBins(); i++)
+			{
+				maxDifference = TMath::Max(maxDifference,TMath::Abs(fast.GetBinContent(i,j)-deterministic->GetBinContent(i,j)));
+			}
+		}
+
+		cout << "   QFactor " << types[t] << ":  " << JDReduction::GetModeName(JDReduction::kFast) << " " << timeFast << " s,  "
+			 << JDReduction::GetModeName(JDReduction::kDeterministic) << " " << timeDeterministic << " s"
+			 << "  (x" << timeDeterministic/timeFast << ")  max |diff| / max = " << maxDifference/deterministic->GetMaximum() << endl;
+	}
+
+	delete QFactor;
+}
+
+//-------------------------------------
+//  Optimal theta and wobble with 1 to maxNumOffRegions reflected OFF regions per pointing (see JDBackgroundGeometry)
+//  It prints the optimal point of each background geometry, its QFactor relative to the one of a single OFF region
+//  and the time to find it. All the geometries have the same observation time: the 4 pointings share it, and the
+//  QFactor changes with the noise of the background, Sqrt(1+alpha), and with the leakage of the OFF regions.
+//
+//  Int_t type				-> QFactor type (with leakage)
+//  Int_t maxNumOffRegions	-> Largest number of OFF regions
+void CompareBackgroundGeometries(Int_t type=13, Int_t maxNumOffRegions=5)
+{
+	TString author = "Bonnivard";
+	TString source = "uma2";
+	TString candidate = "Decay";
+	TString instrumentName= "MAGICPointLike";
+	Double_t distanceCameraCenterMax=5;	// [deg]
+	Double_t wobbleDist=1.;	// [deg]
+
+	JDOptimization* QFactor = new JDOptimization(author, source, candidate, mySourcePath, myInstrumentPath, instrumentName, distanceCameraCenterMax, wobbleDist);
+
+	TStopwatch stopwatch;
+	Double_t qFactorMaxSingle = 0.;
+	for(Int_t numOffRegions=1; numOffRegions<=maxNumOffRegions; numOffRegions++)
+	{
+		JDBackgroundGeometry geometry(4,numOffRegions);
+		QFactor->SetBackgroundGeometry(geometry);
+
+		Double_t thetaOpt, thetaOptRangMin, thetaOptRangMax, wobbleOpt, wobbleOptRangMin, wobbleOptRangMax;
+		stopwatch.Start();
+		Double_t qFactorMax = QFactor->GetOptimalThetaAndWobble(thetaOpt,thetaOptRangMin,thetaOptRangMax,wobbleOpt,wobbleOptRangMin,wobbleOptRangMax,type);
+		Double_t time = stopwatch.RealTime();
+
+		if(numOffRegions==1) qFactorMaxSingle = qFactorMax;
+
+		cout << "   " << numOffRegions << " OFF regions (alpha=" << geometry.GetAlpha() << ", noise x" << 1./geometry.GetQFactorScale() << "):  theta_opt "
+			 << thetaOpt << " deg,  wobble_opt " << wobbleOpt << " deg,  QFactor_max " << qFactorMax << " (x" << qFactorMax/qFactorMaxSingle
+			 << " vs 1 OFF region)  (" << time << " s)" << endl;
+	}
+
+	delete QFactor;
+}
+
+//-------------------------------------
+//  QFactor vs theta and wobble received row by row (see JDQFactorScan), stopping as soon as the optimum is bracketed:
+//  the row with the largest QFactor has been received and, on each side, all the rows up to one whose maximum is below
+//  (1-tolerance) of it (or up to the edge). It prints each row received and the optimal point of the partial grid.
+//
+//  Int_t type				-> QFactor type
+//  Double_t deadline		-> [s] The scan is cancelled after this time, bracketed or not
+void StreamQFactorScan(Int_t type=13, Double_t deadline=60.)
+{
+	TString author = "Bonnivard";
+	TString source = "uma2";
+	TString candidate = "Decay";
+	TString instrumentName= "MAGICPointLike";
+	Double_t distanceCameraCenterMax=5;	// [deg]
+	Double_t wobbleDist=1.;	// [deg]
+
+	JDOptimization* QFactor = new JDOptimization(author, source, candidate, mySourcePath, myInstrumentPath, instrumentName, distanceCameraCenterMax, wobbleDist);
+	Double_t level = 1.-QFactor->GetTolerance();
+
+	JDCancelToken token;
+	token.SetDeadline(deadline);
+	JDQFactorScan scan(QFactor, type, &token);
+
+	std::vector<Double_t> rowMaxima;
+	Bool_t isBracketed = 0;
+	scan.Run([&](const JDQFactorScan::Row& row)
+	{
+		if(rowMaxima.size()==0) rowMaxima.assign(scan.GetNumRows(),0.);
+		rowMaxima[row.iWobbleBin] = TMath::MaxElement(row.iNumThetaBins,row.qFactors);
+		cout << "   " << TString::Format("row %4d (wobble %.3f deg): max QFactor %.4e  [%d of %d rows]",row.iWobbleBin,row.dWobble,
+				rowMaxima[row.iWobbleBin],scan.GetNumRowsReceived(),scan.GetNumRows()) << endl;
+
+		Int_t jMax = TMath::LocMax(rowMaxima.size(),rowMaxima.data());
+		Int_t jLow = jMax, jHigh = jMax;
+		while(jLow>=0 && scan.GetIsRowReceived(jLow) && rowMaxima[jLow]>=level*rowMaxima[jMax]) jLow--;
+		while(jHigh<scan.GetNumRows() && scan.GetIsRowReceived(jHigh) && rowMaxima[jHigh]>=level*rowMaxima[jMax]) jHigh++;
+		isBracketed = (jLow<0 || scan.GetIsRowReceived(jLow)) && (jHigh>=scan.GetNumRows() || scan.GetIsRowReceived(jHigh));
+		return !isBracketed;
+	});
+
+	Double_t thetaOpt, thetaOptRangMin, thetaOptRangMax, wobbleOpt, wobbleOptRangMin, wobbleOptRangMax;
+	Double_t qFactorMax = JDOptimization::GetOptimalThetaAndWobble(scan.GetGrid(),QFactor->GetTolerance(),thetaOpt,thetaOptRangMin,thetaOptRangMax,wobbleOpt,wobbleOptRangMin,wobbleOptRangMax);
+
+	if(scan.GetIsComplete())		cout << "   Complete scan" << endl;
+	else if(isBracketed)			cout << "   Optimum bracketed after " << scan.GetNumRowsReceived() << " of " << scan.GetNumRows() << " rows" << endl;
+	else if(token.GetIsDeadlineReached())	cout << "   Deadline reached after " << scan.GetNumRowsReceived() << " of " << scan.GetNumRows() << " rows" << endl;
+	cout << "   theta_opt " << thetaOpt << " deg [" << thetaOptRangMin << ", " << thetaOptRangMax << "],  wobble_opt " << wobbleOpt
+		 << " deg [" << wobbleOptRangMin << ", " << wobbleOptRangMax << "],  QFactor_max " << qFactorMax << endl;
+
+	delete QFactor;
+}
+
 void exampleJDOptimization()
 {
 
@@ -536,4 +797,9 @@ void exampleJDOptimization()
 	PlotQ13Factor();	//	J_on_eff/Sqrt{(theta_eff)^2 + J_off_eff}
 //	PlotQ23Factor();	//	J_1sm_eff/theta_eff
 //	PlotQ123Factor();	//	J_on_1sm_eff/Sqrt{(theta_eff)^2 + J_off_1sm_eff}
+
+//	BenchmarkQFactorKernels();
+//	BenchmarkReductions();
+//	CompareBackgroundGeometries();
+//	StreamQFactorScan();
 }
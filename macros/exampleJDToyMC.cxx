@@ -0,0 +1,81 @@
+/*
+ *
+ *  Created on: 18/10/2026
+ *
+ *
+ *  		 This is a tutorial on the class JDToyMC: how the uncertainty of the JFactor propagates
+ *  		 to the optimal theta and wobble
+ */
+
+#include "../source/JDQuadrature.cc"
+#include "../source/JDEvalContext.cc"
+#include "../source/JDAstroProfile.cc"
+#include "../source/JDDarkMatter.cc"
+#include "../source/JDInstrument.cc"
+#include "../source/JDGrid.cc"
+#include "../source/JDTaskScheduler.cc"
+#include "../source/JDBackgroundGeometry.cc"
+#include "../source/JDQFactorKernel.cc"
+#include "../source/JDQFactorExpression.cc"
+#include "../source/JDSurfaceStore.cc"
+#include "../source/JDOptimization.cc"
+#include "../source/JDToyMC.cc"
+
+#include <TCanvas.h>
+#include <TH1.h>
+
+
+using namespace std;
+
+// General path
+TString myInstrumentPath = "/home/jpalacio/Work/eclipse/workspace/pic/DarkMatter/ObservationOptimization";
+TString mySourcePath = "/home/jpalacio/Work/eclipse/workspace/pic/DarkMatter/ObservationOptimization";
+
+
+//-------------------------------------
+//  Distribution of the optimal theta, wobble and maximum QFactor over draws of the JFactor between its credible bands
+//
+//  Int_t numDraws		-> Number of profiles drawn
+//  Int_t type			-> QFactor type (its uncertainty digit is ignored: the draws replace it)
+//  Int_t numThreads	-> Threads running the draws (0: one per hardware thread)
+void PlotOptimalThetaAndWobbleDistributions(Int_t numDraws=200, Int_t type=13, Int_t numThreads=0)
+{
+	TString author = "Bonnivard";
+	TString source = "uma2";
+	TString candidate = "Annihilation";
+	TString instrumentName= "MAGICPointLike";
+	Double_t wobbleDist=1.;	// [deg]
+
+	JDDarkMatter* darkMatter = new JDDarkMatter(author, source, candidate, mySourcePath);
+	JDInstrument* instrument = new JDInstrument(instrumentName, wobbleDist, myInstrumentPath);
+
+	JDToyMC* toyMC = new JDToyMC(darkMatter, instrument);
+	toyMC->SetNumThreads(numThreads);
+	toyMC->SetSeed(1);
+	if(!toyMC->Run(numDraws, type)) return;
+	toyMC->Print();
+
+	TH1D* hQFactorMax = toyMC->GetTH1Distribution(JDToyMC::kQFactorMax);
+	TH1D* hThetaOpt = toyMC->GetTH1Distribution(JDToyMC::kThetaOpt);
+	TH1D* hWobbleOpt = toyMC->GetTH1Distribution(JDToyMC::kWobbleOpt);
+
+	TCanvas* canvas = new TCanvas("canvasToyMC","",1200,400);
+	canvas->Divide(3,1);
+	canvas->cd(1);
+	hQFactorMax->SetXTitle(" QFactor_{max} ");
+	hQFactorMax->Draw();
+	canvas->cd(2);
+	hThetaOpt->SetXTitle(" #theta_{opt} [deg]");
+	hThetaOpt->Draw();
+	canvas->cd(3);
+	hWobbleOpt->SetXTitle(" wobble_{opt} [deg]");
+	hWobbleOpt->Draw();
+	canvas->Update();
+
+	delete toyMC;
+}
+
+void exampleJDToyMC()
+{
+	PlotOptimalThetaAndWobbleDistributions();
+}
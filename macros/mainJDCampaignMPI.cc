@@ -0,0 +1,82 @@
+/*
+ *
+ *  Created on: 18/10/2026
+ *
+ *
+ *  		 The campaign of exampleJDCampaign.cxx (RunCampaignAllSources) distributed over MPI ranks
+ *  		 (see JDCampaign::RunMPI()). It is a compiled program, not a ROOT macro:
+ *
+ *  		 	mpicxx -O2 -DJD_WITH_MPI `root-config --cflags` mainJDCampaignMPI.cc -o mainJDCampaignMPI `root-config --libs`
+ *  		 	mpirun -np 4 ./mainJDCampaignMPI [resultsFile] [storePath] [numThreads]
+ *
+ *  		 The rank 0 deals the jobs and writes the results, so at least 2 ranks are needed to run jobs in parallel
+ *  		 (with one rank it is a serial JDCampaign::Run()). Each rank runs one job at a time on the threads of
+ *  		 SetNumThreads() (numThreads, 1 by default): one rank per core with 1 thread, or one rank per node with 0
+ *  		 (all the cores of the node; the rank 0 only deals the jobs).
+ */
+
+#include "../source/JDQuadrature.cc"
+#include "../source/JDEvalContext.cc"
+#include "../source/JDAstroProfile.cc"
+#include "../source/JDDarkMatter.cc"
+#include "../source/JDInstrument.cc"
+#include "../source/JDGrid.cc"
+#include "../source/JDTaskScheduler.cc"
+#include "../source/JDBackgroundGeometry.cc"
+#include "../source/JDQFactorKernel.cc"
+#include "../source/JDQFactorExpression.cc"
+#include "../source/JDSurfaceStore.cc"
+#include "../source/JDOptimization.cc"
+#include "../source/JDCancelToken.cc"
+#include "../source/JDCampaign.cc"
+
+#include <mpi.h>
+
+using namespace std;
+
+// General path
+TString myInstrumentPath = "/home/jpalacio/Work/eclipse/workspace/pic/DarkMatter/ObservationOptimization";
+TString mySourcePath = "/home/jpalacio/Work/eclipse/workspace/pic/DarkMatter/ObservationOptimization";
+
+int main(int argc, char** argv)
+{
+	MPI_Init(&argc,&argv);
+
+	TString resultsFile = (argc>1? argv[1] : "campaignResults.txt");
+	TString storePath = (argc>2? argv[2] : "campaignStore");
+	Int_t numThreads = (argc>3? atoi(argv[3]) : 1);		// of each rank (0: all the cores)
+
+	Int_t rank;
+	MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+
+	// only the rank 0 reads the references to build the matrix: the others receive it (see JDCampaign::RunMPI())
+	JDCampaign* campaign = new JDCampaign(mySourcePath, myInstrumentPath);
+	if(rank==0)
+	{
+		cout << "   Sources of Bonnivard: " << campaign->AddSourcesFromReferences("Bonnivard") << endl;
+		cout << "   Sources of Geringer-Sameth: " << campaign->AddSourcesFromReferences("Geringer") << endl;
+
+		campaign->AddCandidate("Annihilation");
+		campaign->AddCandidate("Decay");
+
+		Double_t distanceCameraCenterMax=5;	// [deg]
+		Double_t wobbleDist=1.;				// [deg]
+		campaign->AddInstrument("IDEAL", distanceCameraCenterMax, wobbleDist);
+		campaign->AddInstrument("MAGICPointLike", distanceCameraCenterMax, wobbleDist);
+
+		campaign->AddType(0);		// 	J/theta
+		campaign->AddType(1);		//	J_on-J_off/theta
+		campaign->AddType(13);		//	J_on_eff-J_off_eff/theta_eff
+
+		campaign->SetSurfaceStore(storePath);
+		campaign->SetOptimizationMode(JDOptimization::kGridScan);
+		campaign->SetTolerance(0.30);
+	}
+	campaign->SetNumThreads(numThreads);
+
+	campaign->RunMPI(resultsFile);
+
+	delete campaign;
+	MPI_Finalize();
+	return 0;
+}
@@ -0,0 +1,47 @@
+#!/bin/bash
+#
+#  runJDCampaignShards.sh
+#
+#  Created on: 18/10/2026
+#
+#  		 It runs RunCampaignAllSources() of exampleJDCampaign.cxx split in numShards independent ROOT processes on this
+#  		 machine (see JDCampaign::SetShard()) and merges their partial tables into resultsFile. On a cluster, submit
+#  		 one RunCampaignShard(shard,numShards,...) per node with the same arguments, sharing storePath and the
+#  		 directory of resultsFile, and call MergeCampaignShards(numShards,resultsFile) when all of them are done.
+#
+#  usage: ./runJDCampaignShards.sh numShards [resultsFile] [storePath] [threadsPerShard]
+#
+#  		 threadsPerShard defaults to the hardware threads divided by numShards (at least 1).
+#  		 The output of each shard is kept in resultsFile.shard<k>of<numShards>.log
+
+numShards=${1:?usage: $0 numShards [resultsFile] [storePath] [threadsPerShard]}
+resultsFile=${2:-campaignResults.txt}
+storePath=${3:-campaignStore}
+numCores=$(nproc 2>/dev/null || sysctl -n hw.ncpu 2>/dev/null || echo 1)
+threadsPerShard=${4:-$(( numCores/numShards>0 ? numCores/numShards : 1 ))}
+
+# the paths are relative to the directory of the caller, not to the one of the macro
+absolutePath() { case "$1" in ""|/*) echo "$1" ;; *) echo "${PWD}/$1" ;; esac; }
+resultsFile=$(absolutePath "${resultsFile}")
+storePath=$(absolutePath "${storePath}")
+
+cd "$(dirname "$0")" || exit 1
+
+pids=()
+for (( shard=0; shard<numShards; shard++ ))
+do
+	log="${resultsFile}.shard${shard}of${numShards}.log"
+	root -l -b -q -e '.L exampleJDCampaign.cxx' \
+		-e "RunCampaignShard(${shard},${numShards},${threadsPerShard},\"${storePath}\",\"${resultsFile}\")" > "${log}" 2>&1 &
+	pids+=($!)
+	echo "   shard ${shard} of ${numShards}: pid $!, log ${log}"
+done
+
+failed=0
+for (( shard=0; shard<numShards; shard++ ))
+do
+	wait ${pids[$shard]} || { echo "   ERROR: shard ${shard} failed (see its log)"; failed=1; }
+done
+[ ${failed} -eq 0 ] || exit 1
+
+root -l -b -q -e '.L exampleJDCampaign.cxx' -e "MergeCampaignShards(${numShards},\"${resultsFile}\")"
@@ -9,6 +9,8 @@
  */
 
 #include "JDAstroProfile.h"
+#include "JDEvalContext.h"
+#include "JDQuadrature.h"
 
 #include <TGraph.h>
 #include <TMath.h>
@@ -146,13 +148,84 @@ Double_t JDAstroProfile::TGraphdNdOmegaSigma1VsTheta(Double_t* x, Double_t* par)
 		return gdNdOmegaSigma1->Eval(x[0]);
 }
 
+//-----------------------------------------------
+// It evaluates the dNdOmega [~GeV, ~cm] (or the dNdOmegaSigma1) at theta [deg]. Reentrant.
+Double_t JDAstroProfile::EvaluatedNdOmega(Double_t theta, Bool_t isSigma1) const
+{
+	return (isSigma1? gdNdOmegaSigma1 : gdNdOmega)->Eval(theta);
+}
+
+//-----------------------------------------------
+// It evaluates the dNdOmega [~GeV, ~cm] (or the dNdOmegaSigma1) at theta [deg] and phi [rad] around an OFF region
+// at offset [deg] from the source (the distance to the source is calculated from the law of cosines). Reentrant.
+Double_t JDAstroProfile::EvaluatedNdOmegaOff(Double_t theta, Double_t phi, Double_t offset, Bool_t isSigma1) const
+{
+	Double_t distCenterSource = TMath::Sqrt(theta*theta+offset*offset-2*theta*offset*TMath::Cos(phi+(TMath::Pi()/2)));
+	return EvaluatedNdOmega(distCenterSource,isSigma1);
+}
+
+//-----------------------------------------------
+// It evaluates the dNdOmega [~GeV, ~cm] (or the dNdOmegaSigma1) at theta [deg], with the cursors of context. Reentrant.
+Double_t JDAstroProfile::EvaluatedNdOmega(Double_t theta, JDEvalContext& context, Bool_t isSigma1) const
+{
+	if(isSigma1)	return context.Interpolate(gdNdOmegaSigma1,theta,JDEvalContext::kCursordNdOmegaSigma1);
+	else			return context.Interpolate(gdNdOmega,theta,JDEvalContext::kCursordNdOmega);
+}
+
+//-----------------------------------------------
+// As EvaluatedNdOmegaOff(theta,phi,offset,isSigma1), with the cursors of context. Reentrant.
+Double_t JDAstroProfile::EvaluatedNdOmegaOff(Double_t theta, Double_t phi, Double_t offset, JDEvalContext& context, Bool_t isSigma1) const
+{
+	Double_t distCenterSource = TMath::Sqrt(theta*theta+offset*offset-2*theta*offset*TMath::Cos(phi+(TMath::Pi()/2)));
+	if(isSigma1)	return context.Interpolate(gdNdOmegaSigma1,distCenterSource,JDEvalContext::kCursordNdOmegaSigma1Off);
+	else			return context.Interpolate(gdNdOmega,distCenterSource,JDEvalContext::kCursordNdOmegaOff);
+}
+
+//-----------------------------------------------
+// It integrates the dNdOmega (or the dNdOmegaSigma1) over the disk of radius theta [deg] around the source: N(Delta Omega) [#].
+// Reentrant: fixed quadrature (see JDQuadrature) in panels of dBinResolution.
+Double_t JDAstroProfile::EvaluateIntegratedNdOmega(Double_t theta, Bool_t isSigma1) const
+{
+	JDEvalContext context;
+	return EvaluateIntegratedNdOmega(theta,context,isSigma1);
+}
+
+//-----------------------------------------------
+// As EvaluateIntegratedNdOmega(theta,isSigma1), with the cursors of context. Reentrant.
+Double_t JDAstroProfile::EvaluateIntegratedNdOmega(Double_t theta, JDEvalContext& context, Bool_t isSigma1) const
+{
+	return JDQuadrature::IntegrateDisk([this,&context,isSigma1](Double_t thetaNode, Double_t phi)
+	{
+		return EvaluatedNdOmega(thetaNode,context,isSigma1);
+	},theta,dBinResolution,bIsSphericalCoordinates);
+}
+
+//-----------------------------------------------
+// It integrates the dNdOmega (or the dNdOmegaSigma1) over the disk of radius theta [deg] around an OFF region at offset [deg]
+// from the source: N_OFF(Delta Omega) [#]. Reentrant: fixed quadrature (see JDQuadrature) in panels of dBinResolution.
+Double_t JDAstroProfile::EvaluateIntegratedNdOmegaOff(Double_t theta, Double_t offset, Bool_t isSigma1) const
+{
+	JDEvalContext context;
+	return EvaluateIntegratedNdOmegaOff(theta,offset,context,isSigma1);
+}
+
+//-----------------------------------------------
+// As EvaluateIntegratedNdOmegaOff(theta,offset,isSigma1), with the cursors of context. Reentrant.
+Double_t JDAstroProfile::EvaluateIntegratedNdOmegaOff(Double_t theta, Double_t offset, JDEvalContext& context, Bool_t isSigma1) const
+{
+	return JDQuadrature::IntegrateDisk([this,offset,&context,isSigma1](Double_t thetaNode, Double_t phi)
+	{
+		return EvaluatedNdOmegaOff(thetaNode,phi,offset,context,isSigma1);
+	},theta,dBinResolution,bIsSphericalCoordinates);
+}
+
 //-----------------------------------------------
 // It integrates the dNdOmega [# · deg^{-2}] vs Theta [deg] and Phi [rad] multiplied by Theta [deg] in order to obtain the N(Delta Omega) [#]
 //
 // x[0] 	= dTheta [deg]
 Double_t JDAstroProfile::IntegratedNdOmegaThetaVsTheta(Double_t* x, Double_t* par)
 {
-	return fdNdOmegaThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	return EvaluateIntegratedNdOmega(x[0]);
 }
 
 //-----------------------------------------------
@@ -161,7 +234,7 @@ Double_t JDAstroProfile::IntegratedNdOmegaThetaVsTheta(Double_t* x, Double_t* pa
 // x[0] 	= dTheta [deg]
 Double_t JDAstroProfile::IntegratedNdOmegaSigma1ThetaVsTheta(Double_t* x, Double_t* par)
 {
-	return fdNdOmegaSigma1ThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	return EvaluateIntegratedNdOmega(x[0],1);
 }
 
 //-----------------------------------------------
@@ -171,8 +244,7 @@ Double_t JDAstroProfile::IntegratedNdOmegaSigma1ThetaVsTheta(Double_t* x, Double
 // par[0] 	= offset distance [deg]
 Double_t JDAstroProfile::IntegratedNdOmegaOffThetaVsTheta(Double_t* x, Double_t* par)
 {
-	fdNdOmegaOffThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaOffThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	return EvaluateIntegratedNdOmegaOff(x[0],par[0]);
 }
 
 //-----------------------------------------------
@@ -182,8 +254,7 @@ Double_t JDAstroProfile::IntegratedNdOmegaOffThetaVsTheta(Double_t* x, Double_t*
 // par[0] 	= offset distance [deg]
 Double_t JDAstroProfile::IntegratedNdOmegaSigma1OffThetaVsTheta(Double_t* x, Double_t* par)
 {
-	fdNdOmegaSigma1OffThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1OffThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	return EvaluateIntegratedNdOmegaOff(x[0],par[0],1);
 }
 
 //----------------------------------------------------
@@ -192,7 +263,7 @@ Double_t JDAstroProfile::IntegratedNdOmegaSigma1OffThetaVsTheta(Double_t* x, Dou
 // 	x[0]		= theta	[deg]
 Double_t JDAstroProfile::dNdOmegaVsTheta(Double_t* x, Double_t* par)
 {
-	return gdNdOmega->Eval(x[0]);
+	return EvaluatedNdOmega(x[0]);
 }
 
 //----------------------------------------------------
@@ -201,7 +272,7 @@ Double_t JDAstroProfile::dNdOmegaVsTheta(Double_t* x, Double_t* par)
 // 	x[0]		= theta	[deg]
 Double_t JDAstroProfile::dNdOmegaSigma1VsTheta(Double_t* x, Double_t* par)
 {
-	return gdNdOmegaSigma1->Eval(x[0]);
+	return EvaluatedNdOmega(x[0],1);
 }
 
 //----------------------------------------------------
@@ -259,16 +330,7 @@ Double_t JDAstroProfile::dNdOmegaSigma1ThetaVsThetaPhi(Double_t* x, Double_t* pa
 // distFromHalo = distance from the center of the halo [deg] (Calculated from the law of cosines)
 Double_t JDAstroProfile::dNdOmegaOffVsThetaPhi(Double_t* x, Double_t* par)
 {
-	Double_t distCenterSource = TMath::Sqrt(x[0]*x[0]+par[0]*par[0]-2*x[0]*par[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
-
-	if (GetIsSphericalCoordinates()==1)
-	{
-		return fdNdOmegaVsTheta->Eval(distCenterSource);
-	}
-	else
-	{
-		return fdNdOmegaVsTheta->Eval(distCenterSource);
-	}
+	return EvaluatedNdOmegaOff(x[0],x[1],par[0]);
 }
 
 //----------------------------------------------------
@@ -281,16 +343,7 @@ Double_t JDAstroProfile::dNdOmegaOffVsThetaPhi(Double_t* x, Double_t* par)
 // distFromHalo = distance from the center of the halo [deg] (Calculated from the law of cosines)
 Double_t JDAstroProfile::dNdOmegaSigma1OffVsThetaPhi(Double_t* x, Double_t* par)
 {
-	Double_t distCenterSource = TMath::Sqrt(x[0]*x[0]+par[0]*par[0]-2*x[0]*par[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
-
-	if (GetIsSphericalCoordinates()==1)
-	{
-		return fdNdOmegaSigma1VsTheta->Eval(distCenterSource);
-	}
-	else
-	{
-		return fdNdOmegaSigma1VsTheta->Eval(distCenterSource);
-	}
+	return EvaluatedNdOmegaOff(x[0],x[1],par[0],1);
 }
 
 //----------------------------------------------------
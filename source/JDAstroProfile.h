@@ -16,6 +16,8 @@
 
 using namespace std;
 
+class JDEvalContext;
+
 class JDAstroProfile {
 public:
 
@@ -120,6 +122,21 @@ public:
 	}
 
 
+	///////////////////////////////////////////////////////
+	//Reentrant evaluation: const, with the offset as an argument and without touching any TF1/TF2,
+	//so many threads can call them at the same time. isSigma1 selects the dNdOmegaSigma1.
+	//The versions with a JDEvalContext (one per thread) walk the TGraphs with its cursors.
+	///////////////////////////////////////////////////////
+	Double_t EvaluatedNdOmega(Double_t theta, Bool_t isSigma1=0) const;
+	Double_t EvaluatedNdOmegaOff(Double_t theta, Double_t phi, Double_t offset, Bool_t isSigma1=0) const;
+	Double_t EvaluateIntegratedNdOmega(Double_t theta, Bool_t isSigma1=0) const;
+	Double_t EvaluateIntegratedNdOmegaOff(Double_t theta, Double_t offset, Bool_t isSigma1=0) const;
+	Double_t EvaluatedNdOmega(Double_t theta, JDEvalContext& context, Bool_t isSigma1=0) const;
+	Double_t EvaluatedNdOmegaOff(Double_t theta, Double_t phi, Double_t offset, JDEvalContext& context, Bool_t isSigma1=0) const;
+	Double_t EvaluateIntegratedNdOmega(Double_t theta, JDEvalContext& context, Bool_t isSigma1=0) const;
+	Double_t EvaluateIntegratedNdOmegaOff(Double_t theta, Double_t offset, JDEvalContext& context, Bool_t isSigma1=0) const;
+
+
 	///////////////////////////////////////////////////////
 	//Double_t
 	///////////////////////////////////////////////////////
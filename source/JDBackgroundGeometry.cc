@@ -0,0 +1,98 @@
+/*
+ * JDBackgroundGeometry.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 GEOMETRY OF THE BACKGROUND ESTIMATION: N WOBBLE POINTINGS WITH M REFLECTED OFF REGIONS EACH.
+ */
+
+#include "JDBackgroundGeometry.h"
+
+#include <TMath.h>
+
+#include <iostream>
+
+using namespace std;
+
+//-----------------------------------------------
+//	numWobbles pointings with numOffRegions (1..kMaxNumOffRegions) reflected OFF regions each.
+//	Values out of range are clamped.
+JDBackgroundGeometry::JDBackgroundGeometry(Int_t numWobbles, Int_t numOffRegions):
+iNumWobbles(numWobbles), iNumOffRegions(numOffRegions)
+{
+	if(iNumWobbles<1 || iNumOffRegions<1 || iNumOffRegions>kMaxNumOffRegions)
+	{
+		cout << "   ************************************************" << endl;
+		cout << "   ***                                          ***" << endl;
+		cout << "   ***  WARNING:                                ***" << endl;
+		cout << "   ***  Background geometry out of range:       ***" << endl;
+		cout << "   ***  at least 1 wobble and 1 to " << TString::Format("%2d",kMaxNumOffRegions) << " OFF       ***" << endl;
+		cout << "   ***  regions                                 ***" << endl;
+		cout << "   ***                                          ***" << endl;
+		cout << "   ************************************************" << endl;
+		iNumWobbles = TMath::Max(iNumWobbles,1);
+		iNumOffRegions = TMath::Min(TMath::Max(iNumOffRegions,1),(Int_t)kMaxNumOffRegions);
+	}
+}
+
+//-----------------------------------------------
+//	Factor of the QFactor from the variance of the background estimated in the OFF regions: 1/Sqrt(1+alpha).
+//	The number of pointings does not scale it: they share the same observation time.
+Double_t JDBackgroundGeometry::GetQFactorScale() const
+{
+	return 1./TMath::Sqrt(1.+GetAlpha());
+}
+
+//-----------------------------------------------
+//	Position angle [rad] of the OFF region around the camera center, from the source
+Double_t JDBackgroundGeometry::GetOffRegionAngle(Int_t region) const
+{
+	return 2*TMath::Pi()*(region+1)/(iNumOffRegions+1);
+}
+
+//-----------------------------------------------
+//	Distance between the OFF region and the source, in units of the wobble distance
+Double_t JDBackgroundGeometry::GetOffRegionDistance(Int_t region) const
+{
+	// exactly 2 for the single OFF region
+	if(2*(region+1)==iNumOffRegions+1) return 2.;
+	return 2*TMath::Sin(0.5*GetOffRegionAngle(region));
+}
+
+//-----------------------------------------------
+//	Angle [rad] at the OFF region between the directions to the camera center and to the source
+//	(0 for the single OFF region: both are on the same line). The mirror images have opposite tilts.
+Double_t JDBackgroundGeometry::GetOffRegionTilt(Int_t region) const
+{
+	if(2*(region+1)==iNumOffRegions+1) return 0.;
+	Double_t angle = GetOffRegionAngle(region);
+	if(angle<=TMath::Pi())	return 0.5*(TMath::Pi()-angle);
+	else					return -0.5*(angle-TMath::Pi());
+}
+
+//-----------------------------------------------
+//	alpha times the number of OFF regions at the distance of this distinct region (itself and its mirror image)
+Double_t JDBackgroundGeometry::GetDistinctOffRegionWeight(Int_t region) const
+{
+	Int_t mirror = iNumOffRegions-1-region;
+	return GetAlpha()*(mirror!=region? 2 : 1);
+}
+
+//-----------------------------------------------
+//	Everything the QFactor depends on (see JDOptimization::GetConfiguration())
+TString JDBackgroundGeometry::GetConfiguration() const
+{
+	return TString::Format("wobbles=%d offRegions=%d",iNumWobbles,iNumOffRegions);
+}
+
+//-----------------------------------------------
+//	It prints the OFF regions of a pointing
+void JDBackgroundGeometry::Print() const
+{
+	cout << "   JDBackgroundGeometry: " << iNumWobbles << " wobble pointings, " << iNumOffRegions << " OFF regions each (alpha=" << GetAlpha() << ")" << endl;
+	for(Int_t k=0; k<iNumOffRegions; k++)
+	{
+		cout << "      OFF " << k+1 << ": position angle " << GetOffRegionAngle(k)*180./TMath::Pi() << " deg, distance to the source "
+			 << GetOffRegionDistance(k) << " x wobble, tilt " << GetOffRegionTilt(k)*180./TMath::Pi() << " deg" << endl;
+	}
+}
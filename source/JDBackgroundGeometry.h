@@ -0,0 +1,59 @@
+/*
+ * JDBackgroundGeometry.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 GEOMETRY OF THE BACKGROUND ESTIMATION: N WOBBLE POINTINGS WITH M REFLECTED OFF REGIONS EACH.
+ *  		 IN EACH POINTING THE SOURCE IS AT THE WOBBLE DISTANCE w FROM THE CAMERA CENTER, AND THE OFF REGIONS ARE ON THE
+ *  		 SAME CIRCLE, AT POSITION ANGLES 2pi·k/(M+1) (k=1..M) FROM THE SOURCE. THE OFF REGION k IS AT
+ *  		 	d_k = 2w·sin(pi·k/(M+1))
+ *  		 FROM THE SOURCE, AND SEES THE CAMERA CENTER AND THE SOURCE SEPARATED BY THE TILT (pi-2pi·k/(M+1))/2.
+ *  		 M=1 IS THE SINGLE OFF REGION AT 2w OPPOSITE TO THE SOURCE.
+ *  		 THE LEAKAGE IS alpha·SUM OF THE OFF INTEGRALS, WITH alpha=1/M. THE REGIONS k AND M+1-k ARE MIRROR IMAGES
+ *  		 AND HAVE THE SAME INTEGRALS, SO ONLY THE (M+1)/2 DISTINCT ONES ARE INTEGRATED (SEE JDQFactorKernel).
+ *  		 THE BACKGROUND OF THE ON REGION IS alpha TIMES THE COUNTS OF THE OFF REGIONS, SO THE VARIANCE OF THE EXCESS IS
+ *  		 (1+alpha) TIMES THE ONE OF THE BACKGROUND: THE NOISE OF THE QFACTOR IS Sqrt((1+alpha)·ACC) (SEE
+ *  		 GetQFactorScale()): 1/Sqrt(2) OF THE QFACTOR WITH A KNOWN BACKGROUND FOR M=1, TOWARD 1 AS M GROWS, WHILE THE
+ *  		 CLOSER OFF REGIONS OF A LARGER M HAVE MORE LEAKAGE.
+ *  		 THE PROFILE IS SYMMETRIC AROUND THE SOURCE AND THE ACCEPTANCE AROUND THE CAMERA CENTER, SO ALL THE POINTINGS
+ *  		 (SAME w, ANY POSITION ANGLE) HAVE THE SAME INTEGRALS. THE TOTAL OBSERVATION TIME IS FIXED AND SPLIT BETWEEN THE
+ *  		 N POINTINGS, SO N DOES NOT CHANGE THE QFACTOR NOR ITS OPTIMUM: ONLY A LONGER OBSERVATION WOULD SCALE IT, AND THE
+ *  		 QFACTORS ARE PER UNIT OF OBSERVATION TIME.
+ */
+
+#ifndef JDBackgroundGeometry_H_
+#define JDBackgroundGeometry_H_
+
+#include <Rtypes.h>
+#include <TString.h>
+
+class JDBackgroundGeometry {
+public:
+	static const Int_t kMaxNumOffRegions = 15;
+
+	JDBackgroundGeometry(Int_t numWobbles=1, Int_t numOffRegions=1);
+	virtual ~JDBackgroundGeometry() {}
+
+	Int_t GetNumWobbles() const					{return iNumWobbles;}
+	Int_t GetNumOffRegions() const				{return iNumOffRegions;}
+	Double_t GetAlpha() const					{return 1./iNumOffRegions;}
+	Double_t GetQFactorScale() const;
+
+	// OFF region (0..M-1) of a pointing
+	Double_t GetOffRegionAngle(Int_t region) const;
+	Double_t GetOffRegionDistance(Int_t region) const;
+	Double_t GetOffRegionTilt(Int_t region) const;
+
+	// OFF regions at different distances: region (0..(M+1)/2-1) and its mirror image, with alpha times their number
+	Int_t GetNumDistinctOffRegions() const		{return (iNumOffRegions+1)/2;}
+	Double_t GetDistinctOffRegionWeight(Int_t region) const;
+
+	TString GetConfiguration() const;
+	void Print() const;
+
+private:
+	Int_t iNumWobbles;
+	Int_t iNumOffRegions;
+};
+
+#endif /* JDBackgroundGeometry_H_ */
@@ -0,0 +1,91 @@
+/*
+ * JDBoundedQueue.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 FIFO QUEUE BETWEEN THE THREADS OF TWO STAGES OF A PIPELINE (SEE JDCampaign::SetIsPipelined()).
+ *  		 Push() WAITS WHILE THE QUEUE IS FULL, SO A FAST STAGE CAN NOT GET MORE THAN capacity ITEMS AHEAD OF
+ *  		 THE NEXT ONE (IT CAPS THE MEMORY OF THE ITEMS WAITING), AND Pop() WAITS WHILE IT IS EMPTY.
+ *  		 Close() TELLS THE CONSUMERS THAT NOTHING ELSE WILL BE PUSHED: Pop() RETURNS 0 ONCE THE QUEUE IS EMPTY.
+ */
+
+#ifndef JDBoundedQueue_H_
+#define JDBoundedQueue_H_
+
+#include <Rtypes.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+template <typename T>
+class JDBoundedQueue {
+public:
+	// capacity<=0: no limit
+	JDBoundedQueue(Int_t capacity): iCapacity(capacity), iMaxSize(0), bIsClosed(0) {}
+
+	//-----------------------------------------------
+	//	It adds item at the end, waiting while the queue is full. It returns 0 (without adding it) if the queue is closed.
+	Bool_t Push(const T& item)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		cvNotFull.wait(lock,[this]{return bIsClosed || iCapacity<=0 || (Int_t)dItems.size()<iCapacity;});
+		if(bIsClosed) return 0;
+		dItems.push_back(item);
+		if((Int_t)dItems.size()>iMaxSize) iMaxSize=dItems.size();
+		cvNotEmpty.notify_one();
+		return 1;
+	}
+
+	//-----------------------------------------------
+	//	It takes the first item, waiting while the queue is empty. It returns 0 if it is empty and closed.
+	Bool_t Pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		cvNotEmpty.wait(lock,[this]{return bIsClosed || !dItems.empty();});
+		return TakeFront(item);
+	}
+
+	//-----------------------------------------------
+	//	It takes the first item if there is one, without waiting
+	Bool_t TryPop(T& item)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return TakeFront(item);
+	}
+
+	//-----------------------------------------------
+	//	No more items will be pushed: the consumers waiting in Pop() are woken up
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		bIsClosed = 1;
+		cvNotEmpty.notify_all();
+		cvNotFull.notify_all();
+	}
+
+	Int_t GetCapacity() const					{return iCapacity;}
+	// Largest number of items that have been waiting at the same time
+	Int_t GetMaxSize()							{std::lock_guard<std::mutex> lock(mMutex); return iMaxSize;}
+
+private:
+	Bool_t TakeFront(T& item)
+	{
+		if(dItems.empty()) return 0;
+		item = dItems.front();
+		dItems.pop_front();
+		cvNotFull.notify_one();
+		return 1;
+	}
+
+	Int_t iCapacity;
+	Int_t iMaxSize;
+	Bool_t bIsClosed;
+	std::deque<T> dItems;
+
+	std::mutex mMutex;
+	std::condition_variable cvNotFull;
+	std::condition_variable cvNotEmpty;
+};
+
+#endif /* JDBoundedQueue_H_ */
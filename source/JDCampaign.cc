@@ -0,0 +1,1148 @@
+/*
+ * JDCampaign.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 CAMPAIGN OF OPTIMIZATIONS: OPTIMAL THETA AND WOBBLE FOR EVERY SOURCE x CANDIDATE x INSTRUMENT x QFACTOR TYPE.
+ */
+
+#include "JDCampaign.h"
+#include "JDBoundedQueue.h"
+#include "JDQFactorKernel.h"
+#include "JDTaskScheduler.h"
+
+#include <TStopwatch.h>
+#include <TSystem.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef JD_WITH_MPI
+#include <mpi.h>
+#endif
+
+using namespace std;
+
+//-----------------------------------------------
+//	The sources are read from mySourcePath/references/JFactor and the instruments from myInstrumentPath/references/IACTPerformance
+//	(as in JDOptimization). By default the jobs run on one thread per hardware thread, in kGridScan with tolerance 0.30.
+JDCampaign::JDCampaign(TString mySourcePath, TString myInstrumentPath):
+sMySourcePath(mySourcePath), sMyInstrumentPath(myInstrumentPath),
+iNumThreads(0), bIsPipelined(0), iPipelineCapacity(4), fJobCallback(NULL), cancelToken(NULL), bIsCancelled(0), resultBuffers(NULL), bIsProgressStopping(0), bIsResumed(0), iNumJobsResumed(0), dCheckpointInterval(60.), iShard(0), iNumShards(1), sStorePath(""), iOptimizationMode(JDOptimization::kGridScan), dTolerance(0.30),
+dRealTime(0.), dUtilization(0.), dSetupTime(0.), iMaxQueuedJobs(0)
+{
+}
+
+//-----------------------------------------------
+//	It deletes the jobs and then the objects they shared
+JDCampaign::~JDCampaign()
+{
+	ClearJobs();
+	for(std::map<TString, JDDarkMatter*>::iterator it=mapDarkMatter.begin(); it!=mapDarkMatter.end(); it++)	delete it->second;
+	for(std::map<Int_t, JDInstrument*>::iterator it=mapInstrument.begin(); it!=mapInstrument.end(); it++)		delete it->second;
+}
+
+//-----------------------------------------------
+//	It adds the source (dark matter halo) of this author ("Bonnivard" or "Geringer")
+void JDCampaign::AddSource(TString author, TString source)
+{
+	vAuthors.push_back(author);
+	vSources.push_back(source);
+}
+
+//-----------------------------------------------
+//	It adds every source of this author ("Bonnivard" or "Geringer") found in the references directory.
+//	It returns the number of sources added.
+Int_t JDCampaign::AddSourcesFromReferences(TString author)
+{
+	TString directory, prefix, suffix;
+	if(author=="Bonnivard")
+	{
+		directory = sMySourcePath+"/references/JFactor/Bonnivard";
+		prefix = "";
+		suffix = "alphaint_cls_READ.output";				// <source>_Jalphaint... (annihilation) and <source>_Dalphaint... (decay)
+	}
+	else if(author=="Geringer")
+	{
+		directory = sMySourcePath+"/references/JFactor/GeringerSameth";
+		prefix = "GeringerSamethTable_";
+		suffix = ".txt";
+	}
+	else
+	{
+		cout << "   ***************************************" << endl;
+		cout << "   ***                                 ***" << endl;
+		cout << "   ***  ERROR: author not valid        ***" << endl;
+		cout << "   ***  (it is Bonnivard or Geringer)  ***" << endl;
+		cout << "   ***                                 ***" << endl;
+		cout << "   ***************************************" << endl;
+		return 0;
+	}
+
+	void* dir = gSystem->OpenDirectory(directory);
+	if(!dir)
+	{
+		cout << "   ERROR: the references directory " << directory << " could not be opened" << endl;
+		return 0;
+	}
+
+	std::vector<TString> sources;
+	while(const char* entry = gSystem->GetDirEntry(dir))
+	{
+		TString name = entry;
+		if(!name.BeginsWith(prefix) || !name.EndsWith(suffix)) continue;
+
+		TString source = name(prefix.Length(),name.Length()-prefix.Length()-suffix.Length());
+		if(author=="Bonnivard") source = source(0,source.Length()-2);			// "_J" or "_D"
+		if(source.Length()>0 && std::find(sources.begin(),sources.end(),source)==sources.end()) sources.push_back(source);
+	}
+	gSystem->FreeDirectory(dir);
+
+	// the order of the directory is not defined
+	std::sort(sources.begin(),sources.end());
+	for(UInt_t s=0; s<sources.size(); s++) AddSource(author,sources[s]);
+	return sources.size();
+}
+
+//-----------------------------------------------
+//	It adds the instrument (see JDOptimization) with its maximum distance to the camera center and its wobble distance [deg]
+void JDCampaign::AddInstrument(TString instrumentName, Double_t distCameraCenter, Double_t wobble)
+{
+	vInstrumentNames.push_back(instrumentName);
+	vDistCameraCenters.push_back(distCameraCenter);
+	vWobbles.push_back(wobble);
+}
+
+//-----------------------------------------------
+//	It makes this process run only the shard of the matrix (see Run()). The cells (source, candidate, instrument), in the
+//	order of the results table, are split in numShards contiguous ranges of (almost) the same size.
+void JDCampaign::SetShard(Int_t shard, Int_t numShards)
+{
+	if(numShards<1 || shard<0 || shard>=numShards)
+	{
+		cout << "   ***************************************************" << endl;
+		cout << "   ***                                             ***" << endl;
+		cout << "   ***  WARNING:                                   ***" << endl;
+		cout << "   ***  Shard not valid (0 <= shard < numShards)   ***" << endl;
+		cout << "   ***  The whole matrix is run                    ***" << endl;
+		cout << "   ***                                             ***" << endl;
+		cout << "   ***************************************************" << endl;
+		shard = 0;
+		numShards = 1;
+	}
+	iShard = shard;
+	iNumShards = numShards;
+}
+
+//-----------------------------------------------
+//	It returns the partial table of this shard of resultsFile (resultsFile itself if there is only one shard)
+TString JDCampaign::GetShardFile(TString resultsFile, Int_t shard, Int_t numShards)
+{
+	if(numShards<=1) return resultsFile;
+	return TString::Format("%s.shard%dof%d",resultsFile.Data(),shard,numShards);
+}
+
+//-----------------------------------------------
+//	It returns the file where Run() writes the jobs of resultsFile as they end (see WriteProgress())
+TString JDCampaign::GetProgressFile(TString resultsFile)
+{
+	return resultsFile+".progress";
+}
+
+//-----------------------------------------------
+//	It returns the file of the JFactor of this source and candidate in the references
+TString JDCampaign::GetReferenceFile(Int_t source, Int_t candidate)
+{
+	if(vAuthors[source]=="Bonnivard")
+		return sMySourcePath+"/references/JFactor/Bonnivard/"+vSources[source]+(vCandidates[candidate]=="Decay"? "_Dalphaint_cls_READ.output" : "_Jalphaint_cls_READ.output");
+	return sMySourcePath+"/references/JFactor/GeringerSameth/GeringerSamethTable_"+vSources[source]+".txt";
+}
+
+//-----------------------------------------------
+//	It returns the dark matter halo of this source and candidate, loaded the first time it is asked.
+//	It returns NULL if it can not be loaded.
+JDDarkMatter* JDCampaign::GetDarkMatter(Int_t source, Int_t candidate)
+{
+	TString key = vAuthors[source]+"/"+vSources[source]+"/"+vCandidates[candidate];
+	std::map<TString, JDDarkMatter*>::iterator it = mapDarkMatter.find(key);
+	if(it!=mapDarkMatter.end()) return it->second;
+
+	JDDarkMatter* darkMatter = NULL;
+	if((vCandidates[candidate]=="Annihilation" || vCandidates[candidate]=="Decay") && !gSystem->AccessPathName(GetReferenceFile(source,candidate)))
+	{
+		darkMatter = new JDDarkMatter(vAuthors[source],vSources[source],vCandidates[candidate],sMySourcePath);
+		if(!darkMatter->GetIsJFactor())
+		{
+			delete darkMatter;
+			darkMatter = NULL;
+		}
+	}
+	mapDarkMatter[key] = darkMatter;
+	return darkMatter;
+}
+
+//-----------------------------------------------
+//	It returns the instrument, loaded the first time it is asked. It returns NULL if it is not valid.
+JDInstrument* JDCampaign::GetInstrument(Int_t instrument)
+{
+	std::map<Int_t, JDInstrument*>::iterator it = mapInstrument.find(instrument);
+	if(it!=mapInstrument.end()) return it->second;
+
+	TString name = vInstrumentNames[instrument];
+	JDInstrument* jdInstrument = NULL;
+	if(name=="IDEAL")
+	{
+		jdInstrument = new JDInstrument(vDistCameraCenters[instrument],vWobbles[instrument],name);
+	}
+	else if(name=="MAGICPointLike" || name=="Sensitivity" || name=="CTANorth50To80GeV")
+	{
+		jdInstrument = new JDInstrument(name,vWobbles[instrument],sMyInstrumentPath);
+		if(!jdInstrument->GetIsCameraAcceptance())
+		{
+			delete jdInstrument;
+			jdInstrument = NULL;
+		}
+	}
+	mapInstrument[instrument] = jdInstrument;
+	return jdInstrument;
+}
+
+//-----------------------------------------------
+//	It deletes the JDOptimization of the jobs (the shared objects are kept for the next Run())
+void JDCampaign::ClearJobs()
+{
+	for(UInt_t j=0; j<vJobs.size(); j++) delete vJobs[j].optimization;
+	vJobs.clear();
+	vSkipped.clear();
+	iNumJobsResumed = 0;
+}
+
+//-----------------------------------------------
+//	Serial step of Run(): it loads the shared objects and creates one job for each source, candidate and instrument
+//	of the shard (see SetShard()). Only the halos of the shard are loaded, but all the instruments are checked, so that
+//	every shard lists the same skipped instruments.
+//	Each job has its own JDOptimization (one thread: the parallelism is over the jobs) with its kernels already sampled.
+//	jobCreated (if any) is called with each job as soon as it is created (see RunPipeline()): the room for all the jobs
+//	is reserved first, so that the jobs do not move while others are being created.
+//	The jobs done by the Run() resumed (see ReadProgress()) are created with their results, without loading their halo
+//	if none of its jobs is left, and they are not given to jobCreated.
+Bool_t JDCampaign::CreateJobs(const std::function<void(Job*)>& jobCreated)
+{
+	ClearJobs();
+
+	for(UInt_t t=0; t<vTypes.size(); t++)
+	{
+		if(JDQFactorKernel::GetEffects(vTypes[t])<0)
+		{
+			cout << "   ERROR: QFactor type " << vTypes[t] << " not valid" << endl;
+			return 0;
+		}
+	}
+
+	std::vector<JDInstrument*> instruments(vInstrumentNames.size());
+	for(UInt_t i=0; i<instruments.size(); i++)
+	{
+		instruments[i] = GetInstrument(i);
+		if(!instruments[i]) vSkipped.push_back(vInstrumentNames[i]);
+	}
+
+	// cell = (source·numCandidates+candidate)·numInstruments+instrument, as the lines of the results table
+	Int_t numInstruments = instruments.size();
+	Int_t firstCell = (Long64_t)GetNumCells()*iShard/iNumShards;
+	Int_t endCell = (Long64_t)GetNumCells()*(iShard+1)/iNumShards;
+	vJobs.reserve(endCell-firstCell);
+
+	for(UInt_t s=0; s<vSources.size(); s++)
+	{
+		for(UInt_t c=0; c<vCandidates.size(); c++)
+		{
+			Int_t cell0 = (s*vCandidates.size()+c)*numInstruments;
+			if(iNumShards>1 && (cell0+numInstruments<=firstCell || cell0>=endCell)) continue;
+
+			// the halo is not loaded if all its jobs are resumed
+			Bool_t isHaloResumed = 0;
+			Job resumedJob;
+			for(UInt_t i=0; i<instruments.size(); i++)
+			{
+				if(!instruments[i] || cell0+(Int_t)i<firstCell || cell0+(Int_t)i>=endCell) continue;
+				isHaloResumed = GetResumedJob(s,c,i,resumedJob);
+				if(!isHaloResumed) break;
+			}
+
+			JDDarkMatter* darkMatter = (isHaloResumed? NULL : GetDarkMatter(s,c));
+			if(!isHaloResumed && !darkMatter)
+			{
+				vSkipped.push_back(vAuthors[s]+"/"+vSources[s]+"/"+vCandidates[c]);
+				continue;
+			}
+
+			for(UInt_t i=0; i<instruments.size(); i++)
+			{
+				JDInstrument* instrument = instruments[i];
+				if(!instrument) continue;
+				if(cell0+(Int_t)i<firstCell || cell0+(Int_t)i>=endCell) continue;
+				if(GetResumedJob(s,c,i,resumedJob))
+				{
+					vJobs.push_back(resumedJob);
+					iNumJobsResumed++;
+					continue;
+				}
+				if(IsCancelled()) return vJobs.size()>0;
+
+				vJobs.push_back(CreateJob(s,c,i,darkMatter,instrument));
+				if(jobCreated) jobCreated(&vJobs.back());
+			}
+		}
+	}
+	return vJobs.size()>0;
+}
+
+//-----------------------------------------------
+//	It creates the job of this source, candidate and instrument (with their objects already loaded): its own JDOptimization,
+//	on one thread, with the kernels of all the types sampled, and not verbose (the jobs run at the same time).
+//	It touches ROOT objects, so it must be called serially.
+JDCampaign::Job JDCampaign::CreateJob(Int_t source, Int_t candidate, Int_t instrument, JDDarkMatter* darkMatter, JDInstrument* jdInstrument)
+{
+	Job job;
+	job.iSource = source;
+	job.iCandidate = candidate;
+	job.iInstrument = instrument;
+	job.bIsResumed = 0;
+	job.optimization = new JDOptimization(darkMatter,jdInstrument);
+	job.optimization->SetNumThreads(1);
+	job.optimization->SetSurfaceStore(sStorePath);
+	job.optimization->SetCheckpointInterval(dCheckpointInterval);
+	job.optimization->SetOptimizationMode(iOptimizationMode);
+	job.optimization->SetTolerance(dTolerance);
+	job.optimization->SetIsVerbose(0);
+	for(UInt_t t=0; t<vTypes.size(); t++) job.optimization->PrepareQFactorKernel(vTypes[t]);
+
+	// bins x panels per bin of the grids
+	Double_t thetaMax = darkMatter->GetThetaMax();
+	job.dCost = thetaMax*thetaMax*jdInstrument->GetDistCameraCenterMax()*vTypes.size();
+	job.dRealTime = 0.;
+	job.vIsDone.assign(vTypes.size(),0);
+	job.vOptimum.assign(vTypes.size()*JDSurfaceStore::kNumOptimumValues,0.);
+	return job;
+}
+
+//-----------------------------------------------
+//	It sets job to the job of this source, candidate and instrument done by the Run() resumed, with the results of all
+//	the types read from its progress file (see ReadProgress()). It returns 0 if any type of the job is not there.
+Bool_t JDCampaign::GetResumedJob(Int_t source, Int_t candidate, Int_t instrument, Job& job)
+{
+	if(mapResumed.size()==0) return 0;
+
+	TString cell = TString::Format("%d %d %d",source,candidate,instrument);
+	std::vector<Double_t> optima(vTypes.size()*JDSurfaceStore::kNumOptimumValues);
+	Double_t realTime = 0.;
+	for(UInt_t t=0; t<vTypes.size(); t++)
+	{
+		std::map<TString, std::vector<Double_t> >::iterator it = mapResumed.find(cell+TString::Format(" %d",vTypes[t]));
+		if(it==mapResumed.end()) return 0;
+		std::copy(it->second.begin(),it->second.begin()+JDSurfaceStore::kNumOptimumValues,optima.begin()+t*JDSurfaceStore::kNumOptimumValues);
+		realTime = it->second[JDSurfaceStore::kNumOptimumValues];
+	}
+
+	job.iSource = source;
+	job.iCandidate = candidate;
+	job.iInstrument = instrument;
+	job.bIsResumed = 1;
+	job.optimization = NULL;
+	job.dCost = 0.;
+	job.dRealTime = realTime;
+	job.vIsDone.assign(vTypes.size(),1);
+	job.vOptimum = optima;
+	return 1;
+}
+
+//-----------------------------------------------
+//	Parallel step of Run(): it fills the grids of all the types of the job in one pass and finds their optimal points.
+//	It only touches the JDOptimization of the job.
+void JDCampaign::RunJob(Job& job)
+{
+	TStopwatch stopwatch;
+	stopwatch.Start();
+
+	if(iOptimizationMode==JDOptimization::kGridScan) job.optimization->FillGridsQFactorVsThetaWobble(vTypes);
+
+	for(UInt_t t=0; t<vTypes.size(); t++)
+	{
+		Double_t* optimum = &job.vOptimum[t*JDSurfaceStore::kNumOptimumValues];
+		optimum[0] = job.optimization->GetOptimalThetaAndWobble(optimum[1],optimum[2],optimum[3],optimum[4],optimum[5],optimum[6],vTypes[t]);
+		job.vIsDone[t] = 1;
+	}
+
+	stopwatch.Stop();
+	job.dRealTime = stopwatch.RealTime();
+}
+
+//-----------------------------------------------
+//	It returns the names and results of the job (see SetJobCallback())
+JDCampaign::JobResult JDCampaign::GetJobResult(const Job& job)
+{
+	JobResult result;
+	result.sAuthor = vAuthors[job.iSource];
+	result.sSource = vSources[job.iSource];
+	result.sCandidate = vCandidates[job.iCandidate];
+	result.sInstrumentName = vInstrumentNames[job.iInstrument];
+	result.dWobble = vWobbles[job.iInstrument];
+	result.dRealTime = job.dRealTime;
+	result.vTypes = vTypes;
+	result.vOptimum = job.vOptimum;
+	return result;
+}
+
+//-----------------------------------------------
+//	Jobs of the last Run() that have been run (all of them unless it was cancelled), the resumed ones included
+Int_t JDCampaign::GetNumJobsRun()
+{
+	Int_t numJobsRun = 0;
+	for(UInt_t j=0; j<vJobs.size(); j++) if(vJobs[j].vIsDone.size()>0 && vJobs[j].vIsDone[0]) numJobsRun++;
+	return numJobsRun;
+}
+
+//-----------------------------------------------
+//	Steps 1 and 2 of Run(), one after the other. The jobs run are written to progressFile as they end (see WriteProgress()).
+//	It returns 0 if there was no job to run.
+Bool_t JDCampaign::RunJobs(TString progressFile)
+{
+	// 1. everything that touches ROOT objects is done here, before going parallel
+	TStopwatch stopwatch;
+	stopwatch.Start();
+	Bool_t isJob = CreateJobs();
+	stopwatch.Stop();
+	dSetupTime = stopwatch.RealTime();
+	if(!isJob) return 0;
+
+	// 2. the costliest jobs first in each range, so that the ranges stolen are the long ones and the threads end together
+	std::vector<Int_t> order;
+	for(UInt_t j=0; j<vJobs.size(); j++) if(!vJobs[j].bIsResumed) order.push_back(j);
+	std::stable_sort(order.begin(),order.end(),[this](Int_t a, Int_t b){return vJobs[a].dCost>vJobs[b].dCost;});
+
+	stopwatch.Start();
+	{
+		JDTaskScheduler scheduler(iNumThreads);
+		StartProgressWriter(progressFile,scheduler.GetNumThreads());
+		scheduler.ParallelFor(order.size(),[&](Int_t j, Int_t thread)
+		{
+			if(IsCancelled()) return;
+			RunJob(vJobs[order[j]]);
+			resultBuffers->Push(thread,&vJobs[order[j]]);
+		});
+		StopProgressWriter();
+		dUtilization = scheduler.GetUtilization();
+	}
+	stopwatch.Stop();
+	dRealTime = stopwatch.RealTime();
+	return 1;
+}
+
+//-----------------------------------------------
+//	Steps 1 and 2 of Run(), overlapped. The stages are:
+//		setup:		the caller loads the halo and the instrument (the first time), derives and smears the tables of each
+//					job (see CreateJob()), in the order of the matrix. All of it touches ROOT objects, so it is serial.
+//		scan:		iNumThreads workers take the jobs set up and run them (see RunJob()), handing them to the writer
+//					thread of progressFile (see WriteProgress()) and back to the caller, without locks (see JDResultBuffers).
+//		release:	the caller gives the jobs scanned to the job callback (if any) and deletes their JDOptimization
+//					(ROOT objects too), keeping their results.
+//	The queue between setup and scan holds at most iPipelineCapacity jobs, so the setup waits if it gets too far
+//	ahead and the JDOptimization alive are at most those plus one per worker (not all the jobs, as in RunJobs()).
+//	It returns 0 if there was no job to run.
+Bool_t JDCampaign::RunPipeline(TString progressFile)
+{
+	Int_t numThreads = (iNumThreads>0? iNumThreads : JDTaskScheduler::GetDefaultNumThreads());
+	JDBoundedQueue<Job*> setUpJobs(iPipelineCapacity);
+	// a worker can not have more jobs to release than the jobs alive, so its ring is never full
+	JDResultBuffers<Job*> scannedJobs(numThreads,iPipelineCapacity+numThreads+1);
+	StartProgressWriter(progressFile,numThreads);
+
+	TStopwatch stopwatch;
+	stopwatch.Start();
+
+	// scan
+	const Int_t stride = kJDCacheLineSize/sizeof(Double_t);
+	JDAlignedBuffer busyTimes(numThreads*stride,0.);		// [s] one cache line per worker
+	std::vector<std::thread> workers;
+	for(Int_t thread=0; thread<numThreads; thread++)
+	{
+		workers.push_back(std::thread([&,thread]()
+		{
+			Job* job;
+			while(setUpJobs.Pop(job))
+			{
+				if(!IsCancelled())
+				{
+					RunJob(*job);
+					busyTimes[thread*stride] += job->dRealTime;
+					resultBuffers->Push(thread,job);
+				}
+				scannedJobs.Push(thread,job);
+			}
+		}));
+	}
+
+	// release
+	Int_t numPushed = 0;
+	Int_t numReleased = 0;
+	auto releaseJob = [&](Job* job)
+	{
+		Bool_t isRun = (job->vIsDone.size()>0 && job->vIsDone[0]);
+		if(isRun && fJobCallback && !bIsCancelled && !fJobCallback(GetJobResult(*job))) bIsCancelled = 1;
+		delete job->optimization;
+		job->optimization = NULL;
+		numReleased++;
+	};
+	auto releaseScannedJobs = [&]()
+	{
+		return scannedJobs.Drain(releaseJob);
+	};
+
+	// setup (the time waiting for room in the queue is not counted)
+	TStopwatch setupStopwatch;
+	setupStopwatch.Start();
+	Bool_t isJob = CreateJobs([&](Job* job)
+	{
+		setupStopwatch.Stop();
+		dSetupTime += setupStopwatch.RealTime();
+		setUpJobs.Push(job);
+		numPushed++;
+		releaseScannedJobs();
+		setupStopwatch.Start();
+	});
+	setupStopwatch.Stop();
+	dSetupTime += setupStopwatch.RealTime();
+
+	// the last jobs are released as they end
+	setUpJobs.Close();
+	while(numReleased<numPushed)
+	{
+		if(releaseScannedJobs()==0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+	for(UInt_t thread=0; thread<workers.size(); thread++) workers[thread].join();
+	StopProgressWriter();
+
+	stopwatch.Stop();
+	dRealTime = stopwatch.RealTime();
+	iMaxQueuedJobs = setUpJobs.GetMaxSize();
+
+	Double_t busyTime = 0.;
+	for(Int_t thread=0; thread<numThreads; thread++) busyTime += busyTimes[thread*stride];
+	dUtilization = (dRealTime>0.? busyTime/(numThreads*dRealTime) : 0.);
+	return isJob;
+}
+
+//-----------------------------------------------
+//	It runs the whole campaign (pipelined or not, see SetIsPipelined()) and writes the results in resultsFile
+//	(see WriteResults()). If it is cancelled, the table has the jobs run until then, and the progress file is kept
+//	to resume it (see SetIsResumed()). It returns 0 if there was no job to run.
+Bool_t JDCampaign::Run(TString resultsFile)
+{
+	TStopwatch stopwatchTotal;
+	stopwatchTotal.Start();
+	dRealTime = 0.;
+	dUtilization = 0.;
+	dSetupTime = 0.;
+	iMaxQueuedJobs = 0;
+	bIsCancelled = 0;
+
+	TString shardFile = GetShardFile(resultsFile,iShard,iNumShards);
+	TString progressFile = GetProgressFile(shardFile);
+	mapResumed.clear();
+	sResumedLines.clear();
+	if(bIsResumed) ReadProgress(progressFile);
+	Bool_t isJob = ((bIsPipelined || fJobCallback)? RunPipeline(progressFile) : RunJobs(progressFile));
+	bIsCancelled = IsCancelled();
+	if(!isJob)
+	{
+		// an empty shard still writes its partial table, for MergeResults()
+		gSystem->Unlink(progressFile);
+		if(iNumShards>1) WriteResults(shardFile);
+		cout << "   **********************************" << endl;
+		cout << "   ***                            ***" << endl;
+		cout << "   ***  WARNING:                  ***" << endl;
+		cout << "   ***  The campaign has no jobs  ***" << endl;
+		cout << "   ***                            ***" << endl;
+		cout << "   **********************************" << endl;
+		return 0;
+	}
+
+	// 3. one table with all the results (of the shard): the progress file is not needed any more if it is complete
+	Bool_t isWritten = WriteResults(shardFile);
+	if(isWritten && !bIsCancelled) gSystem->Unlink(progressFile);
+	stopwatchTotal.Stop();
+
+	cout << endl;
+	cout << "   ************************************************" << endl;
+	cout << "   ***" << endl;
+	cout << "   ***  Campaign: " << vJobs.size() << " jobs (" << vJobs.size()*vTypes.size() << " optimal points)" << endl;
+	if(iNumShards>1)
+		cout << "   ***  Shard " << iShard << " of " << iNumShards << " (" << GetNumCells() << " cells in the matrix)" << endl;
+	cout << "   ***  " << TString::Format("%.3f jobs/s (%.2f s running, %.2f s in total)",GetJobsPerSecond(),dRealTime,stopwatchTotal.RealTime()) << endl;
+	cout << "   ***  " << TString::Format("%.1f %% mean utilization of the threads",100.*dUtilization) << endl;
+	if(bIsPipelined)
+		cout << "   ***  " << TString::Format("pipelined: %.2f s setting up, at most %d of %d jobs waiting",dSetupTime,iMaxQueuedJobs,iPipelineCapacity) << endl;
+	else
+		cout << "   ***  " << TString::Format("%.2f s setting up",dSetupTime) << endl;
+	if(iNumJobsResumed>0)
+		cout << "   ***  Resumed: " << iNumJobsResumed << " jobs taken from " << progressFile << endl;
+	if(vSkipped.size()>0)
+		cout << "   ***  " << vSkipped.size() << " skipped (see " << resultsFile << ")" << endl;
+	if(bIsCancelled)
+		cout << "   ***  Cancelled: " << GetNumJobsRun() << " jobs run (resume it from " << progressFile << ")" << endl;
+	cout << "   ***  Results: " << shardFile << endl;
+	cout << "   ***" << endl;
+	cout << "   ************************************************" << endl;
+	cout << endl;
+
+	return isWritten;
+}
+
+//-----------------------------------------------
+//	It writes one line for each job and type, in the order of the matrix:
+//		author source candidate instrument wobble type qfactorMax thetaOpt thetaOptRangMin thetaOptRangMax wobbleOpt wobbleOptRangMin wobbleOptRangMax time
+//	with the angles in [deg] and the time of the job in [s]. The skipped sources and instruments are listed as comments.
+//	The table of a shard also has a comment with its range of cells (see MergeResults()), and the one of a cancelled
+//	run a comment saying that it is not complete.
+Bool_t JDCampaign::WriteResults(TString resultsFile)
+{
+	ofstream file(resultsFile);
+	if(!file.is_open())
+	{
+		cout << "   ERROR: the results could not be written in " << resultsFile << endl;
+		return 0;
+	}
+
+	file << "# author source candidate instrument wobble type qfactorMax thetaOpt thetaOptRangMin thetaOptRangMax wobbleOpt wobbleOptRangMin wobbleOptRangMax time" << endl;
+	if(iNumShards>1)
+	{
+		file << TString::Format("# shard: %d of %d cells %lld to %lld of %d",iShard,iNumShards,
+				(Long64_t)GetNumCells()*iShard/iNumShards,(Long64_t)GetNumCells()*(iShard+1)/iNumShards,GetNumCells()) << endl;
+	}
+	for(UInt_t s=0; s<vSkipped.size(); s++) file << "# skipped: " << vSkipped[s] << endl;
+	if(bIsCancelled) file << "# skipped: the jobs not run (cancelled)" << endl;
+
+	for(UInt_t j=0; j<vJobs.size(); j++) file << GetResultLines(vJobs[j]);
+	return 1;
+}
+
+//-----------------------------------------------
+//	It returns the lines of the results table of the job (see WriteResults()), one for each type done, with their "\n".
+//	The lines of the progress file (isProgress) start with the indices of the source, candidate and instrument in
+//	the matrix: the names and the wobble of the table do not tell apart every cell (see ReadProgress()).
+//	It only reads the results of the job and the matrix, so the writer thread can call it (see WriteProgress()).
+std::string JDCampaign::GetResultLines(const Job& job, Bool_t isProgress)
+{
+	TString prefix = (isProgress? TString::Format("%d %d %d ",job.iSource,job.iCandidate,job.iInstrument) : TString(""));
+
+	std::string lines;
+	for(UInt_t t=0; t<vTypes.size(); t++)
+	{
+		if(!job.vIsDone[t]) continue;
+
+		const Double_t* optimum = &job.vOptimum[t*JDSurfaceStore::kNumOptimumValues];
+		lines += prefix.Data();
+		lines += TString::Format("%s %s %s %s %.3f %d %.6e %.4f %.4f %.4f %.4f %.4f %.4f %.3f\n",
+				vAuthors[job.iSource].Data(), vSources[job.iSource].Data(), vCandidates[job.iCandidate].Data(),
+				vInstrumentNames[job.iInstrument].Data(), vWobbles[job.iInstrument], vTypes[t],
+				optimum[0], optimum[1], optimum[2], optimum[3], optimum[4], optimum[5], optimum[6], job.dRealTime).Data();
+	}
+	return lines;
+}
+
+//-----------------------------------------------
+//	It starts the writer thread of the progress file (see WriteProgress()), fed by numProducers threads with
+//	resultBuffers->Push(thread, job) once each job is run
+void JDCampaign::StartProgressWriter(TString progressFile, Int_t numProducers)
+{
+	sProgressFile = progressFile;
+	resultBuffers = new JDResultBuffers<Job*>(numProducers);
+	bIsProgressStopping = 0;
+	tProgressWriter = std::thread(&JDCampaign::WriteProgress,this);
+}
+
+//-----------------------------------------------
+//	It waits until the writer thread has written the jobs pushed so far and stops it (the producers must have ended)
+void JDCampaign::StopProgressWriter()
+{
+	if(!resultBuffers) return;
+	bIsProgressStopping = 1;
+	tProgressWriter.join();
+	delete resultBuffers;
+	resultBuffers = NULL;
+}
+
+//-----------------------------------------------
+//	Writer thread of Run(): it is the only one writing results while the jobs run. It drains the buffers of all the
+//	threads in batches and appends the lines of their jobs (see GetResultLines()), in the order they end, to the
+//	progress file, flushing it after each batch. The results table of Run() is written in the order of the matrix at
+//	the end (see WriteResults()): the progress file keeps the jobs done if the process does not get there, so that
+//	the next Run() can resume from it (see ReadProgress()). The jobs taken from the last one are written first.
+void JDCampaign::WriteProgress()
+{
+	ofstream file(sProgressFile);
+	if(!file.is_open()) cout << "   WARNING: the progress could not be written in " << sProgressFile << endl;
+	else file << "# progress: the results of the jobs in the order they end (see JDCampaign::WriteProgress())" << endl
+			  << GetProgressHeader() << endl << sResumedLines << std::flush;
+
+	std::string batch;
+	while(1)
+	{
+		Bool_t isStopping = bIsProgressStopping;			// read before draining: nothing is pushed after it
+		batch.clear();
+		resultBuffers->Drain([&](Job* job){batch += GetResultLines(*job,1);});
+		if(batch.size()>0 && file.is_open()) file << batch << std::flush;
+		else if(isStopping) return;
+		else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+//-----------------------------------------------
+//	It returns the line of the progress file that identifies the campaign: the hash of its matrix and options
+//	(see GetMatrixDescription()) and the shard. Only a progress file of the same campaign is resumed.
+TString JDCampaign::GetProgressHeader()
+{
+	return TString::Format("# campaign: %016llx shard %d of %d",(unsigned long long)JDSurfaceStore::GetHash(GetMatrixDescription().c_str()),iShard,iNumShards);
+}
+
+//-----------------------------------------------
+//	It reads the jobs done from the progress file of a Run() of this campaign that did not end (killed or cancelled):
+//	the results of every type of them, to be taken by CreateJobs() (see GetResumedJob()) instead of running them again.
+//	The last line is ignored if it was cut, and so are the jobs with any type missing. It returns the number of jobs.
+Int_t JDCampaign::ReadProgress(TString progressFile)
+{
+	mapResumed.clear();
+	sResumedLines.clear();
+	ifstream file(progressFile);
+	if(!file.is_open()) return 0;
+
+	Bool_t isCampaign = 0;
+	std::vector<TString> jobs;						// of each line
+	std::vector<std::string> lines;
+	std::map<TString, Int_t> mapNumTypes;			// key: "source candidate instrument" indices
+	std::string buffer;
+	while(std::getline(file,buffer))
+	{
+		if(file.eof()) break;						// without "\n": the process was killed while writing it
+		TString line = buffer.c_str();
+		if(line.BeginsWith("# campaign:"))	isCampaign = (line==GetProgressHeader());
+		if(line.BeginsWith("#") || line.Length()==0) continue;
+
+		// the indices of the cell in the matrix (the same matrix: see GetProgressHeader()), then the line of the table
+		std::istringstream stream(buffer);
+		Int_t source, candidate, instrument;
+		std::string author, sourceName, candidateName, instrumentName, wobble;
+		Int_t type;
+		std::vector<Double_t> values(JDSurfaceStore::kNumOptimumValues+1);		// and the time of the job
+		stream >> source >> candidate >> instrument >> author >> sourceName >> candidateName >> instrumentName >> wobble >> type;
+		for(UInt_t v=0; v<values.size(); v++) stream >> values[v];
+		if(!stream) continue;
+
+		TString job = TString::Format("%d %d %d",source,candidate,instrument);
+		TString key = job+TString::Format(" %d",type);
+		if(mapResumed.count(key) || std::find(vTypes.begin(),vTypes.end(),type)==vTypes.end()) continue;
+		mapResumed[key] = values;
+		mapNumTypes[job]++;
+		jobs.push_back(job);
+		lines.push_back(buffer);
+	}
+
+	if(!isCampaign)
+	{
+		mapResumed.clear();
+		cout << "   WARNING: " << progressFile << " is not of this campaign: it is not resumed" << endl;
+		return 0;
+	}
+
+	Int_t numJobs = 0;
+	for(std::map<TString, Int_t>::iterator it=mapNumTypes.begin(); it!=mapNumTypes.end(); it++) if(it->second==(Int_t)vTypes.size()) numJobs++;
+	for(UInt_t l=0; l<lines.size(); l++) if(mapNumTypes[jobs[l]]==(Int_t)vTypes.size()) sResumedLines += lines[l]+"\n";
+	return numJobs;
+}
+
+//-----------------------------------------------
+//	It returns the matrix (sources, candidates, instruments, types) and the options of the campaign, as lines of
+//	tab-separated fields (see BroadcastMatrix()). The options of the run (checkpoints, resume, pipeline) are only
+//	added if isRunOptions: they are not in the hash of the progress file (see GetProgressHeader()), so a campaign
+//	can be resumed with other ones.
+std::string JDCampaign::GetMatrixDescription(Bool_t isRunOptions)
+{
+	std::ostringstream stream;
+	for(UInt_t s=0; s<vSources.size(); s++)				stream << "S\t" << vAuthors[s] << "\t" << vSources[s] << "\n";
+	for(UInt_t c=0; c<vCandidates.size(); c++)			stream << "C\t" << vCandidates[c] << "\n";
+	for(UInt_t i=0; i<vInstrumentNames.size(); i++)
+		stream << "I\t" << vInstrumentNames[i] << "\t" << TString::Format("%.17g\t%.17g",vDistCameraCenters[i],vWobbles[i]) << "\n";
+	for(UInt_t t=0; t<vTypes.size(); t++)				stream << "T\t" << vTypes[t] << "\n";
+	stream << "O\t" << iOptimizationMode << "\t" << TString::Format("%.17g",dTolerance) << "\t" << sStorePath << "\n";
+	if(isRunOptions)
+		stream << "R\t" << TString::Format("%.17g",dCheckpointInterval) << "\t" << (Int_t)bIsResumed << "\t" << (Int_t)bIsPipelined << "\t" << iPipelineCapacity << "\n";
+	return stream.str();
+}
+
+//-----------------------------------------------
+//	It merges the partial tables of the numShards shards of resultsFile (see GetShardFile()) into resultsFile: the
+//	header, the skipped sources and instruments (once each) and the lines of the shards in order. As the shards are
+//	contiguous ranges of the matrix, the table is the one of a single-process run (but for the times of the jobs).
+//	It returns 0, without writing anything, if a partial table is missing or the shards do not cover the matrix.
+Bool_t JDCampaign::MergeResults(TString resultsFile, Int_t numShards)
+{
+	TString header;
+	std::vector<TString> skipped;
+	std::vector<TString> lines;
+	Long64_t nextCell = 0, numCells = -1;
+
+	for(Int_t shard=0; shard<numShards; shard++)
+	{
+		TString shardFile = GetShardFile(resultsFile,shard,numShards);
+		ifstream file(shardFile);
+		if(!file.is_open())
+		{
+			cout << "   ERROR: the partial results " << shardFile << " could not be read" << endl;
+			return 0;
+		}
+
+		Bool_t isShard = (numShards<=1);
+		std::string buffer;
+		while(std::getline(file,buffer))
+		{
+			TString line = buffer.c_str();
+			if(line.BeginsWith("# shard:"))
+			{
+				Int_t lineShard, lineNumShards, lineNumCells;
+				Long64_t firstCell, endCell;
+				if(sscanf(line.Data(),"# shard: %d of %d cells %lld to %lld of %d",&lineShard,&lineNumShards,&firstCell,&endCell,&lineNumCells)!=5
+						|| lineShard!=shard || lineNumShards!=numShards || firstCell!=nextCell || (numCells>=0 && lineNumCells!=numCells))
+				{
+					cout << "   ERROR: " << shardFile << " is not the shard " << shard << " of " << numShards << " of the same campaign" << endl;
+					return 0;
+				}
+				nextCell = endCell;
+				numCells = lineNumCells;
+				isShard = 1;
+			}
+			else if(line.BeginsWith("# skipped:"))
+			{
+				if(std::find(skipped.begin(),skipped.end(),line)==skipped.end()) skipped.push_back(line);
+			}
+			else if(line.BeginsWith("#"))	header = line;
+			else if(line.Length()>0)		lines.push_back(line);
+		}
+
+		if(!isShard)
+		{
+			cout << "   ERROR: " << shardFile << " is not a partial table" << endl;
+			return 0;
+		}
+	}
+	if(numShards>1 && nextCell!=numCells)
+	{
+		cout << "   ERROR: the shards of " << resultsFile << " do not cover the whole matrix" << endl;
+		return 0;
+	}
+
+	ofstream file(resultsFile);
+	if(!file.is_open())
+	{
+		cout << "   ERROR: the results could not be written in " << resultsFile << endl;
+		return 0;
+	}
+	file << header << endl;
+	for(UInt_t s=0; s<skipped.size(); s++) file << skipped[s] << endl;
+	for(UInt_t l=0; l<lines.size(); l++) file << lines[l] << endl;
+
+	cout << "   " << numShards << " shards merged into " << resultsFile << " (" << lines.size() << " lines)" << endl;
+	return 1;
+}
+
+#ifdef JD_WITH_MPI
+// Messages between the rank 0 and the others: a worker sends the result of its last cell (cell -1 at first) and gets
+// the next cell (-1: stop). The result is [cell, status, time, kNumOptimumValues for each type].
+static const Int_t kMPITagResult = 1;
+static const Int_t kMPITagWork = 2;
+enum JDCampaignCellStatus {kCellPending=0, kCellDone, kCellSkippedHalo, kCellSkippedInstrument};
+
+//-----------------------------------------------
+//	It runs the campaign over the MPI ranks (see RunMPI() in JDCampaign.h). With only one rank it is Run().
+Bool_t JDCampaign::RunMPI(TString resultsFile)
+{
+	Int_t isInitialized = 0;
+	MPI_Initialized(&isInitialized);
+	if(!isInitialized)
+	{
+		cout << "   ***************************************" << endl;
+		cout << "   ***                                 ***" << endl;
+		cout << "   ***  ERROR: MPI is not initialized  ***" << endl;
+		cout << "   ***  (call MPI_Init() first)        ***" << endl;
+		cout << "   ***                                 ***" << endl;
+		cout << "   ***************************************" << endl;
+		return 0;
+	}
+
+	Int_t rank, numRanks;
+	MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+	MPI_Comm_size(MPI_COMM_WORLD,&numRanks);
+
+	BroadcastMatrix(rank);
+	if(numRanks==1) return Run(resultsFile);
+
+	if(rank==0) return RunMPIMaster(resultsFile,numRanks);
+	RunMPIWorker();
+	return 1;
+}
+
+//-----------------------------------------------
+//	It sends the matrix (sources, candidates, instruments, types) and the options of the rank 0, those of the run
+//	too, to all the others (see GetMatrixDescription()): the jobs of every rank run as those of Run() would
+void JDCampaign::BroadcastMatrix(Int_t rank)
+{
+	std::string matrix;
+	if(rank==0) matrix = GetMatrixDescription(1);
+
+	Int_t length = matrix.size();
+	MPI_Bcast(&length,1,MPI_INT,0,MPI_COMM_WORLD);
+	matrix.resize(length);
+	MPI_Bcast(&matrix[0],length,MPI_CHAR,0,MPI_COMM_WORLD);
+	if(rank==0) return;
+
+	vAuthors.clear();
+	vSources.clear();
+	vCandidates.clear();
+	vInstrumentNames.clear();
+	vDistCameraCenters.clear();
+	vWobbles.clear();
+	vTypes.clear();
+
+	std::istringstream stream(matrix);
+	std::string line;
+	while(std::getline(stream,line))
+	{
+		std::vector<std::string> fields;
+		std::istringstream lineStream(line);
+		std::string field;
+		while(std::getline(lineStream,field,'\t')) fields.push_back(field);
+		if(fields.size()==0) continue;
+
+		if(fields[0]=="S" && fields.size()==3)			AddSource(fields[1].c_str(),fields[2].c_str());
+		else if(fields[0]=="C" && fields.size()==2)		AddCandidate(fields[1].c_str());
+		else if(fields[0]=="I" && fields.size()==4)		AddInstrument(fields[1].c_str(),atof(fields[2].c_str()),atof(fields[3].c_str()));
+		else if(fields[0]=="T" && fields.size()==2)		AddType(atoi(fields[1].c_str()));
+		else if(fields[0]=="O" && fields.size()>=3)
+		{
+			iOptimizationMode = atoi(fields[1].c_str());
+			dTolerance = atof(fields[2].c_str());
+			sStorePath = (fields.size()>3? fields[3].c_str() : "");
+		}
+		else if(fields[0]=="R" && fields.size()==5)
+		{
+			dCheckpointInterval = atof(fields[1].c_str());
+			bIsResumed = atoi(fields[2].c_str());
+			SetIsPipelined(atoi(fields[3].c_str()),atoi(fields[4].c_str()));
+		}
+	}
+}
+
+//-----------------------------------------------
+//	Rank 0 of RunMPI(): it deals the cells (in the order of the table) to the ranks that ask for work, gathers their
+//	results and writes the table of a single-process run (see CreateJobs() and WriteResults()).
+//	As Run(), it appends the results to the progress file as they arrive (see WriteProgress()), and if it is resumed
+//	(see SetIsResumed()) the cells of its progress file are not dealt again (see ReadProgress()).
+Bool_t JDCampaign::RunMPIMaster(TString resultsFile, Int_t numRanks)
+{
+	TStopwatch stopwatch;
+	stopwatch.Start();
+	dRealTime = 0.;
+	dUtilization = 0.;
+	ClearJobs();
+
+	TString progressFile = GetProgressFile(resultsFile);
+	mapResumed.clear();
+	sResumedLines.clear();
+	if(bIsResumed) ReadProgress(progressFile);
+
+	Int_t numCells = GetNumCells();
+	Int_t numTypes = vTypes.size();
+	Int_t numValues = 3+numTypes*JDSurfaceStore::kNumOptimumValues;
+	std::vector<Double_t> buffer(numValues);
+	std::vector<Int_t> status(numCells,kCellPending);
+	std::vector<Double_t> times(numCells,0.);
+	std::vector<Double_t> optima(numCells*numTypes*JDSurfaceStore::kNumOptimumValues,0.);
+
+	Int_t nextCell = 0;
+	for(Int_t t=0; t<numTypes; t++)
+	{
+		if(JDQFactorKernel::GetEffects(vTypes[t])<0)
+		{
+			cout << "   ERROR: QFactor type " << vTypes[t] << " not valid" << endl;
+			nextCell = numCells;				// nothing to deal: the workers are stopped
+		}
+	}
+
+	// the cells of the progress file resumed
+	Int_t numInstruments = vInstrumentNames.size();
+	std::vector<Bool_t> isResumed(numCells,0);
+	for(Int_t cell=0; cell<numCells && mapResumed.size()>0; cell++)
+	{
+		Job job;
+		if(!GetResumedJob(cell/numInstruments/vCandidates.size(),(cell/numInstruments)%vCandidates.size(),cell%numInstruments,job)) continue;
+		isResumed[cell] = 1;
+		status[cell] = kCellDone;
+		times[cell] = job.dRealTime;
+		std::copy(job.vOptimum.begin(),job.vOptimum.end(),optima.begin()+cell*numTypes*JDSurfaceStore::kNumOptimumValues);
+	}
+
+	ofstream progress(progressFile);
+	if(!progress.is_open()) cout << "   WARNING: the progress could not be written in " << progressFile << endl;
+	else progress << "# progress: the results of the jobs in the order they end (see JDCampaign::WriteProgress())" << endl
+				  << GetProgressHeader() << endl << sResumedLines << std::flush;
+
+	Int_t numWorking = numRanks-1;
+	while(numWorking>0)
+	{
+		MPI_Status mpiStatus;
+		MPI_Recv(buffer.data(),numValues,MPI_DOUBLE,MPI_ANY_SOURCE,kMPITagResult,MPI_COMM_WORLD,&mpiStatus);
+		Int_t cell = (Int_t)buffer[0];
+		if(cell>=0 && cell<numCells)
+		{
+			status[cell] = (Int_t)buffer[1];
+			times[cell] = buffer[2];
+			std::copy(buffer.begin()+3,buffer.end(),optima.begin()+cell*numTypes*JDSurfaceStore::kNumOptimumValues);
+
+			if(status[cell]==kCellDone && progress.is_open())
+			{
+				Job job;
+				job.iSource = cell/numInstruments/vCandidates.size();
+				job.iCandidate = (cell/numInstruments)%vCandidates.size();
+				job.iInstrument = cell%numInstruments;
+				job.dRealTime = times[cell];
+				job.vIsDone.assign(numTypes,1);
+				job.vOptimum.assign(buffer.begin()+3,buffer.end());
+				progress << GetResultLines(job,1) << std::flush;
+			}
+		}
+
+		while(nextCell<numCells && isResumed[nextCell]) nextCell++;
+		Int_t work = (nextCell<numCells? nextCell++ : -1);
+		MPI_Send(&work,1,MPI_INT,mpiStatus.MPI_SOURCE,kMPITagWork,MPI_COMM_WORLD);
+		if(work<0) numWorking--;
+	}
+	progress.close();
+	stopwatch.Stop();
+	dRealTime = stopwatch.RealTime();
+
+	// the skipped objects and the jobs in the order of CreateJobs()
+	for(Int_t i=0; i<numInstruments; i++) if(!GetInstrument(i)) vSkipped.push_back(vInstrumentNames[i]);
+	Double_t busyTime = 0.;
+	for(UInt_t s=0; s<vSources.size(); s++)
+	{
+		for(UInt_t c=0; c<vCandidates.size(); c++)
+		{
+			Int_t cell0 = (s*vCandidates.size()+c)*numInstruments;
+			for(Int_t i=0; i<numInstruments; i++)
+			{
+				Int_t cell = cell0+i;
+				if(status[cell]==kCellSkippedHalo && i==0) vSkipped.push_back(vAuthors[s]+"/"+vSources[s]+"/"+vCandidates[c]);
+				if(status[cell]!=kCellDone) continue;
+
+				Job job;
+				job.iSource = s;
+				job.iCandidate = c;
+				job.iInstrument = i;
+				job.bIsResumed = isResumed[cell];
+				job.optimization = NULL;
+				job.dCost = 0.;
+				job.dRealTime = times[cell];
+				job.vIsDone.assign(numTypes,1);
+				job.vOptimum.assign(optima.begin()+cell*numTypes*JDSurfaceStore::kNumOptimumValues,optima.begin()+(cell+1)*numTypes*JDSurfaceStore::kNumOptimumValues);
+				vJobs.push_back(job);
+				if(job.bIsResumed)	iNumJobsResumed++;
+				else				busyTime += job.dRealTime;
+			}
+		}
+	}
+	if(dRealTime>0.) dUtilization = busyTime/(dRealTime*(numRanks-1));
+
+	if(vJobs.size()==0)
+	{
+		gSystem->Unlink(progressFile);
+		cout << "   **********************************" << endl;
+		cout << "   ***                            ***" << endl;
+		cout << "   ***  WARNING:                  ***" << endl;
+		cout << "   ***  The campaign has no jobs  ***" << endl;
+		cout << "   ***                            ***" << endl;
+		cout << "   **********************************" << endl;
+		return 0;
+	}
+
+	// the progress file is not needed any more once the table is complete
+	Bool_t isWritten = WriteResults(resultsFile);
+	if(isWritten) gSystem->Unlink(progressFile);
+
+	cout << endl;
+	cout << "   ************************************************" << endl;
+	cout << "   ***" << endl;
+	cout << "   ***  Campaign (MPI, " << numRanks-1 << " workers): " << vJobs.size() << " jobs (" << vJobs.size()*vTypes.size() << " optimal points)" << endl;
+	cout << "   ***  " << TString::Format("%.3f jobs/s (%.2f s running)",GetJobsPerSecond(),dRealTime) << endl;
+	cout << "   ***  " << TString::Format("%.1f %% mean utilization of the workers",100.*dUtilization) << endl;
+	if(iNumJobsResumed>0)
+		cout << "   ***  Resumed: " << iNumJobsResumed << " jobs taken from " << progressFile << endl;
+	if(vSkipped.size()>0)
+		cout << "   ***  " << vSkipped.size() << " skipped (see " << resultsFile << ")" << endl;
+	cout << "   ***  Results: " << resultsFile << endl;
+	cout << "   ***" << endl;
+	cout << "   ************************************************" << endl;
+	cout << endl;
+
+	return isWritten;
+}
+
+//-----------------------------------------------
+//	Other ranks of RunMPI(): they ask for cells until the rank 0 stops them. Each cell loads its halo and instrument
+//	(once per rank: they are kept for the next cells), runs its job (see RunJob()) and sends back the optimal points.
+//	A rank runs one job at a time, filling its grids with the threads of the rank (see SetNumThreads()).
+void JDCampaign::RunMPIWorker()
+{
+	Int_t numTypes = vTypes.size();
+	Int_t numValues = 3+numTypes*JDSurfaceStore::kNumOptimumValues;
+	Int_t numInstruments = vInstrumentNames.size();
+	std::vector<Double_t> buffer(numValues,0.);
+	buffer[0] = -1;
+
+	while(1)
+	{
+		MPI_Send(buffer.data(),numValues,MPI_DOUBLE,0,kMPITagResult,MPI_COMM_WORLD);
+
+		Int_t cell;
+		MPI_Recv(&cell,1,MPI_INT,0,kMPITagWork,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+		if(cell<0) break;
+
+		Int_t instrument = cell%numInstruments;
+		Int_t candidate = (cell/numInstruments)%vCandidates.size();
+		Int_t source = cell/numInstruments/vCandidates.size();
+
+		std::fill(buffer.begin(),buffer.end(),0.);
+		buffer[0] = cell;
+		JDDarkMatter* darkMatter = GetDarkMatter(source,candidate);
+		JDInstrument* jdInstrument = (darkMatter? GetInstrument(instrument) : NULL);
+		if(!darkMatter)				buffer[1] = kCellSkippedHalo;
+		else if(!jdInstrument)		buffer[1] = kCellSkippedInstrument;
+		else
+		{
+			Job job = CreateJob(source,candidate,instrument,darkMatter,jdInstrument);
+			job.optimization->SetNumThreads(iNumThreads);
+			RunJob(job);
+			delete job.optimization;
+
+			buffer[1] = kCellDone;
+			buffer[2] = job.dRealTime;
+			std::copy(job.vOptimum.begin(),job.vOptimum.end(),buffer.begin()+3);
+		}
+	}
+}
+#endif
@@ -0,0 +1,226 @@
+/*
+ * JDCampaign.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 CAMPAIGN OF OPTIMIZATIONS: OPTIMAL THETA AND WOBBLE FOR EVERY SOURCE x CANDIDATE x INSTRUMENT x QFACTOR TYPE.
+ *  		 A JOB IS ONE SOURCE, CANDIDATE AND INSTRUMENT (ONE JDOptimization): ALL ITS QFACTOR TYPES ARE FILLED IN ONE PASS.
+ *  		 EACH DARK MATTER HALO (SOURCE AND CANDIDATE) AND EACH INSTRUMENT IS LOADED ONCE AND SHARED BY ALL ITS JOBS.
+ *  		 Run() WORKS IN THREE STEPS:
+ *  		 	1. SERIAL:		IT LOADS THE SHARED OBJECTS, CREATES THE JOBS AND SAMPLES THEIR KERNELS (IT TOUCHES ROOT)
+ *  		 	2. PARALLEL:	THE JOBS, SORTED BY COST, ARE SCHEDULED WITH WORK STEALING (SEE JDTaskScheduler)
+ *  		 	3. SERIAL:		IT WRITES ONE TABLE WITH ALL THE RESULTS
+ *  		 WHILE THE JOBS RUN, EACH THREAD HANDS THE JOBS IT ENDS TO ONE WRITER THREAD THROUGH A BUFFER OF ITS OWN (NO
+ *  		 LOCKS, SEE JDResultBuffers), THAT APPENDS THEM IN BATCHES TO A PROGRESS FILE (SEE GetProgressFile()).
+ *  		 PIPELINED (SEE SetIsPipelined()), STEPS 1 AND 2 OVERLAP: THE CALLER LOADS, DERIVES AND SMEARS THE TABLES OF THE
+ *  		 NEXT JOBS WHILE THE WORKER THREADS SCAN THE PREVIOUS ONES, AND THE JOBS SCANNED ARE RELEASED AS THEY END.
+ *  		 THE JOBS CAN BE RECEIVED AS THEY END (SEE SetJobCallback()) AND THE CAMPAIGN CAN BE CANCELLED (FROM THE CALLBACK,
+ *  		 OR WITH A JDCancelToken AND ITS DEADLINE): THE TABLE THEN HAS THE JOBS RUN SO FAR.
+ *  		 WITH A SURFACE STORE (SEE JDSurfaceStore) THE SURFACES AND OPTIMAL POINTS ALREADY COMPUTED ARE ONLY READ.
+ *  		 A LONG CAMPAIGN CAN BE RESUMED (SEE SetIsResumed()): THE PROGRESS FILE OF A RUN THAT DID NOT END (KILLED OR
+ *  		 CANCELLED) IS ITS CHECKPOINT OF THE JOBS DONE, WHICH ARE NOT LOADED NOR RUN AGAIN, AND WITH A STORE THE JOBS
+ *  		 THAT WERE RUNNING GO ON FROM THE LAST CHECKPOINT OF THEIR SURFACES (SEE SetCheckpointInterval()), WITH THEIR
+ *  		 SMEARED PROFILES AND ACCEPTANCES READ FROM THE STORE.
+ *  		 A CAMPAIGN TOO LARGE FOR ONE NODE CAN BE SPLIT IN SHARDS (SEE SetShard()): EACH SHARD IS AN INDEPENDENT PROCESS
+ *  		 THAT RUNS A CONTIGUOUS RANGE OF CELLS OF THE MATRIX (SOURCE x CANDIDATE x INSTRUMENT) AND WRITES ITS OWN PARTIAL
+ *  		 TABLE; MergeResults() JOINS THEM INTO THE TABLE OF A SINGLE-PROCESS RUN (THE SAME LINES IN THE SAME ORDER; ONLY
+ *  		 THE TIMES OF THE JOBS DIFFER). NO COMMUNICATION IS NEEDED BUT A SHARED DIRECTORY ("runJDCampaignShards.sh").
+ *  		 BUILT WITH JD_WITH_MPI, RunMPI() DISTRIBUTES THE CELLS OVER THE MPI RANKS WITH A DYNAMIC QUEUE INSTEAD
+ *  		 ("mainJDCampaignMPI.cc").
+ *  		 The macro "exampleJDCampaign.cxx" shows how to use this class.
+ */
+
+#ifndef JDCampaign_H_
+#define JDCampaign_H_
+
+#include "JDCancelToken.h"
+#include "JDDarkMatter.h"
+#include "JDInstrument.h"
+#include "JDOptimization.h"
+#include "JDResultBuffers.h"
+#include "JDSurfaceStore.h"
+
+#include <Rtypes.h>
+#include <TString.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+class JDCampaign {
+public:
+	// A job that has been run, as given to the callback of SetJobCallback()
+	class JobResult {
+	public:
+		TString sAuthor;
+		TString sSource;
+		TString sCandidate;
+		TString sInstrumentName;
+		Double_t dWobble;						// [deg]
+		Double_t dRealTime;						// [s]
+		std::vector<Int_t> vTypes;
+		std::vector<Double_t> vOptimum;			// kNumOptimumValues for each type (see JDSurfaceStore)
+	};
+	// It returns 0 to cancel the campaign
+	typedef std::function<Bool_t(const JobResult&)> JobCallback;
+
+	JDCampaign(TString mySourcePath, TString myInstrumentPath);
+	virtual ~JDCampaign();
+
+	// The matrix of the campaign
+	void AddSource(TString author, TString source);
+	Int_t AddSourcesFromReferences(TString author);
+	void AddCandidate(TString candidate)		{vCandidates.push_back(candidate);}
+	void AddInstrument(TString instrumentName, Double_t distCameraCenter, Double_t wobble);
+	void AddType(Int_t type)					{vTypes.push_back(type);}
+
+	// Threads running the jobs (0: one per hardware thread)
+	void SetNumThreads(Int_t numThreads)		{iNumThreads=numThreads;}
+	Int_t GetNumThreads()						{return iNumThreads;}
+	// Local store of surfaces and optimal points (empty path: no store)
+	void SetSurfaceStore(TString storePath)		{sStorePath=storePath;}
+	TString GetSurfaceStore()					{return sStorePath;}
+	// See JDOptimization::SetOptimizationMode() and JDOptimization::SetTolerance()
+	void SetOptimizationMode(Int_t optimizationMode)	{iOptimizationMode=optimizationMode;}
+	Int_t GetOptimizationMode()					{return iOptimizationMode;}
+	void SetTolerance(Double_t tolerance)		{dTolerance=tolerance;}
+	Double_t GetTolerance()						{return dTolerance;}
+	// Pipelined Run(): at most pipelineCapacity jobs wait, set up, for a thread to scan them (see RunPipeline())
+	void SetIsPipelined(Bool_t isPipelined, Int_t pipelineCapacity=4)	{bIsPipelined=isPipelined; iPipelineCapacity=(pipelineCapacity>0? pipelineCapacity : 1);}
+	Bool_t GetIsPipelined()						{return bIsPipelined;}
+	Int_t GetPipelineCapacity()					{return iPipelineCapacity;}
+	// Each job is given to callback as soon as it has been run, on the caller of Run() (that is pipelined then)
+	void SetJobCallback(const JobCallback& callback)	{fJobCallback=callback;}
+	// Once the token is cancelled, Run() sets up and runs no more jobs (NULL: no token)
+	void SetCancelToken(JDCancelToken* token)	{cancelToken=token;}
+	// Run() takes the jobs done from the progress file of the last Run() of the same campaign, if it did not end
+	void SetIsResumed(Bool_t isResumed)			{bIsResumed=isResumed;}
+	Bool_t GetIsResumed()						{return bIsResumed;}
+	// [s] Each job saves the rows of its surfaces into the store at this interval (<=0: never, see JDOptimization)
+	void SetCheckpointInterval(Double_t checkpointInterval)	{dCheckpointInterval=checkpointInterval;}
+	Double_t GetCheckpointInterval()			{return dCheckpointInterval;}
+
+	// Shard of the matrix run by this process (shard in [0, numShards); default: 0 of 1, the whole matrix)
+	void SetShard(Int_t shard, Int_t numShards);
+	Int_t GetShard()							{return iShard;}
+	Int_t GetNumShards()						{return iNumShards;}
+	Int_t GetNumCells()							{return vSources.size()*vCandidates.size()*vInstrumentNames.size();}
+
+	// It runs all the jobs (of the shard) and writes the results table (GetShardFile() of it if sharded).
+	// It returns 0 if there was nothing to run
+	Bool_t Run(TString resultsFile);
+
+#ifdef JD_WITH_MPI
+	// The same as Run(), over all the ranks of MPI_COMM_WORLD (MPI_Init() must have been called). It must be called
+	// by every rank, but only the rank 0 needs the matrix: it broadcasts it, deals the cells one at a time to the
+	// ranks that ask for work (each rank loads its halos and instruments once), gathers the optimal points and
+	// writes the table of a single-process run, and its progress file to resume it (see SetIsResumed()). Each rank
+	// runs one job at a time on its own SetNumThreads() threads. It returns 0 on the rank 0 if there was nothing to run.
+	Bool_t RunMPI(TString resultsFile);
+#endif
+
+	// Partial table of a shard, and merge of the partial tables of all the shards into resultsFile
+	static TString GetShardFile(TString resultsFile, Int_t shard, Int_t numShards);
+	// Lines of the jobs of resultsFile already run, while Run() is running (it is deleted once resultsFile is complete)
+	static TString GetProgressFile(TString resultsFile);
+	static Bool_t MergeResults(TString resultsFile, Int_t numShards);
+
+	// Of the last Run()
+	Int_t GetNumJobs()							{return vJobs.size();}
+	Double_t GetRealTime()						{return dRealTime;}				// [s] of the parallel step
+	Double_t GetJobsPerSecond()					{return (dRealTime>0? (vJobs.size()-iNumJobsResumed)/dRealTime : 0.);}
+	Double_t GetUtilization()					{return dUtilization;}			// mean over the threads of the parallel step
+	Double_t GetSetupTime()						{return dSetupTime;}			// [s] loading and sampling the jobs
+	Int_t GetMaxQueuedJobs()					{return iMaxQueuedJobs;}		// pipelined: most jobs set up and waiting
+	Int_t GetNumJobsRun();											// the resumed ones too
+	Int_t GetNumJobsResumed()					{return iNumJobsResumed;}		// taken from the progress file
+	Bool_t GetIsCancelled()						{return bIsCancelled;}
+
+private:
+	class Job {
+	public:
+		Int_t iSource;
+		Int_t iCandidate;
+		Int_t iInstrument;
+		Bool_t bIsResumed;						// done by the Run() resumed (see ReadProgress()): no JDOptimization
+		JDOptimization* optimization;
+		Double_t dCost;							// relative estimate, to run the costliest jobs first
+		Double_t dRealTime;						// [s]
+		std::vector<Bool_t> vIsDone;			// for each type
+		std::vector<Double_t> vOptimum;			// kNumOptimumValues for each type (see JDSurfaceStore)
+	};
+
+	void ClearJobs();
+	Bool_t CreateJobs(const std::function<void(Job*)>& jobCreated=NULL);
+	Bool_t RunJobs(TString progressFile);
+	Bool_t RunPipeline(TString progressFile);
+	Job CreateJob(Int_t source, Int_t candidate, Int_t instrument, JDDarkMatter* darkMatter, JDInstrument* jdInstrument);
+	Bool_t GetResumedJob(Int_t source, Int_t candidate, Int_t instrument, Job& job);
+	std::string GetMatrixDescription(Bool_t isRunOptions=0);
+	TString GetProgressHeader();
+	Int_t ReadProgress(TString progressFile);
+#ifdef JD_WITH_MPI
+	void BroadcastMatrix(Int_t rank);
+	Bool_t RunMPIMaster(TString resultsFile, Int_t numRanks);
+	void RunMPIWorker();
+#endif
+	void RunJob(Job& job);
+	JobResult GetJobResult(const Job& job);
+	Bool_t IsCancelled()						{return bIsCancelled || (cancelToken && cancelToken->IsCancelled());}
+	Bool_t WriteResults(TString resultsFile);
+	std::string GetResultLines(const Job& job, Bool_t isProgress=0);
+	void StartProgressWriter(TString progressFile, Int_t numProducers);
+	void StopProgressWriter();
+	void WriteProgress();
+
+	JDDarkMatter* GetDarkMatter(Int_t source, Int_t candidate);
+	JDInstrument* GetInstrument(Int_t instrument);
+	TString GetReferenceFile(Int_t source, Int_t candidate);
+
+	TString sMySourcePath;
+	TString sMyInstrumentPath;
+
+	std::vector<TString> vAuthors;
+	std::vector<TString> vSources;
+	std::vector<TString> vCandidates;
+	std::vector<TString> vInstrumentNames;
+	std::vector<Double_t> vDistCameraCenters;	// [deg]
+	std::vector<Double_t> vWobbles;				// [deg]
+	std::vector<Int_t> vTypes;
+
+	std::map<TString, JDDarkMatter*> mapDarkMatter;	// key: author/source/candidate
+	std::map<Int_t, JDInstrument*> mapInstrument;		// key: index of the instrument
+
+	std::vector<Job> vJobs;
+	std::vector<TString> vSkipped;				// source, candidate or instrument that could not be loaded
+
+	Int_t iNumThreads;
+	Bool_t bIsPipelined;
+	Int_t iPipelineCapacity;
+	JobCallback fJobCallback;
+	JDCancelToken* cancelToken;
+	std::atomic<Bool_t> bIsCancelled;
+	JDResultBuffers<Job*>* resultBuffers;		// jobs run, from the threads running them to the writer thread
+	std::thread tProgressWriter;
+	std::atomic<Bool_t> bIsProgressStopping;
+	TString sProgressFile;
+	Bool_t bIsResumed;
+	std::map<TString, std::vector<Double_t> > mapResumed;	// key: "source candidate instrument type" indices of the progress file
+	std::string sResumedLines;					// lines of the progress file taken, written again into the new one
+	Int_t iNumJobsResumed;
+	Double_t dCheckpointInterval;
+	Int_t iShard;
+	Int_t iNumShards;
+	TString sStorePath;
+	Int_t iOptimizationMode;
+	Double_t dTolerance;
+	Double_t dRealTime;
+	Double_t dUtilization;
+	Double_t dSetupTime;
+	Int_t iMaxQueuedJobs;
+};
+
+#endif /* JDCampaign_H_ */
@@ -0,0 +1,50 @@
+/*
+ * JDCancelToken.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 CANCELLATION OF A LONG COMPUTATION.
+ */
+
+#include "JDCancelToken.h"
+
+#include <chrono>
+#include <limits>
+
+//-----------------------------------------------
+//	It returns the time of the steady clock (not affected by changes of the date) [ns]
+Long64_t JDCancelToken::GetNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//-----------------------------------------------
+//	The token is cancelled seconds from now (seconds<=0: no deadline)
+void JDCancelToken::SetDeadline(Double_t seconds)
+{
+	iDeadline = (seconds>0.? GetNow()+(Long64_t)(seconds*1e9) : 0);
+}
+
+//-----------------------------------------------
+//	It returns 1 if the deadline (if any) has been reached
+Bool_t JDCancelToken::GetIsDeadlineReached() const
+{
+	Long64_t deadline = iDeadline;
+	return (deadline>0 && GetNow()>=deadline);
+}
+
+//-----------------------------------------------
+//	It returns 1 if it has been cancelled or its deadline has been reached
+Bool_t JDCancelToken::IsCancelled() const
+{
+	return bIsCancelled || GetIsDeadlineReached();
+}
+
+//-----------------------------------------------
+//	[s] left until the deadline
+Double_t JDCancelToken::GetTimeLeft() const
+{
+	Long64_t deadline = iDeadline;
+	if(deadline==0) return std::numeric_limits<Double_t>::max();
+	return (deadline-GetNow())*1e-9;
+}
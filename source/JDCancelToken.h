@@ -0,0 +1,40 @@
+/*
+ * JDCancelToken.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 CANCELLATION OF A LONG COMPUTATION (SEE JDQFactorScan AND JDCampaign::SetCancelToken()).
+ *  		 ANY THREAD CAN Cancel() IT, AND IT IS ALSO CANCELLED ONCE ITS DEADLINE (IF ANY) IS REACHED. THE COMPUTATION
+ *  		 CHECKS IsCancelled() BETWEEN ITS UNITS OF WORK (ROWS, JOBS), SO IT STOPS AFTER THE ONES ALREADY RUNNING.
+ */
+
+#ifndef JDCancelToken_H_
+#define JDCancelToken_H_
+
+#include <Rtypes.h>
+
+#include <atomic>
+
+class JDCancelToken {
+public:
+	JDCancelToken(): bIsCancelled(0), iDeadline(0) {}
+
+	void Cancel()								{bIsCancelled=1;}
+	// It is cancelled seconds from now (seconds<=0: no deadline)
+	void SetDeadline(Double_t seconds);
+	// Not cancelled and without deadline again
+	void Reset()								{bIsCancelled=0; iDeadline=0;}
+
+	Bool_t IsCancelled() const;
+	Bool_t GetIsDeadlineReached() const;
+	// [s] until the deadline (negative if reached; a large number if there is none)
+	Double_t GetTimeLeft() const;
+
+private:
+	static Long64_t GetNow();					// [ns] of the steady clock
+
+	std::atomic<Bool_t> bIsCancelled;
+	std::atomic<Long64_t> iDeadline;			// [ns] of the steady clock (0: none)
+};
+
+#endif /* JDCancelToken_H_ */
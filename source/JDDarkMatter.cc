@@ -55,9 +55,9 @@ static const Double_t kpc2cm        = 3.08568e21; 			// [cm/kpc]
 // It redirects us to CreateFunctionDM()
 JDDarkMatter::JDDarkMatter():
   sSource(""), sMySourcePath (""),
-  sAuthor(""), sCandidate(""), gJFactor(NULL),
+  sAuthor(""), sCandidate(""), gJFactor(NULL), gJFactorSigma1(NULL), gJFactorSigma1Plus(NULL), gJFactorSigma2Minus(NULL), gJFactorSigma2Plus(NULL),
   fEvaluateJFactorVsTheta(NULL), fEvaluateJFactorSigma1VsTheta(NULL),
-  bIsBonnivard(0),bIsGeringer(0),bIsJFactor(0),
+  bIsBonnivard(0),bIsGeringer(0),bIsJFactor(0),bIsJFactorSigma1(0),bIsJFactorBands(0),
   dDeg2Rad(TMath::Pi()/180.), dBinResolution(0.05)
 {
   cout << endl;
@@ -75,9 +75,9 @@ JDDarkMatter::JDDarkMatter():
 // It redirects us to CreateFunctionDM()
 JDDarkMatter::JDDarkMatter(TGraph* jfactor):
   sSource(""), sMySourcePath (""),
-  sAuthor(""), sCandidate(""), gJFactor(NULL),
+  sAuthor(""), sCandidate(""), gJFactor(NULL), gJFactorSigma1(NULL), gJFactorSigma1Plus(NULL), gJFactorSigma2Minus(NULL), gJFactorSigma2Plus(NULL),
   fEvaluateJFactorVsTheta(NULL), fEvaluateJFactorSigma1VsTheta(NULL),
-  bIsBonnivard(0),bIsGeringer(0),bIsJFactor(0),
+  bIsBonnivard(0),bIsGeringer(0),bIsJFactor(0),bIsJFactorSigma1(0),bIsJFactorBands(0),
   dDeg2Rad(TMath::Pi()/180.), dBinResolution(0.05)
 {
   cout << endl;
@@ -117,9 +117,9 @@ JDDarkMatter::JDDarkMatter(TGraph* jfactor):
 // It redirects us to CreateFunctionDM()
 JDDarkMatter::JDDarkMatter(TString txtFile):
   sSource(""), sMySourcePath (""),
-  sAuthor(""), sCandidate(""), gJFactor(NULL),
+  sAuthor(""), sCandidate(""), gJFactor(NULL), gJFactorSigma1(NULL), gJFactorSigma1Plus(NULL), gJFactorSigma2Minus(NULL), gJFactorSigma2Plus(NULL),
   fEvaluateJFactorVsTheta(NULL), fEvaluateJFactorSigma1VsTheta(NULL),
-  bIsBonnivard(0),bIsGeringer(0),bIsJFactor(0),
+  bIsBonnivard(0),bIsGeringer(0),bIsJFactor(0),bIsJFactorSigma1(0),bIsJFactorBands(0),
   dDeg2Rad(TMath::Pi()/180.), dBinResolution(0.05)
 {
   cout << endl;
@@ -170,8 +170,8 @@ JDDarkMatter::JDDarkMatter(TString author,
 			   TString candidate,
 			   TString mySourcePath):
   sAuthor(author), sSource(source), sCandidate(candidate), sMySourcePath (mySourcePath),
-  gJFactor(NULL), fEvaluateJFactorVsTheta(NULL),
-  bIsBonnivard(0),bIsGeringer(0),bIsJFactor(0), 
+  gJFactor(NULL), gJFactorSigma1(NULL), gJFactorSigma1Plus(NULL), gJFactorSigma2Minus(NULL), gJFactorSigma2Plus(NULL), fEvaluateJFactorVsTheta(NULL), fEvaluateJFactorSigma1VsTheta(NULL),
+  bIsBonnivard(0),bIsGeringer(0),bIsJFactor(0),bIsJFactorSigma1(0),bIsJFactorBands(0), 
   dDeg2Rad(TMath::Pi()/180.), dBinResolution(0.05)
 {
   cout << endl;
@@ -213,6 +213,10 @@ JDDarkMatter::~JDDarkMatter()
 {
 
   if (gJFactor)		               delete gJFactor;
+  if (gJFactorSigma1)	               delete gJFactorSigma1;
+  if (gJFactorSigma1Plus)	       delete gJFactorSigma1Plus;
+  if (gJFactorSigma2Minus)	       delete gJFactorSigma2Minus;
+  if (gJFactorSigma2Plus)	       delete gJFactorSigma2Plus;
   if (fEvaluateJFactorVsTheta)	       delete fEvaluateJFactorVsTheta;
   if (fEvaluateJFactorSigma1VsTheta)   delete fEvaluateJFactorSigma1VsTheta;
 
@@ -349,9 +353,21 @@ Bool_t JDDarkMatter::SetJFactorFromReferences(Bool_t verbose)
 // Set dN/dOmega from JFactor
 Bool_t JDDarkMatter::SetdNdOmegaFromJFactor(){
   
-  gdNdOmega = new TGraph();
-  if(GetIsJFactorSigma1()){gdNdOmegaSigma1 = new TGraph();}
+  gdNdOmega = GetTGraphdNdOmegaFromJFactor(fEvaluateJFactorVsTheta);
+  if(GetIsJFactorSigma1()){gdNdOmegaSigma1 = GetTGraphdNdOmegaFromJFactor(fEvaluateJFactorSigma1VsTheta);}
   
+  SetIsdNdOmega(1);
+  if(GetIsJFactorSigma1()){SetIsdNdOmegaSigma1(1);}
+  
+  return 1;
+}
+
+//-----------------------------------------------
+// It returns a new TGraph (the caller owns it) of the dN/dOmega [~GeV, ~cm] vs Theta [deg] derived from this
+// JFactor [~GeV, ~cm] vs Theta [deg]: dJ/dTheta/(2*Pi*sin(Theta)) at the points of the JFactor TGraph
+TGraph* JDDarkMatter::GetTGraphdNdOmegaFromJFactor(TF1* jFactor)
+{
+  TGraph* dNdOmega = new TGraph();
   
   Double_t thetaMin = GetThetaMin();
   Double_t thetaMax = GetThetaMax();
@@ -360,22 +376,10 @@ Bool_t JDDarkMatter::SetdNdOmegaFromJFactor(){
   for(Int_t i=1; i<numPoints;i++)
     {
       Double_t theta = thetaMin + (thetaMax-thetaMin)/(numPoints*1.)*i;
-      //		cout << thetaMin << " " << thetaMax << endl;
-      Double_t dNdOmega = fEvaluateJFactorVsTheta->Derivative(theta)/(2*TMath::Pi()*TMath::Sin(theta*dDeg2Rad));
-      
-      gdNdOmega->SetPoint(i,theta,dNdOmega);
-      //		cout << theta << " " << dNdOmega << endl;
-      if(GetIsJFactorSigma1())
-	{
-	  Double_t dNdOmegaSigma1 = fEvaluateJFactorSigma1VsTheta->Derivative(theta)/(2*TMath::Pi()*TMath::Sin(theta*dDeg2Rad));
-	  gdNdOmegaSigma1->SetPoint(i,theta,dNdOmegaSigma1);
-	}
+      dNdOmega->SetPoint(i,theta,jFactor->Derivative(theta)/(2*TMath::Pi()*TMath::Sin(theta*dDeg2Rad)));
     }
   
-  SetIsdNdOmega(1);
-  if(GetIsJFactorSigma1()){SetIsdNdOmegaSigma1(1);}
-  
-  return 1;
+  return dNdOmega;
 }
 
 //-----------------------------------------------
@@ -384,6 +388,7 @@ Bool_t JDDarkMatter::SetdNdOmegaFromJFactor(){
 // with this data
 // It fulfills the TGraph gJFactorSigma1 (number of points, theta [deg], JFactorSigma1
 // [~GeV, ~cm]) with this data
+// It fulfills the TGraphs of the +1 sigma and +-2 sigma bands (see GetTGraphJFactorBand())
 // It sets the maximum and minimum value of the JFactor and the maximum value of theta
 // It allows to distinguish between Decay or Annihilation
 void JDDarkMatter::ReadJFactorBonnivard(Bool_t verbose)
@@ -392,6 +397,9 @@ void JDDarkMatter::ReadJFactorBonnivard(Bool_t verbose)
   
   gJFactor = new TGraph();
   gJFactorSigma1 = new TGraph();
+  gJFactorSigma1Plus = new TGraph();
+  gJFactorSigma2Minus = new TGraph();
+  gJFactorSigma2Plus = new TGraph();
   
   Double_t dJ, dJSigma1, dJ_p1, dJ_m2, dJ_p2;
   Double_t theta; // [deg]
@@ -409,6 +417,9 @@ void JDDarkMatter::ReadJFactorBonnivard(Bool_t verbose)
 	{
 	  gJFactor->SetPoint(contador,0.,0.);
 	  gJFactorSigma1->SetPoint(contador,0.,0.);
+	  gJFactorSigma1Plus->SetPoint(contador,0.,0.);
+	  gJFactorSigma2Minus->SetPoint(contador,0.,0.);
+	  gJFactorSigma2Plus->SetPoint(contador,0.,0.);
 	  contador ++;
 	}
       
@@ -417,6 +428,9 @@ void JDDarkMatter::ReadJFactorBonnivard(Bool_t verbose)
 	{
 	  gJFactor->SetPoint(contador,theta,(dJ*(TMath::Power(SolarMass2GeV,1.)/TMath::Power(kpc2cm,2.))));
 	  gJFactorSigma1->SetPoint(contador,theta,(dJSigma1*(TMath::Power(SolarMass2GeV,1.)/TMath::Power(kpc2cm,2.))));
+	  gJFactorSigma1Plus->SetPoint(contador,theta,(dJ_p1*(TMath::Power(SolarMass2GeV,1.)/TMath::Power(kpc2cm,2.))));
+	  gJFactorSigma2Minus->SetPoint(contador,theta,(dJ_m2*(TMath::Power(SolarMass2GeV,1.)/TMath::Power(kpc2cm,2.))));
+	  gJFactorSigma2Plus->SetPoint(contador,theta,(dJ_p2*(TMath::Power(SolarMass2GeV,1.)/TMath::Power(kpc2cm,2.))));
 	  
 	  // only for Tests
 	  if (verbose==1) cout << theta << " " << dJ*(TMath::Power(SolarMass2GeV,1.)/TMath::Power(kpc2cm,2.)) << endl;
@@ -435,6 +449,7 @@ void JDDarkMatter::ReadJFactorBonnivard(Bool_t verbose)
       file.close();
       SetIsJFactor(1);
       SetIsJFactorSigma1(1);
+      SetIsJFactorBands(1);
     }
   
   else if(GetCandidate() == "Annihilation")
@@ -444,6 +459,9 @@ void JDDarkMatter::ReadJFactorBonnivard(Bool_t verbose)
 	{
 	  gJFactor->SetPoint(contador,0.,0.);
 	  gJFactorSigma1->SetPoint(contador,0.,0.);
+	  gJFactorSigma1Plus->SetPoint(contador,0.,0.);
+	  gJFactorSigma2Minus->SetPoint(contador,0.,0.);
+	  gJFactorSigma2Plus->SetPoint(contador,0.,0.);
 	  contador ++;
 	}
       
@@ -452,6 +470,9 @@ void JDDarkMatter::ReadJFactorBonnivard(Bool_t verbose)
 	{
 	  gJFactor->SetPoint(contador,theta,(dJ*(TMath::Power(SolarMass2GeV,2.)/TMath::Power(kpc2cm,5.))));
 	  gJFactorSigma1->SetPoint(contador,theta,(dJSigma1*(TMath::Power(SolarMass2GeV,2.)/TMath::Power(kpc2cm,5.))));
+	  gJFactorSigma1Plus->SetPoint(contador,theta,(dJ_p1*(TMath::Power(SolarMass2GeV,2.)/TMath::Power(kpc2cm,5.))));
+	  gJFactorSigma2Minus->SetPoint(contador,theta,(dJ_m2*(TMath::Power(SolarMass2GeV,2.)/TMath::Power(kpc2cm,5.))));
+	  gJFactorSigma2Plus->SetPoint(contador,theta,(dJ_p2*(TMath::Power(SolarMass2GeV,2.)/TMath::Power(kpc2cm,5.))));
 	  
 	  // only for Tests
 	  if (verbose==1) cout << theta << " " << dJ*(TMath::Power(SolarMass2GeV,2.)/TMath::Power(kpc2cm,5.)) << endl;
@@ -471,6 +492,7 @@ void JDDarkMatter::ReadJFactorBonnivard(Bool_t verbose)
       file.close();
       SetIsJFactor(1);
       SetIsJFactorSigma1(1);
+      SetIsJFactorBands(1);
     }
   
   else
@@ -485,6 +507,7 @@ void JDDarkMatter::ReadJFactorBonnivard(Bool_t verbose)
 //	This function reads the JFactor data from Geringer
 //	It fulfills the gJFactor TGraph (number of points, theta [deg], JFactor[~GeV, ~cm])
 //	It fulfills the gJFactorSigma1 TGraph (number of points, theta [deg], JFactorSigma1[~GeV, ~cm])
+//	It fulfills the TGraphs of the +1 sigma and +-2 sigma bands (see GetTGraphJFactorBand())
 //	It sets the maximum and minimum value of the JFactor and the maximum value of theta
 //	It allows to distinguish between Decay or Annihilation
 void JDDarkMatter::ReadJFactorGeringer(Bool_t verbose)
@@ -500,6 +523,9 @@ void JDDarkMatter::ReadJFactorGeringer(Bool_t verbose)
 
 	gJFactor = new TGraph();
 	gJFactorSigma1 = new TGraph();
+	gJFactorSigma1Plus = new TGraph();
+	gJFactorSigma2Minus = new TGraph();
+	gJFactorSigma2Plus = new TGraph();
 
 	TString name;
 	Double_t LogJann2m, LogJann1m, LogJann, LogJann1p, LogJann2p;
@@ -511,6 +537,9 @@ void JDDarkMatter::ReadJFactorGeringer(Bool_t verbose)
 	  {
 	    gJFactor->SetPoint(contador,0.,0.);
 	    gJFactorSigma1->SetPoint(contador,0.,0.);
+	    gJFactorSigma1Plus->SetPoint(contador,0.,0.);
+	    gJFactorSigma2Minus->SetPoint(contador,0.,0.);
+	    gJFactorSigma2Plus->SetPoint(contador,0.,0.);
 	    contador ++;
 	  }
 	
@@ -526,6 +555,9 @@ void JDDarkMatter::ReadJFactorGeringer(Bool_t verbose)
 		if(contador==1) SetJFactorSigma1Min(TMath::Power(10., LogJdec1m));
 		gJFactor->SetPoint(contador, theta, TMath::Power(10., LogJdec));
 		gJFactorSigma1->SetPoint(contador, theta, TMath::Power(10., LogJdec1m));
+		gJFactorSigma1Plus->SetPoint(contador, theta, TMath::Power(10., LogJdec1p));
+		gJFactorSigma2Minus->SetPoint(contador, theta, TMath::Power(10., LogJdec2m));
+		gJFactorSigma2Plus->SetPoint(contador, theta, TMath::Power(10., LogJdec2p));
 		
 		// only for Tests
 		if (verbose==1) cout << theta << " " << TMath::Power(10., LogJdec)<< endl;
@@ -538,6 +570,9 @@ void JDDarkMatter::ReadJFactorGeringer(Bool_t verbose)
 		if(contador==1) SetJFactorSigma1Min(TMath::Power(10., LogJann1m));
 		gJFactor->SetPoint(contador, theta, TMath::Power(10., LogJann));
 		gJFactorSigma1->SetPoint(contador, theta, TMath::Power(10., LogJann1m));
+		gJFactorSigma1Plus->SetPoint(contador, theta, TMath::Power(10., LogJann1p));
+		gJFactorSigma2Minus->SetPoint(contador, theta, TMath::Power(10., LogJann2m));
+		gJFactorSigma2Plus->SetPoint(contador, theta, TMath::Power(10., LogJann2p));
 		
 		// only for Tests
 		if (verbose==1) cout << theta << " " << TMath::Power(10., LogJann)<< endl;
@@ -560,6 +595,35 @@ void JDDarkMatter::ReadJFactorGeringer(Bool_t verbose)
 	file.close();
 	SetIsJFactor(1);
 	SetIsJFactorSigma1(1);
+	SetIsJFactorBands(1);
+}
+
+//-----------------------------------------------
+// It returns the TGraph of the JFactor [~GeV, ~cm] vs Theta [deg] of this credible band (see Band):
+// median, +-1 sigma (68%) and +-2 sigma (95%). Only the references have the five bands (see GetIsJFactorBands())
+TGraph* JDDarkMatter::GetTGraphJFactorBand(Int_t band)
+{
+  switch(band)
+    {
+    case kMinus2Sigma:	return gJFactorSigma2Minus;
+    case kMinus1Sigma:	return gJFactorSigma1;
+    case kMedian:		return gJFactor;
+    case kPlus1Sigma:	return gJFactorSigma1Plus;
+    case kPlus2Sigma:	return gJFactorSigma2Plus;
+    }
+  return NULL;
+}
+
+//-----------------------------------------------
+// It returns a new TGraph (the caller owns it) of the dN/dOmega [~GeV, ~cm] vs Theta [deg] of this credible band
+// (see Band), derived as the nominal one (see SetdNdOmegaFromJFactor()): the median band gives the nominal dN/dOmega
+TGraph* JDDarkMatter::GetTGraphdNdOmegaBand(Int_t band)
+{
+  if(!GetIsJFactorBands() || !GetTGraphJFactorBand(band)) return NULL;
+  
+  TF1 jFactorBand("fEvaluateJFactorBandVsTheta",this,&JDDarkMatter::TGraphEvaluateJFactorBandVsTheta,0.,GetThetaMax(),1,"JDDarkMatter","TGraphEvaluateJFactorBandVsTheta");
+  jFactorBand.SetParameter(0,band);
+  return GetTGraphdNdOmegaFromJFactor(&jFactorBand);
 }
 
 //-----------------------------------------------
@@ -580,6 +644,16 @@ Double_t JDDarkMatter::TGraphEvaluateJFactorSigma1VsTheta(Double_t* x, Double_t*
   return gJFactorSigma1->Eval(x[0]);
 }
 
+//-----------------------------------------------
+// It evaluates the TGraph JFactor [~GeV, ~cm] vs Theta [deg] of a credible band
+//
+// x[0] 	= dTheta [deg]
+// par[0] 	= band (see Band)
+Double_t JDDarkMatter::TGraphEvaluateJFactorBandVsTheta(Double_t* x, Double_t* par)
+{
+  return GetTGraphJFactorBand((Int_t)par[0])->Eval(x[0]);
+}
+
 //It shows the list of candidates
 void JDDarkMatter::GetListOfCandidates()
 {
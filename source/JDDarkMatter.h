@@ -33,6 +33,10 @@ using namespace std;
 class JDDarkMatter : public JDAstroProfile {
 public:
 
+  // Credible bands of the JFactor read from the references (see GetTGraphJFactorBand())
+  enum Band {kMinus2Sigma=0, kMinus1Sigma=1, kMedian=2, kPlus1Sigma=3, kPlus2Sigma=4};
+  static const Int_t kNumBands = 5;
+
   JDDarkMatter();
   JDDarkMatter(TGraph* jfactor);
   JDDarkMatter(TString txtFile);
@@ -82,6 +86,13 @@ public:
   }
 
 
+  ///////////////////////////////////////////////////////
+  //TGraph
+  ///////////////////////////////////////////////////////
+  TGraph* GetTGraphJFactorBand(Int_t band);
+  TGraph* GetTGraphdNdOmegaBand(Int_t band);
+
+
   ///////////////////////////////////////////////////////
   //TF2
   ///////////////////////////////////////////////////////
@@ -111,6 +122,7 @@ public:
   Bool_t GetIsGeringer() 						{return bIsGeringer;}
   Bool_t GetIsJFactor()						{return bIsJFactor;}
   Bool_t GetIsJFactorSigma1()					{return bIsJFactorSigma1;}
+  Bool_t GetIsJFactorBands()					{return bIsJFactorBands;}
   
 protected:
 
@@ -119,12 +131,14 @@ protected:
   void SetIsGeringer(Bool_t isGeringer) 	  {bIsGeringer=isGeringer;}
   void SetIsJFactor(Bool_t isJFactor)		  {bIsJFactor=isJFactor;}
   void SetIsJFactorSigma1(Bool_t isJFactorSigma1) {bIsJFactorSigma1=isJFactorSigma1;}
+  void SetIsJFactorBands(Bool_t isJFactorBands)	  {bIsJFactorBands=isJFactorBands;}
   void SetNumPointsJFactorGraph(Int_t numPoints)  {iNumPointsJFactorGraph=numPoints;}
   void SetJFactorMax(Double_t jFactorMax)         {dJFactorMax=jFactorMax;}
   void SetJFactorSigma1Max(Double_t jFactorSigma1Max)	{dJFactorSigma1Max=jFactorSigma1Max;}
   void SetJFactorMin(Double_t jFactorMin) 		{dJFactorMin=jFactorMin;}
   void SetJFactorSigma1Min(Double_t jFactorSigma1Min)	{dJFactorSigma1Min=jFactorSigma1Min;}
   Bool_t SetdNdOmegaFromJFactor();
+  TGraph* GetTGraphdNdOmegaFromJFactor(TF1* jFactor);
   Bool_t SetJFactorFromReferences(Bool_t verbose=0);
   
   //OTHERS********
@@ -134,6 +148,7 @@ protected:
   
   Double_t TGraphEvaluateJFactorVsTheta(Double_t* x, Double_t* par);
   Double_t TGraphEvaluateJFactorSigma1VsTheta(Double_t* x, Double_t* par);
+  Double_t TGraphEvaluateJFactorBandVsTheta(Double_t* x, Double_t* par);
 
 private:
 
@@ -166,6 +181,9 @@ private:
   ///////////////////////////////////////////////////////
   TGraph* gJFactor;
   TGraph* gJFactorSigma1;
+  TGraph* gJFactorSigma1Plus;		// +1 sigma (84%)
+  TGraph* gJFactorSigma2Minus;		// -2 sigma (2.5%)
+  TGraph* gJFactorSigma2Plus;		// +2 sigma (97.5%)
   
   ///////////////////////////////////////////////////////
   //TF1
@@ -186,6 +204,7 @@ private:
   Bool_t bIsGeringer;
   Bool_t bIsJFactor;
   Bool_t bIsJFactorSigma1;
+  Bool_t bIsJFactorBands;
 };
 
 #endif /* JDDarkMatter_H_ */
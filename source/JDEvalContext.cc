@@ -0,0 +1,79 @@
+/*
+ * JDEvalContext.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 MUTABLE STATE OF ONE EVALUATING THREAD.
+ */
+
+#include "JDEvalContext.h"
+
+#include <TMath.h>
+
+//-----------------------------------------------
+//	Empty buffers (nothing is allocated until the kernel uses them) and no cursor set
+JDEvalContext::JDEvalContext()
+{
+	ResetCursors();
+}
+
+//-----------------------------------------------
+//	It forgets the graphs of the cursors. A cursor is reset by itself when its graph has another address or another
+//	number of points. Call it if a graph has been modified in place, or if it may have been deleted and a new one
+//	with the same number of points created at the same address (the cursor stays in range anyway).
+void JDEvalContext::ResetCursors()
+{
+	for(Int_t c=0; c<kNumCursors; c++)
+	{
+		vGraphs[c] = 0;
+		vNumPoints[c] = 0;
+		vIsSorted[c] = 0;
+		vCursors[c] = 0;
+	}
+}
+
+//-----------------------------------------------
+//	It returns if the abscissas of graph are strictly increasing (needed by the cursors)
+Bool_t JDEvalContext::IsStrictlyIncreasing(const TGraph* graph)
+{
+	const Double_t* x = graph->GetX();
+	for(Int_t i=1; i<graph->GetN(); i++) if(!(x[i]>x[i-1])) return 0;
+	return 1;
+}
+
+//-----------------------------------------------
+//	Linear interpolation of graph at x, with the same result as TGraph::Eval(): exact at the points and extrapolated
+//	from the first/last two points outside the range. The interval [x_i, x_i+1] is searched from the one of the
+//	last call with the same cursor, then among its neighbours and only then by bisection.
+//	If the abscissas are not sorted it calls TGraph::Eval().
+Double_t JDEvalContext::Interpolate(const TGraph* graph, Double_t x, Cursor cursor)
+{
+	Int_t numPoints = graph->GetN();
+	if(graph!=vGraphs[cursor] || numPoints!=vNumPoints[cursor])
+	{
+		vGraphs[cursor] = graph;
+		vNumPoints[cursor] = numPoints;
+		vIsSorted[cursor] = IsStrictlyIncreasing(graph);
+		vCursors[cursor] = 0;
+	}
+	if(!vIsSorted[cursor]) return graph->Eval(x);
+
+	const Double_t* pX = graph->GetX();
+	const Double_t* pY = graph->GetY();
+	if(numPoints==0) return 0.;
+	if(numPoints==1) return pY[0];
+
+	Int_t& low = vCursors[cursor];
+	low = TMath::Max(0,TMath::Min(low,numPoints-2));	// 0 <= low <= numPoints-2
+	if(x<pX[0])								low = 0;
+	else if(x>pX[numPoints-1])				low = numPoints-2;
+	else if(x>=pX[low] && x<=pX[low+1])		{}
+	else if(low+2<numPoints && x>=pX[low+1] && x<=pX[low+2])	low++;
+	else if(low>0 && x>=pX[low-1] && x<=pX[low])				low--;
+	else low = TMath::Min((Int_t)TMath::BinarySearch(numPoints,pX,x),numPoints-2);
+
+	Int_t up = low+1;
+	if(x==pX[low]) return pY[low];
+	if(x==pX[up]) return pY[up];
+	return pY[up]+(x-pX[up])*(pY[low]-pY[up])/(pX[low]-pX[up]);
+}
@@ -0,0 +1,51 @@
+/*
+ * JDEvalContext.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 MUTABLE STATE OF ONE EVALUATING THREAD: THE SCRATCH BUFFERS OF JDQFactorKernel (PARTIAL SUMS AND
+ *  		 EXPRESSION NODES) AND ONE INTERPOLATION CURSOR PER TABLE READ BY THE Evaluate FUNCTIONS OF
+ *  		 JDAstroProfile, JDInstrument AND JDOptimization.
+ *  		 THE INTEGRANDS ARE EVALUATED ALONG SMOOTH PATHS (A phi LOOP AT FIXED theta'), SO THE POINT OF A TGraph
+ *  		 FOUND IN THE LAST CALL IS ALMOST ALWAYS THE ONE OF THE NEXT CALL OR ITS NEIGHBOUR: THE CURSOR MAKES
+ *  		 THE LOOKUP O(1) (TGraph::Eval() SCANS ALL THE POINTS) AND A BINARY SEARCH IS ONLY DONE ON A MISS.
+ *
+ *  		 USE ONE CONTEXT PER THREAD AND REUSE IT BETWEEN CALLS: ONCE THE BUFFERS HAVE GROWN THE HOT PATH DOES
+ *  		 NOT ALLOCATE. CONTEXTS ARE CACHE-LINE ALIGNED AND PADDED, SO AN ARRAY OF THEM (ONE PER THREAD) DOES
+ *  		 NOT SHARE ANY WRITABLE LINE BETWEEN THREADS.
+ */
+
+#ifndef JDEvalContext_H_
+#define JDEvalContext_H_
+
+#include "JDGrid.h"
+
+#include <Rtypes.h>
+#include <TGraph.h>
+
+class alignas(kJDCacheLineSize) JDEvalContext {
+public:
+	// Tables walked with a cursor of their own (the ON and OFF profiles are read at different distances)
+	enum Cursor {kCursordNdOmega=0, kCursordNdOmegaSigma1, kCursordNdOmegaOff, kCursordNdOmegaSigma1Off, kCursorEpsilon, kNumCursors};
+
+	JDEvalContext();
+	virtual ~JDEvalContext() {}
+
+	void ResetCursors();
+
+	//	Linear interpolation of graph at x, as TGraph::Eval() (extrapolated from the first/last two points)
+	Double_t Interpolate(const TGraph* graph, Double_t x, Cursor cursor);
+
+	JDAlignedBuffer vSums;		// JDQFactorKernel: kNumComponents per theta bin
+	JDAlignedBuffer vValues;	// JDQFactorKernel: nodes of the JDQFactorExpression
+
+private:
+	static Bool_t IsStrictlyIncreasing(const TGraph* graph);
+
+	const TGraph* vGraphs[kNumCursors];		// graph each cursor was set for
+	Int_t vNumPoints[kNumCursors];			// and its number of points
+	Bool_t vIsSorted[kNumCursors];			// if not, TGraph::Eval() is used
+	Int_t vCursors[kNumCursors];			// low point of the last interval found
+};
+
+#endif /* JDEvalContext_H_ */
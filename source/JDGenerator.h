@@ -0,0 +1,64 @@
+/*
+ * JDGenerator.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 GENERATOR OF C++20 COROUTINES: A FUNCTION RETURNING JDGenerator<T> THAT co_yield's VALUES CAN BE
+ *  		 ITERATED WITH A RANGE-BASED for, EACH VALUE BEING COMPUTED WHEN THE LOOP ASKS FOR IT (SEE JDQFactorScan::Rows()).
+ *  		 IT IS ONLY DEFINED (JD_WITH_COROUTINES) IF THE COMPILER SUPPORTS COROUTINES: OTHERWISE USE THE CALLBACKS
+ *  		 OR THE Next() LOOPS OF THE SAME CLASSES.
+ */
+
+#ifndef JDGenerator_H_
+#define JDGenerator_H_
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine>=201902L && __has_include(<coroutine>)
+#define JD_WITH_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <utility>
+
+template <typename T>
+class JDGenerator {
+public:
+	class promise_type {
+	public:
+		JDGenerator get_return_object()			{return JDGenerator(std::coroutine_handle<promise_type>::from_promise(*this));}
+		std::suspend_always initial_suspend()	{return {};}
+		std::suspend_always final_suspend() noexcept	{return {};}
+		std::suspend_always yield_value(const T& value)	{pValue=&value; return {};}
+		void return_void() {}
+		void unhandled_exception()				{throw;}
+
+		const T* pValue;
+	};
+
+	class iterator {
+	public:
+		iterator(std::coroutine_handle<promise_type> handle): hCoroutine(handle) {}
+		const T& operator*() const				{return *hCoroutine.promise().pValue;}
+		iterator& operator++()					{hCoroutine.resume(); return *this;}
+		bool operator!=(std::default_sentinel_t) const	{return !hCoroutine.done();}
+
+	private:
+		std::coroutine_handle<promise_type> hCoroutine;
+	};
+
+	JDGenerator(JDGenerator&& other): hCoroutine(std::exchange(other.hCoroutine,nullptr)) {}
+	JDGenerator(const JDGenerator&) = delete;
+	~JDGenerator()								{if(hCoroutine) hCoroutine.destroy();}
+
+	iterator begin()							{hCoroutine.resume(); return iterator(hCoroutine);}
+	std::default_sentinel_t end()				{return {};}
+
+private:
+	explicit JDGenerator(std::coroutine_handle<promise_type> handle): hCoroutine(handle) {}
+
+	std::coroutine_handle<promise_type> hCoroutine;
+};
+
+#endif
+
+#endif /* JDGenerator_H_ */
@@ -0,0 +1,190 @@
+/*
+ * JDGrid.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 LIGHTWEIGHT GRIDS USED FOR THE INTERNAL COMPUTATIONS OF THE OPTIMIZATION.
+ */
+
+#include "JDGrid.h"
+
+#include <TGraph.h>
+#include <TH2.h>
+
+#include <map>
+
+using namespace std;
+
+//-----------------------------------------------
+//	It sets all the bins to value
+void JDGrid2D::Reset(Double_t value)
+{
+	for(Int_t k=0; k<GetSize(); k++) vContent[k]=value;
+}
+
+//-----------------------------------------------
+//	It multiplies all the bins by factor
+void JDGrid2D::Scale(Double_t factor)
+{
+	for(Int_t k=0; k<GetSize(); k++) vContent[k]*=factor;
+}
+
+//-----------------------------------------------
+//	It returns the sum of all the bins
+Double_t JDGrid2D::GetSum() const
+{
+	Double_t sum=0.;
+	for(Int_t k=0; k<GetSize(); k++) sum+=vContent[k];
+	return sum;
+}
+
+//-----------------------------------------------
+//	It returns the maximum content and, if asked, the bins (i,j) where it is found
+Double_t JDGrid2D::GetMaximum(Int_t* iMax, Int_t* jMax) const
+{
+	Int_t kMax=0;
+	for(Int_t k=1; k<GetSize(); k++)
+	{
+		if(vContent[k]>vContent[kMax]) kMax=k;
+	}
+	if(iMax) *iMax = (GetSize()>0? kMax%GetNumBinsX() : 0);
+	if(jMax) *jMax = (GetSize()>0? kMax/GetNumBinsX() : 0);
+	return (GetSize()>0? vContent[kMax] : 0.);
+}
+
+//-----------------------------------------------
+//	It copies the grid (multiplied by scale) into a new TH2D.
+//	This is only meant for plotting: the caller owns the histogram (it is not added to gDirectory, so a histogram
+//	with the same name does not replace it, nor is it deleted with the directory).
+TH2D* JDGrid2D::ToTH2D(const char* name, const char* title, Double_t scale) const
+{
+	TH2D* h2 = new TH2D(name, title,
+			GetNumBinsX(), axisX.GetMin(), axisX.GetMax(),
+			GetNumBinsY(), axisY.GetMin(), axisY.GetMax());
+	h2->SetDirectory(0);
+
+	for(Int_t j=0; j<GetNumBinsY(); j++)
+	{
+		for(Int_t i=0; i<GetNumBinsX(); i++)
+		{
+			h2->SetBinContent(i+1, j+1, GetBinContent(i,j)*scale);
+		}
+	}
+	return h2;
+}
+
+//-----------------------------------------------
+//	Iso-contours content==level by marching squares on the bin centres, with linear interpolation along the cell edges.
+//	Saddle cells are resolved with the mean of their four corners.
+//	Each contour is returned as a TGraph (x, y): closed contours repeat their first point at the end, contours
+//	that reach the border of the grid are open. The caller owns the graphs.
+std::vector<TGraph*> JDGrid2D::GetContours(Double_t level) const
+{
+	std::vector<TGraph*> contours;
+	Int_t numBinsX = GetNumBinsX();
+	Int_t numBinsY = GetNumBinsY();
+	if(numBinsX<2 || numBinsY<2) return contours;
+
+	// Edge (i,j,0) joins the centres (i,j)-(i+1,j), edge (i,j,1) joins (i,j)-(i,j+1)
+	auto getEdgeKey = [&](Int_t i, Int_t j, Int_t direction) {return (Long64_t)2*(i+(Long64_t)numBinsX*j)+direction;};
+	auto getEdgePoint = [&](Long64_t key, Double_t& x, Double_t& y)
+	{
+		Int_t direction = key%2;
+		Int_t i = (key/2)%numBinsX;
+		Int_t j = (key/2)/numBinsX;
+		Double_t v0 = GetBinContent(i,j);
+		Double_t v1 = (direction==0? GetBinContent(i+1,j) : GetBinContent(i,j+1));
+		Double_t f = (v1!=v0? (level-v0)/(v1-v0) : 0.5);
+		x = axisX.GetBinCenter(i)+(direction==0? f*axisX.GetBinWidth() : 0.);
+		y = axisY.GetBinCenter(j)+(direction==1? f*axisY.GetBinWidth() : 0.);
+	};
+
+	// Segments of each cell, as pairs of edges: 0 bottom, 1 right, 2 top, 3 left
+	std::vector<Long64_t> segments;
+	for(Int_t j=0; j<numBinsY-1; j++)
+	{
+		for(Int_t i=0; i<numBinsX-1; i++)
+		{
+			Double_t v00=GetBinContent(i,j), v10=GetBinContent(i+1,j), v11=GetBinContent(i+1,j+1), v01=GetBinContent(i,j+1);
+			Int_t index = (v00>=level) | (v10>=level)<<1 | (v11>=level)<<2 | (v01>=level)<<3;
+			if(index==0 || index==15) continue;
+
+			Long64_t edges[4] = {getEdgeKey(i,j,0), getEdgeKey(i+1,j,1), getEdgeKey(i,j+1,0), getEdgeKey(i,j,1)};
+			Bool_t isCenterAbove = 0.25*(v00+v10+v11+v01)>=level;
+			Int_t pairs[4] = {-1,-1,-1,-1};
+			switch(index)
+			{
+				case 1: case 14:	pairs[0]=3; pairs[1]=0; break;
+				case 2: case 13:	pairs[0]=0; pairs[1]=1; break;
+				case 3: case 12:	pairs[0]=3; pairs[1]=1; break;
+				case 4: case 11:	pairs[0]=1; pairs[1]=2; break;
+				case 6: case 9:		pairs[0]=0; pairs[1]=2; break;
+				case 7: case 8:		pairs[0]=3; pairs[1]=2; break;
+				case 5:
+					if(isCenterAbove)	{pairs[0]=3; pairs[1]=2; pairs[2]=0; pairs[3]=1;}
+					else				{pairs[0]=3; pairs[1]=0; pairs[2]=1; pairs[3]=2;}
+					break;
+				case 10:
+					if(isCenterAbove)	{pairs[0]=3; pairs[1]=0; pairs[2]=1; pairs[3]=2;}
+					else				{pairs[0]=3; pairs[1]=2; pairs[2]=0; pairs[3]=1;}
+					break;
+			}
+			for(Int_t k=0; k<4 && pairs[k]>=0; k+=2)
+			{
+				segments.push_back(edges[pairs[k]]);
+				segments.push_back(edges[pairs[k+1]]);
+			}
+		}
+	}
+
+	// Every edge point is shared by one (border) or two segments: chain them
+	Int_t numSegments = segments.size()/2;
+	std::multimap<Long64_t, Int_t> segmentsOfEdge;
+	for(Int_t s=0; s<numSegments; s++)
+	{
+		segmentsOfEdge.insert(std::make_pair(segments[2*s],s));
+		segmentsOfEdge.insert(std::make_pair(segments[2*s+1],s));
+	}
+
+	std::vector<Bool_t> isUsed(numSegments,0);
+	auto getNextSegment = [&](Long64_t edge, Int_t segment)
+	{
+		auto range = segmentsOfEdge.equal_range(edge);
+		for(auto it=range.first; it!=range.second; ++it) if(it->second!=segment && !isUsed[it->second]) return it->second;
+		return -1;
+	};
+
+	// open contours (start at an edge with only one segment) first, then the closed ones
+	for(Int_t pass=0; pass<2; pass++)
+	{
+		for(Int_t s=0; s<numSegments; s++)
+		{
+			if(isUsed[s]) continue;
+
+			Long64_t start = segments[2*s];
+			if(pass==0)
+			{
+				if(segmentsOfEdge.count(segments[2*s])==1)			start = segments[2*s];
+				else if(segmentsOfEdge.count(segments[2*s+1])==1)	start = segments[2*s+1];
+				else continue;
+			}
+
+			TGraph* contour = new TGraph();
+			Double_t x, y;
+			getEdgePoint(start,x,y);
+			contour->SetPoint(0,x,y);
+
+			Long64_t edge = start;
+			for(Int_t segment=s; segment>=0; segment=getNextSegment(edge,segment))
+			{
+				isUsed[segment]=1;
+				edge = (segments[2*segment]==edge? segments[2*segment+1] : segments[2*segment]);
+				getEdgePoint(edge,x,y);
+				contour->SetPoint(contour->GetN(),x,y);
+			}
+			contours.push_back(contour);
+		}
+	}
+
+	return contours;
+}
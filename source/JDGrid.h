@@ -0,0 +1,153 @@
+/*
+ * JDGrid.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 LIGHTWEIGHT GRIDS USED FOR THE INTERNAL COMPUTATIONS OF THE OPTIMIZATION.
+ *  		 A GRID IS MADE OF AXIS DESCRIPTORS AND ONE CONTIGUOUS, CACHE-LINE ALIGNED BUFFER.
+ *  		 NOTHING IS REGISTERED IN gDirectory AND NO HISTOGRAM IS ALLOCATED WHILE COMPUTING:
+ *  		 THE TH2D IS ONLY PRODUCED AT THE API BOUNDARY (PLOTTING) WITH ToTH2D().
+ *
+ *  		 BINS ARE NUMBERED FROM 0 TO numBins-1 (NO UNDERFLOW/OVERFLOW, UNLIKE ROOT).
+ */
+
+#ifndef JDGrid_H_
+#define JDGrid_H_
+
+#include <Rtypes.h>
+#include <TGraph.h>
+#include <TH2.h>
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+static const Int_t kJDCacheLineSize = 64;	// [bytes]
+
+//-----------------------------------------------
+//	Allocator returning cache-line aligned memory, so that buffers do not share lines
+template <class T>
+class JDAlignedAllocator {
+public:
+	typedef T value_type;
+
+	JDAlignedAllocator() {}
+	template <class U> JDAlignedAllocator(const JDAlignedAllocator<U>&) {}
+
+	T* allocate(std::size_t n)
+	{
+		std::size_t bytes = ((n*sizeof(T)+kJDCacheLineSize-1)/kJDCacheLineSize)*kJDCacheLineSize;
+		void* p = std::aligned_alloc(kJDCacheLineSize, bytes>0? bytes : kJDCacheLineSize);
+		if(!p) throw std::bad_alloc();
+		return static_cast<T*>(p);
+	}
+	void deallocate(T* p, std::size_t) {std::free(p);}
+
+	template <class U> Bool_t operator==(const JDAlignedAllocator<U>&) const {return 1;}
+	template <class U> Bool_t operator!=(const JDAlignedAllocator<U>&) const {return 0;}
+};
+
+typedef std::vector<Double_t, JDAlignedAllocator<Double_t> > JDAlignedBuffer;
+
+//-----------------------------------------------
+//	Uniform axis: numBins bins between min and max
+class JDGridAxis {
+public:
+	JDGridAxis(): iNumBins(0), dMin(0.), dMax(0.), dBinWidth(0.) {}
+	JDGridAxis(Int_t numBins, Double_t min, Double_t max):
+		iNumBins(numBins), dMin(min), dMax(max), dBinWidth(numBins>0? (max-min)/numBins : 0.) {}
+
+	Int_t GetNumBins() const				{return iNumBins;}
+	Double_t GetMin() const					{return dMin;}
+	Double_t GetMax() const					{return dMax;}
+	Double_t GetBinWidth() const			{return dBinWidth;}
+	Double_t GetBinLowEdge(Int_t i) const	{return dMin+i*dBinWidth;}
+	Double_t GetBinCenter(Int_t i) const	{return dMin+(i+0.5)*dBinWidth;}
+
+	// It returns the bin containing x, clamped to [0, numBins-1]
+	Int_t FindBin(Double_t x) const
+	{
+		Int_t i = (dBinWidth>0.? (Int_t)((x-dMin)/dBinWidth) : 0);
+		if(i<0) return 0;
+		if(i>iNumBins-1) return iNumBins-1;
+		return i;
+	}
+
+private:
+	Int_t iNumBins;
+	Double_t dMin;
+	Double_t dMax;
+	Double_t dBinWidth;
+};
+
+//-----------------------------------------------
+//	1D grid: one value per bin, interpolated linearly between bin centres (constant beyond the first and last centres)
+class JDGrid1D {
+public:
+	JDGrid1D() {}
+	JDGrid1D(const JDGridAxis& xAxis, Double_t value=0.):
+		axisX(xAxis), vContent(xAxis.GetNumBins(), value) {}
+
+	const JDGridAxis& GetXaxis() const		{return axisX;}
+	Int_t GetNumBins() const				{return axisX.GetNumBins();}
+	Bool_t IsEmpty() const					{return vContent.empty();}
+
+	Double_t* GetArray()					{return vContent.data();}
+	const Double_t* GetArray() const		{return vContent.data();}
+
+	Double_t GetBinContent(Int_t i) const			{return vContent[i];}
+	void SetBinContent(Int_t i, Double_t value)		{vContent[i]=value;}
+
+	Double_t Interpolate(Double_t x) const
+	{
+		Double_t u = (x-axisX.GetMin())/axisX.GetBinWidth()-0.5;
+		if(u<=0.) return vContent.front();
+		Int_t i = (Int_t)u;
+		if(i>=GetNumBins()-1) return vContent.back();
+		Double_t f = u-i;
+		return vContent[i]+f*(vContent[i+1]-vContent[i]);
+	}
+
+private:
+	JDGridAxis axisX;
+	JDAlignedBuffer vContent;
+};
+
+//-----------------------------------------------
+//	2D grid: value(i,j) is stored at i + numBinsX*j (x runs fastest)
+class JDGrid2D {
+public:
+	JDGrid2D() {}
+	JDGrid2D(const JDGridAxis& xAxis, const JDGridAxis& yAxis, Double_t value=0.):
+		axisX(xAxis), axisY(yAxis), vContent(xAxis.GetNumBins()*yAxis.GetNumBins(), value) {}
+
+	const JDGridAxis& GetXaxis() const		{return axisX;}
+	const JDGridAxis& GetYaxis() const		{return axisY;}
+	Int_t GetNumBinsX() const				{return axisX.GetNumBins();}
+	Int_t GetNumBinsY() const				{return axisY.GetNumBins();}
+	Int_t GetSize() const					{return vContent.size();}
+
+	Double_t* GetArray()					{return vContent.data();}
+	const Double_t* GetArray() const		{return vContent.data();}
+	Double_t* GetRow(Int_t j)				{return vContent.data()+axisX.GetNumBins()*j;}
+	const Double_t* GetRow(Int_t j) const	{return vContent.data()+axisX.GetNumBins()*j;}
+
+	Double_t GetBinContent(Int_t i, Int_t j) const			{return vContent[i+axisX.GetNumBins()*j];}
+	void SetBinContent(Int_t i, Int_t j, Double_t value)	{vContent[i+axisX.GetNumBins()*j]=value;}
+	void AddBinContent(Int_t i, Int_t j, Double_t value)	{vContent[i+axisX.GetNumBins()*j]+=value;}
+
+	void Reset(Double_t value=0.);
+	void Scale(Double_t factor);
+	Double_t GetSum() const;
+	Double_t GetMaximum(Int_t* iMax=0, Int_t* jMax=0) const;
+
+	TH2D* ToTH2D(const char* name, const char* title="", Double_t scale=1.) const;
+	std::vector<TGraph*> GetContours(Double_t level) const;
+
+private:
+	JDGridAxis axisX;
+	JDGridAxis axisY;
+	JDAlignedBuffer vContent;
+};
+
+#endif /* JDGrid_H_ */
@@ -20,6 +20,8 @@
  */
 
 #include "JDInstrument.h"
+#include "JDEvalContext.h"
+#include "JDQuadrature.h"
 
 #include <TGraph.h>
 #include <TMath.h>
@@ -438,14 +440,65 @@ Bool_t JDInstrument::SetCameraAcceptanceFromInstrument(Bool_t verbose)
 	return 0;
 }
 
+//-----------------------------------------------
+// It evaluates the Epsilon [%] at dcc [deg]. Reentrant.
+Double_t JDInstrument::EvaluateEpsilonVsDcc(Double_t dcc) const
+{
+	if (dcc<=dDistCenterCameraMax) 	{  return gCameraAcceptance->Eval(dcc);}
+	else							{  return 1.e-20;}							// To make integrals converge
+}
+
+//-----------------------------------------------
+// It evaluates the Epsilon [%] at theta [deg] and phi [rad] around a source at wobble [deg] from the camera center. Reentrant.
+Double_t JDInstrument::EvaluateEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble) const
+{
+	Double_t dccR = TMath::Power(TMath::Power(wobble,2)+TMath::Power(theta,2)-2*wobble*theta*TMath::Cos(phi+(TMath::Pi()/2)),0.50);
+	return EvaluateEpsilonVsDcc(dccR);
+}
+
+//-----------------------------------------------
+// It evaluates the Epsilon [%] at dcc [deg], with the cursor of context. Reentrant.
+Double_t JDInstrument::EvaluateEpsilonVsDcc(Double_t dcc, JDEvalContext& context) const
+{
+	if (dcc<=dDistCenterCameraMax) 	{  return context.Interpolate(gCameraAcceptance,dcc,JDEvalContext::kCursorEpsilon);}
+	else							{  return 1.e-20;}							// To make integrals converge
+}
+
+//-----------------------------------------------
+// As EvaluateEpsilonVsThetaPhi(theta,phi,wobble), with the cursor of context. Reentrant.
+Double_t JDInstrument::EvaluateEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble, JDEvalContext& context) const
+{
+	Double_t dccR = TMath::Power(TMath::Power(wobble,2)+TMath::Power(theta,2)-2*wobble*theta*TMath::Cos(phi+(TMath::Pi()/2)),0.50);
+	return EvaluateEpsilonVsDcc(dccR,context);
+}
+
+//-----------------------------------------------
+// It evaluates the Efficiency [%] at theta [deg]: the mean Epsilon over the disk of radius theta around a source at
+// wobble [deg] from the camera center. Reentrant: fixed quadrature (see JDQuadrature) in panels of dBinResolution.
+Double_t JDInstrument::EvaluateEfficiencyVsTheta(Double_t theta, Double_t wobble) const
+{
+	JDEvalContext context;
+	return EvaluateEfficiencyVsTheta(theta,wobble,context);
+}
+
+//-----------------------------------------------
+// As EvaluateEfficiencyVsTheta(theta,wobble), with the cursor of context. Reentrant.
+Double_t JDInstrument::EvaluateEfficiencyVsTheta(Double_t theta, Double_t wobble, JDEvalContext& context) const
+{
+	Double_t integral = JDQuadrature::IntegrateDisk([this,wobble,&context](Double_t thetaNode, Double_t phi)
+	{
+		return EvaluateEpsilonVsThetaPhi(thetaNode,phi,wobble,context);
+	},theta,dBinResolution,bIsSphericalCoordinates);
+	return integral/(TMath::Pi()*TMath::Power(theta,2));
+}
+
 //-----------------------------------------------
 // It evaluates the Epsilon [%] vs Dcc [deg]
 //
 // x[0] 	= Dcc [deg]
 Double_t JDInstrument::EpsilonVsDcc(Double_t* x, Double_t* par)
 {
-	if (x[0]<=GetDistCameraCenterMax()) {  return gCameraAcceptance->Eval(x[0]);}
-	else							 	{  return 1.e-20;}							// To make integrals converge
+	return EvaluateEpsilonVsDcc(x[0]);
 }
 
 //-----------------------------------------------
@@ -458,8 +511,7 @@ Double_t JDInstrument::EpsilonVsXAndY(Double_t* x, Double_t* par)
 	Double_t theta = TMath::Sqrt(TMath::Power(x[0],2)+TMath::Power(x[1],2));
 	Double_t phi = TMath::ATan2(x[1],x[0]);
 
-	fEpsilonVsThetaPhi->SetParameter(0,par[0]);
-	return fEpsilonVsThetaPhi->Eval(theta,phi);
+	return EvaluateEpsilonVsThetaPhi(theta,phi,par[0]);
 }
 
 //-----------------------------------------------
@@ -473,10 +525,7 @@ Double_t JDInstrument::EpsilonVsXAndY(Double_t* x, Double_t* par)
 //  dcc = distance camera center [deg]
 Double_t JDInstrument::EpsilonVsThetaPhi(Double_t* x, Double_t* par)
 {
-	Double_t dccR = TMath::Power(TMath::Power(par[0],2)+TMath::Power(x[0],2)-2*par[0]*x[0]*TMath::Cos(x[1]+(TMath::Pi()/2)),0.50);
-
-	if (dccR<=GetDistCameraCenterMax()) {  return gCameraAcceptance->Eval(dccR);}
-	else							 	{  return 1.e-20;}							// To make integrals converge
+	return EvaluateEpsilonVsThetaPhi(x[0],x[1],par[0]);
 }
 
 //-----------------------------------------------
@@ -489,16 +538,15 @@ Double_t JDInstrument::EpsilonThetaVsThetaPhi(Double_t* x, Double_t* par)
 {
 
 	Double_t X0rad =x[0]*dDeg2Rad;
-	fEpsilonVsThetaPhi->SetParameter(0,par[0]);
 
 	if (GetIsSphericalCoordinates()==1)
 	{
-		return fEpsilonVsThetaPhi->Eval(x[0], x[1])*TMath::Sin(X0rad);
+		return EvaluateEpsilonVsThetaPhi(x[0],x[1],par[0])*TMath::Sin(X0rad);
 	}
 
 	else
 	{
-		return fEpsilonVsThetaPhi->Eval(x[0], x[1])*x[0];
+		return EvaluateEpsilonVsThetaPhi(x[0],x[1],par[0])*x[0];
 	}
 }
 
@@ -508,10 +556,7 @@ Double_t JDInstrument::EpsilonThetaVsThetaPhi(Double_t* x, Double_t* par)
 //	x[0] = theta [deg]
 Double_t JDInstrument::EfficiencyVsTheta(Double_t* x, Double_t* par)
 {
-	Double_t X0rad =x[0]*dDeg2Rad;
-	fEpsilonThetaVsThetaPhi->SetParameter(0,par[0]);
-
-	return fEpsilonThetaVsThetaPhi->Integral(0., x[0], 0., 2*TMath::Pi(), 1.e-2)/(TMath::Pi()*TMath::Power(x[0],2));
+	return EvaluateEfficiencyVsTheta(x[0],par[0]);
 }
 
 //-----------------------------------------------
@@ -27,7 +27,7 @@
 #include <TF2.h>
 #include <TH2.h>
 
-
+class JDEvalContext;
 
 class JDInstrument {
 public:
@@ -57,6 +57,7 @@ public:
 	TString GetInstrumentPath()			{return sInstrumentPath;}
 
 	Int_t GetNumPointsCameraAcceptanceGraph()	{return iNumPointsCameraAcceptanceGraph;}
+	TGraph* GetTGraphCameraAcceptance()			{return gCameraAcceptance;}
 
 	Double_t GetDistCameraCenterMax()	{return dDistCenterCameraMax;}
 	Double_t GetWobbleDistance()		{return dWobbleDist;}
@@ -102,6 +103,16 @@ public:
 	void SetInstrumentName(TString instrumentName)				{sInstrumentName=instrumentName;}
 	void SetInstrumentPath(TString instrumentPath)				{sInstrumentPath=instrumentPath;}
 
+	//Reentrant evaluation: const, with the wobble as an argument and without touching any TF1/TF2,
+	//so many threads can call them at the same time. The versions with a JDEvalContext (one per thread)
+	//walk the camera acceptance with its cursor.
+	Double_t EvaluateEpsilonVsDcc(Double_t dcc) const;
+	Double_t EvaluateEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble) const;
+	Double_t EvaluateEfficiencyVsTheta(Double_t theta, Double_t wobble) const;
+	Double_t EvaluateEpsilonVsDcc(Double_t dcc, JDEvalContext& context) const;
+	Double_t EvaluateEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble, JDEvalContext& context) const;
+	Double_t EvaluateEfficiencyVsTheta(Double_t theta, Double_t wobble, JDEvalContext& context) const;
+
 protected:
 
 	//Setters********
@@ -35,28 +35,37 @@
 #include <TString.h>
 #include <TVirtualPad.h>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <vector>
 #include <TStyle.h>
+#include <Math/BrentMinimizer1D.h>
+#include <Math/Functor.h>
 
 #include "JDOptimization.h"
 #include "JDDarkMatter.h"
 #include "JDInstrument.h"
+#include "JDEvalContext.h"
 
 using namespace std;
 
 const static Double_t binResolution = 0.05;
+const static Double_t smearingCoreResolution = 0.01;
 //-----------------------------------------------
 //
 //	This is the constructor used when the data is given by a txt file
 //  It fills a constructor with the necessary data depending on the instrument used
 //	It redirects us to CreateFunctionDM()
 JDOptimization::	JDOptimization(TString txtFile, TString myInstrumentPath, TString instrumentName, Double_t distCameraCenter, Double_t wobble):
-fQ0FactorVsTheta(NULL), fQ1FactorVsTheta(NULL), fQ2FactorVsTheta(NULL), fQ3FactorVsTheta(NULL),
-fQ12FactorVsTheta(NULL), fQ13FactorVsTheta(NULL), fQ23FactorVsTheta(NULL), fQ123FactorVsTheta(NULL),
-fQ0FactorVsThetaWobble(NULL),fQ1FactorVsThetaWobble(NULL),fQ2FactorVsThetaWobble(NULL), fQ3FactorVsThetaWobble(NULL),
-fQ12FactorVsThetaWobble(NULL), fQ13FactorVsThetaWobble(NULL), fQ23FactorVsThetaWobble(NULL),
-fQ123FactorVsThetaWobble(NULL),bIsJFactorOnLessOff(1),
+gdNdOmegaSmeared(NULL), gdNdOmegaSigma1Smeared(NULL),
 dDeg2Rad(TMath::Pi()/180.), dBinResolution(binResolution),
-bIsdNdOmegaSmeared(0), bIsdNdOmegaSigma1Smeared(0)
+dSmearingCoreResolution(smearingCoreResolution), bIsSmearingAdaptive(1),
+bIsJFactorOnLessOff(1),
+bIsdNdOmegaSmeared(0), bIsdNdOmegaSigma1Smeared(0),
+qFactorKernel(NULL), taskScheduler(NULL), iNumThreads(0), bIsQFactorKernelSpecialized(1), iReductionMode(JDReduction::kDeterministic), surfaceStore(NULL), dCheckpointInterval(60.),
+iOptimizationMode(kGridScan), dTolerance(0.30), iNumQFactorEvaluations(0), bIsVerbose(1)
 {
 
 	cout << endl;
@@ -110,13 +119,13 @@ bIsdNdOmegaSmeared(0), bIsdNdOmegaSigma1Smeared(0)
 //  distCameraCenter = (Double_t) distance to the center of the camera
 //	wobble			= (Double_t) wobble distance
 JDOptimization::JDOptimization(TString author, TString source, TString candidate, TString mySourcePath, TString myInstrumentPath, TString instrumentName, Double_t distCameraCenter, Double_t wobble):
-fQ0FactorVsTheta(NULL), fQ1FactorVsTheta(NULL), fQ2FactorVsTheta(NULL), fQ3FactorVsTheta(NULL),
-fQ12FactorVsTheta(NULL), fQ13FactorVsTheta(NULL), fQ23FactorVsTheta(NULL), fQ123FactorVsTheta(NULL),
-fQ0FactorVsThetaWobble(NULL),fQ1FactorVsThetaWobble(NULL),fQ2FactorVsThetaWobble(NULL), fQ3FactorVsThetaWobble(NULL),
-fQ12FactorVsThetaWobble(NULL), fQ13FactorVsThetaWobble(NULL), fQ23FactorVsThetaWobble(NULL),
-fQ123FactorVsThetaWobble(NULL),bIsJFactorOnLessOff(1),
+gdNdOmegaSmeared(NULL), gdNdOmegaSigma1Smeared(NULL),
 dDeg2Rad(TMath::Pi()/180.), dBinResolution(binResolution),
-bIsdNdOmegaSmeared(0), bIsdNdOmegaSigma1Smeared(0)
+dSmearingCoreResolution(smearingCoreResolution), bIsSmearingAdaptive(1),
+bIsJFactorOnLessOff(1),
+bIsdNdOmegaSmeared(0), bIsdNdOmegaSigma1Smeared(0),
+qFactorKernel(NULL), taskScheduler(NULL), iNumThreads(0), bIsQFactorKernelSpecialized(1), iReductionMode(JDReduction::kDeterministic), surfaceStore(NULL), dCheckpointInterval(60.),
+iOptimizationMode(kGridScan), dTolerance(0.30), iNumQFactorEvaluations(0), bIsVerbose(1)
 {
 	    cout << endl;
 		cout << endl;
@@ -160,29 +169,47 @@ bIsdNdOmegaSmeared(0), bIsdNdOmegaSigma1Smeared(0)
 		CreateFunctions();
 }
 
+//-----------------------------------------------
+//	This is the constructor used when the dark matter and the instrument are already loaded, so that several
+//	JDOptimization can share them (see JDCampaign). They are not copied: they must live longer than this object.
+//
+//	The inputs are:
+//	darkMatter		= (JDDarkMatter*) dark matter halo and candidate
+//	instrument		= (JDInstrument*) instrument, with its wobble distance
+JDOptimization::JDOptimization(JDDarkMatter* darkMatter, JDInstrument* instrument):
+jdDarkMatter(darkMatter), jdInstrument(instrument),
+gdNdOmegaSmeared(NULL), gdNdOmegaSigma1Smeared(NULL),
+dDeg2Rad(TMath::Pi()/180.), dBinResolution(binResolution),
+dSmearingCoreResolution(smearingCoreResolution), bIsSmearingAdaptive(1),
+bIsJFactorOnLessOff(1),
+bIsdNdOmegaSmeared(0), bIsdNdOmegaSigma1Smeared(0),
+qFactorKernel(NULL), taskScheduler(NULL), iNumThreads(0), bIsQFactorKernelSpecialized(1), iReductionMode(JDReduction::kDeterministic), surfaceStore(NULL), dCheckpointInterval(60.),
+iOptimizationMode(kGridScan), dTolerance(0.30), iNumQFactorEvaluations(0), bIsVerbose(1)
+{
+	cout << endl;
+	cout << endl;
+	cout << "   Constructor JDOptimization..." << endl;
+	cout << endl;
+	cout << endl;
+
+	CreateFunctions();
+}
+
 //-----------------------------------------------
 //
 //	This is the destructor.
 //  It deletes the functions in order not to be reused
 JDOptimization::~JDOptimization()
 {
-	if (fQ0FactorVsTheta)						delete fQ0FactorVsTheta;
-	if (fQ1FactorVsTheta)						delete fQ1FactorVsTheta;
-	if (fQ2FactorVsTheta)						delete fQ2FactorVsTheta;
-	if (fQ3FactorVsTheta)						delete fQ3FactorVsTheta;
-	if (fQ12FactorVsTheta)						delete fQ12FactorVsTheta;
-	if (fQ13FactorVsTheta)						delete fQ13FactorVsTheta;
-	if (fQ23FactorVsTheta)						delete fQ23FactorVsTheta;
-	if (fQ123FactorVsTheta)						delete fQ123FactorVsTheta;
-
-	if (fQ0FactorVsThetaWobble)					delete fQ0FactorVsThetaWobble;
-	if (fQ1FactorVsThetaWobble)					delete fQ1FactorVsThetaWobble;
-	if (fQ2FactorVsThetaWobble)					delete fQ2FactorVsThetaWobble;
-	if (fQ3FactorVsThetaWobble)					delete fQ3FactorVsThetaWobble;
-	if (fQ12FactorVsThetaWobble)				delete fQ12FactorVsThetaWobble;
-	if (fQ13FactorVsThetaWobble)				delete fQ13FactorVsThetaWobble;
-	if (fQ23FactorVsThetaWobble)				delete fQ23FactorVsThetaWobble;
-	if (fQ123FactorVsThetaWobble)				delete fQ123FactorVsThetaWobble;
+	for(std::map<Int_t, TF1*>::iterator it=mapTF1QFactorVsTheta.begin(); it!=mapTF1QFactorVsTheta.end(); it++)						delete it->second;
+	for(std::map<Int_t, TF2*>::iterator it=mapTF2QFactorVsThetaWobble.begin(); it!=mapTF2QFactorVsThetaWobble.end(); it++)	delete it->second;
+
+	ClearGridsQFactorVsThetaWobble();
+	if (gdNdOmegaSmeared)						delete gdNdOmegaSmeared;
+	if (gdNdOmegaSigma1Smeared)					delete gdNdOmegaSigma1Smeared;
+	if (qFactorKernel)							delete qFactorKernel;
+	if (taskScheduler)							delete taskScheduler;
+	if (surfaceStore)							delete surfaceStore;
 
 	cout << endl;
 	cout << endl;
@@ -210,1214 +237,1448 @@ void JDOptimization::CreateFunctions()
 	//	Angular Resoloution:					Q4 = J_on*PSF/theta
 
 
-		fQ0FactorVsTheta = new TF1("fQ0FactorVsTheta", this, &JDOptimization::Q0FactorVsTheta, 1e-3, GetThetaMax(), 1, "JDOptimization", "Q0FactorVsTheta");
-		fQ1FactorVsTheta = new TF1("fQ1FactorVsTheta", this, &JDOptimization::Q1FactorVsTheta, 1e-3, GetThetaMax(), 1, "JDOptimization", "Q1FactorVsTheta");
-		fQ2FactorVsTheta = new TF1("fQ2FactorVsTheta", this, &JDOptimization::Q2FactorVsTheta, 1e-3, GetThetaMax(), 1, "JDOptimization", "Q2FactorVsTheta");
-		fQ3FactorVsTheta = new TF1("fQ3FactorVsTheta", this, &JDOptimization::Q3FactorVsTheta, 1e-3, GetThetaMax(), 1, "JDOptimization", "Q3FactorVsTheta");
-		fQ12FactorVsTheta = new TF1("fQ12FactorVsTheta", this, &JDOptimization::Q12FactorVsTheta, 1e-3, GetThetaMax(), 1, "JDOptimization", "Q12FactorVsTheta");
-		fQ13FactorVsTheta = new TF1("fQ13FactorVsTheta", this, &JDOptimization::Q13FactorVsTheta, 1e-3, GetThetaMax(), 1, "JDOptimization", "Q13FactorVsTheta");
-		fQ23FactorVsTheta = new TF1("fQ23FactorVsTheta", this, &JDOptimization::Q23FactorVsTheta, 1e-3, GetThetaMax(), 1, "JDOptimization", "Q23FactorVsTheta");
-		fQ123FactorVsTheta = new TF1("fQ123FactorVsTheta", this, &JDOptimization::Q123FactorVsTheta, 1e-3, GetThetaMax(), 1, "JDOptimization", "Q123FactorVsTheta");
-
-		fQ0FactorVsThetaWobble = new TF2("fQ0FactorVsThetaWobble", this, &JDOptimization::Q0FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q0FactorVsThetaWobble");
-		fQ1FactorVsThetaWobble = new TF2("fQ1FactorVsThetaWobble", this, &JDOptimization::Q1FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q1FactorVsThetaWobble");
-		fQ2FactorVsThetaWobble = new TF2("fQ2FactorVsThetaWobble", this, &JDOptimization::Q2FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q2FactorVsThetaWobble");
-		fQ3FactorVsThetaWobble = new TF2("fQ3FactorVsThetaWobble", this, &JDOptimization::Q3FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q3FactorVsThetaWobble");
-		fQ4FactorVsThetaWobble = new TF2("fQ4FactorVsThetaWobble", this, &JDOptimization::Q4FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q4FactorVsThetaWobble");
-		fQ12FactorVsThetaWobble = new TF2("fQ12FactorVsThetaWobble", this, &JDOptimization::Q12FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q12FactorVsThetaWobble");
-		fQ13FactorVsThetaWobble = new TF2("fQ13FactorVsThetaWobble", this, &JDOptimization::Q13FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q13FactorVsThetaWobble");
-		fQ14FactorVsThetaWobble = new TF2("fQ14FactorVsThetaWobble", this, &JDOptimization::Q14FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q14FactorVsThetaWobble");
-		fQ23FactorVsThetaWobble = new TF2("fQ23FactorVsThetaWobble", this, &JDOptimization::Q23FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q23FactorVsThetaWobble");
-		fQ24FactorVsThetaWobble = new TF2("fQ24FactorVsThetaWobble", this, &JDOptimization::Q24FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q24FactorVsThetaWobble");
-		fQ34FactorVsThetaWobble = new TF2("fQ34FactorVsThetaWobble", this, &JDOptimization::Q34FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q34FactorVsThetaWobble");
-		fQ123FactorVsThetaWobble = new TF2("fQ123FactorVsThetaWobble", this, &JDOptimization::Q123FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q123FactorVsThetaWobble");
-		fQ124FactorVsThetaWobble = new TF2("fQ124FactorVsThetaWobble", this, &JDOptimization::Q124FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q124FactorVsThetaWobble");
-		fQ134FactorVsThetaWobble = new TF2("fQ134FactorVsThetaWobble", this, &JDOptimization::Q134FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q134FactorVsThetaWobble");
-		fQ234FactorVsThetaWobble = new TF2("fQ234FactorVsThetaWobble", this, &JDOptimization::Q234FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q234FactorVsThetaWobble");
-		fQ1234FactorVsThetaWobble = new TF2("f1Q234FactorVsThetaWobble", this, &JDOptimization::Q1234FactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(),2, "JDOptimization", "Q1234FactorVsThetaWobble");
-
-
-		// Integrated...ThetaVsThetaPhi
-		fIntegratedNdOmegaEpsilonThetaVsTheta = new TF1("fIntegratedNdOmegaEpsilonThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaEpsilonThetaVsTheta,0.,GetThetaMax(),1,"JDOptimization","IntegratedNdOmegaEpsilonThetaVsTheta");
-		fIntegratedNdOmegaSmearedThetaVsTheta = new TF1("fIntegratedNdOmegaSmearedThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaSmearedThetaVsTheta,0.,GetThetaMax(),0,"JDOptimization","IntegratedNdOmegaSmearedThetaVsTheta");
-		fIntegratedNdOmegaSmearedEpsilonThetaVsTheta = new TF1("fIntegratedNdOmegaSmearedEpsilonThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaSmearedEpsilonThetaVsTheta,0.,GetThetaMax(),1,"JDOptimization","IntegratedNdOmegaSmearedEpsilonThetaVsTheta");
-		fIntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta = new TF1("fIntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta,0.,GetThetaMax(),1,"JDOptimization","IntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta");
-		fIntegratedNdOmegaSmearedEpsilonOffThetaVsTheta = new TF1("fIntegratedNdOmegaSmearedEpsilonOffThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaSmearedEpsilonOffThetaVsTheta,0.,GetThetaMax(),1,"JDOptimization","IntegratedNdOmegaSmearedEpsilonOffThetaVsTheta");
-		fIntegratedNdOmegaSigma1SmearedEpsilonOffThetaVsTheta = new TF1("fIntegratedNdOmegaSigma1SmearedEpsilonOffThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaSigma1SmearedEpsilonOffThetaVsTheta,0.,GetThetaMax(),1,"JDOptimization","IntegratedNdOmegaSigma1SmearedEpsilonOffThetaVsTheta");
-		fIntegratedNdOmegaSmearedOffThetaVsTheta = new TF1("fIntegratedNdOmegaSmearedOffThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaSmearedOffThetaVsTheta,0.,GetThetaMax(),1,"JDOptimization","IntegratedNdOmegaSmearedOffThetaVsTheta");
-		fIntegratedNdOmegaSigma1EpsilonThetaVsTheta = new TF1("fIntegratedNdOmegaSigma1EpsilonThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaSigma1EpsilonThetaVsTheta,0.,GetThetaMax(),1,"JDOptimization","IntegratedNdOmegaSigma1EpsilonThetaVsTheta");
-		fIntegratedNdOmegaOffEpsilonThetaVsTheta = new TF1("fIntegratedNdOmegaOffEpsilonThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaOffEpsilonThetaVsTheta,0.,GetThetaMax(),1,"JDOptimization","IntegratedNdOmegaOffEpsilonThetaVsTheta");
-		fIntegratedNdOmegaSigma1OffEpsilonThetaVsTheta = new TF1("fIntegratedNdOmegaSigmaOff1EpsilonThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaSigma1OffEpsilonThetaVsTheta,0.,GetThetaMax(),1,"JDOptimization","IntegratedNdOmegaSigma1OffEpsilonThetaVsTheta");
-		fIntegratedNdOmegaSigma1SmearedThetaVsTheta = new TF1("fIntegratedNdOmegaSigma1SmearedThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaSigma1SmearedThetaVsTheta,0.,GetThetaMax(),1,"JDOptimization","IntegratedNdOmegaSigma1SmearedThetaVsTheta");
-		fIntegratedNdOmegaSigma1SmearedOffThetaVsTheta = new TF1("fIntegratedNdOmegaSigma1SmearedOffThetaVsTheta",this,&JDOptimization::IntegratedNdOmegaSigma1SmearedOffThetaVsTheta,0.,GetThetaMax(),1,"JDOptimization","IntegratedNdOmegaSigma1SmearedOffThetaVsTheta");
-
-		// ...ThetaVsThetaPhi
-		fdNdOmegaSmearedThetaVsThetaPhi = new TF2("fdNdOmegaSmearedThetaVsThetaPhi", this, &JDOptimization::dNdOmegaSmearedThetaVsThetaPhi,1e-3.,GetThetaMax(),0.,2*TMath::Pi(),0, "JDOptimization", "dNdOmegaSmearedThetaVsThetaPhi");
-		fdNdOmegaSmearedOffThetaVsThetaPhi = new TF2("fdNdOmegaSmearedOffThetaVsThetaPhi", this, &JDOptimization::dNdOmegaSmearedOffThetaVsThetaPhi,1e-3.,GetThetaMax(),0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSmearedOffThetaVsThetaPhi");
-		fdNdOmegaEpsilonThetaVsThetaPhi = new TF2("fdNdOmegaEpsilonThetaVsThetaPhi", this, &JDOptimization::dNdOmegaEpsilonThetaVsThetaPhi,1e-3.,GetThetaMax(),0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaEpsilonThetaVsThetaPhi");
-		fdNdOmegaSmearedEpsilonThetaVsThetaPhi = new TF2("fdNdOmegaSmearedEpsilonThetaVsThetaPhi", this, &JDOptimization::dNdOmegaSmearedEpsilonThetaVsThetaPhi,1e-3.,GetThetaMax(),0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSmearedEpsilonThetaVsThetaPhi");
-		fdNdOmegaSigma1SmearedEpsilonThetaVsThetaPhi = new TF2("fdNdOmegaSigma1SmearedEpsilonThetaVsThetaPhi", this, &JDOptimization::dNdOmegaSigma1SmearedEpsilonThetaVsThetaPhi,1e-3.,GetThetaMax(),0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSigma1SmearedEpsilonThetaVsThetaPhi");
-		fdNdOmegaSmearedEpsilonOffThetaVsThetaPhi = new TF2("fdNdOmegaSmearedEpsilonThetaVsThetaPhi", this, &JDOptimization::dNdOmegaSmearedEpsilonOffThetaVsThetaPhi,1e-3.,GetThetaMax(),0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSmearedEpsilonOffThetaVsThetaPhi");
-		fdNdOmegaSigma1SmearedEpsilonOffThetaVsThetaPhi = new TF2("fdNdOmegaSigma1SmearedEpsilonThetaVsThetaPhi", this, &JDOptimization::dNdOmegaSigma1SmearedEpsilonOffThetaVsThetaPhi,1e-3.,GetThetaMax(),0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSigma1SmearedEpsilonOffThetaVsThetaPhi");
-		fdNdOmegaOffEpsilonThetaVsThetaPhi = new TF2("fdNdOmegaOffEpsilonThetaVsThetaPhi", this, &JDOptimization::dNdOmegaOffEpsilonThetaVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),1, "JDOptimization", "dNdOmegaOffEpsilonThetaVsThetaPhi");
-		fdNdOmegaSigma1EpsilonThetaVsThetaPhi = new TF2("fdNdOmegaSigma1EpsilonThetaVsThetaPhi", this, &JDOptimization::dNdOmegaSigma1EpsilonThetaVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSigma1EpsilonThetaVsThetaPhi");
-		fdNdOmegaSigma1OffEpsilonThetaVsThetaPhi = new TF2("fdNdOmegaSigma1OffEpsilonThetaVsThetaPhi", this, &JDOptimization::dNdOmegaSigma1OffEpsilonThetaVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSigma1OffEpsilonThetaVsThetaPhi");
-		fdNdOmegaSigma1SmearedThetaVsThetaPhi = new TF2("fdNdOmegaSigma1SmearedThetaVsThetaPhi", this, &JDOptimization::dNdOmegaSigma1SmearedThetaVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSigma1SmearedThetaVsThetaPhi");
-		fdNdOmegaSigma1SmearedOffThetaVsThetaPhi = new TF2("fdNdOmegaSigma1SmearedOffThetaVsThetaPhi", this, &JDOptimization::dNdOmegaSigma1SmearedOffThetaVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSigma1SmearedOffThetaVsThetaPhi");
-
-		// ...VsThetaPhi
+		// The QFactors are created when asked (see GetTF1QFactorVsTheta() and GetTF2QFactorVsThetaWobble())
+
+		// dN/dOmega (smeared) of the kernel (see InitQFactorKernel())
 		fdNdOmegaSmearedVsTheta = new TF1("fdNdOmegaSmearedVsTheta", this, &JDOptimization::dNdOmegaSmearedVsTheta, 1e-3, GetThetaMax(),0, "JDOptimization", "dNdOmegaSmearedVsTheta");
 		fdNdOmegaSigma1SmearedVsTheta = new TF1("fdNdOmegaSigma1SmearedVsTheta", this, &JDOptimization::dNdOmegaSigma1SmearedVsTheta, 1e-3, GetThetaMax(), 0, "JDOptimization", "dNdOmegaSigma1SmearedVsTheta");
 
-		fdNdOmegaSmearedOffVsThetaPhi = new TF2("fdNdOmegaSmearedOffVsThetaPhi", this, &JDOptimization::dNdOmegaSmearedOffVsThetaPhi, 1e-3, GetThetaMax(), 0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSmearedOffVsThetaPhi");
-		fdNdOmegaEpsilonVsThetaPhi = new TF2("fdNdOmegaEpsilonVsThetaPhi", this, &JDOptimization::dNdOmegaEpsilonVsThetaPhi, 1e-3, GetThetaMax(), 0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaEpsilonVsThetaPhi");
-		fdNdOmegaSmearedEpsilonVsThetaPhi = new TF2("fdNdOmegaSmearedEpsilonVsThetaPhi", this, &JDOptimization::dNdOmegaSmearedEpsilonVsThetaPhi, 1e-3, GetThetaMax(), 0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSmearedEpsilonVsThetaPhi");
-		fdNdOmegaSigma1SmearedEpsilonVsThetaPhi = new TF2("fdNdOmegaSigma1SmearedEpsilonVsThetaPhi", this, &JDOptimization::dNdOmegaSigma1SmearedEpsilonVsThetaPhi, 1e-3, GetThetaMax(), 0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSigma1SmearedEpsilonVsThetaPhi");
-		fdNdOmegaSmearedEpsilonOffVsThetaPhi = new TF2("fdNdOmegaSmearedEpsilonOffVsThetaPhi", this, &JDOptimization::dNdOmegaSmearedEpsilonOffVsThetaPhi, 1e-3, GetThetaMax(), 0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSmearedEpsilonOffVsThetaPhi");
-		fdNdOmegaSigma1SmearedEpsilonOffVsThetaPhi = new TF2("fdNdOmegaSigma1SmearedEpsilonOffVsThetaPhi", this, &JDOptimization::dNdOmegaSigma1SmearedEpsilonOffVsThetaPhi, 1e-3, GetThetaMax(), 0.,2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSigma1SmearedEpsilonOffVsThetaPhi");
-		fdNdOmegaSigma1EpsilonVsThetaPhi = new TF2("fdNdOmegaSigma1EpsilonVsThetaPhi", this, &JDOptimization::dNdOmegaSigma1EpsilonVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSigma1EpsilonVsThetaPhi");
-		fdNdOmegaOffEpsilonVsThetaPhi = new TF2("fdNdOmegaOffEpsilonVsThetaPhi", this, &JDOptimization::dNdOmegaOffEpsilonVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),1, "JDOptimization", "dNdOmegaOffEpsilonVsThetaPhi");
-		fdNdOmegaSigma1OffEpsilonVsThetaPhi = new TF2("fdNdOmegaSigma1OffEpsilonVsThetaPhi", this, &JDOptimization::dNdOmegaSigma1OffEpsilonVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSigma1OffEpsilonVsThetaPhi");
-		fdNdOmegaSigma1SmearedOffVsThetaPhi = new TF2("fdNdOmegaSigma1SmearedOffVsThetaPhi", this, &JDOptimization::dNdOmegaSigma1SmearedOffVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),1, "JDOptimization", "dNdOmegaSigma1SmearedOffVsThetaPhi");
-
+		// ...VsThetaPhi and ...ThetaVsThetaPhi at the nominal wobble distance
+		fdNdOmegaEpsilonVsThetaPhi = new TF2("fdNdOmegaEpsilonVsThetaPhi", this, &JDOptimization::dNdOmegaEpsilonVsThetaPhi, 1e-3, GetThetaMax(), 0.,2*TMath::Pi(),0, "JDOptimization", "dNdOmegaEpsilonVsThetaPhi");
+		fdNdOmegaOffEpsilonVsThetaPhi = new TF2("fdNdOmegaOffEpsilonVsThetaPhi", this, &JDOptimization::dNdOmegaOffEpsilonVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),0, "JDOptimization", "dNdOmegaOffEpsilonVsThetaPhi");
+		fdNdOmegaEpsilonThetaVsThetaPhi = new TF2("fdNdOmegaEpsilonThetaVsThetaPhi", this, &JDOptimization::dNdOmegaEpsilonThetaVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),0, "JDOptimization", "dNdOmegaEpsilonThetaVsThetaPhi");
+		fdNdOmegaOffEpsilonThetaVsThetaPhi = new TF2("fdNdOmegaOffEpsilonThetaVsThetaPhi", this, &JDOptimization::dNdOmegaOffEpsilonThetaVsThetaPhi, 1e-3, GetThetaMax(), 0., 2*TMath::Pi(),0, "JDOptimization", "dNdOmegaOffEpsilonThetaVsThetaPhi");
 
-}
-
-//----------------------------------------------------
-//	It evaluates the Q0Factor vs Theta normalized at a chosen point of normalization
-//
-//  Q0 = (JFactor/Theta)
-//  x[0] 	= theta	[deg]
-//  par[0] 	= theta of normalization [deg]
-Double_t JDOptimization::Q0FactorVsTheta(Double_t* x, Double_t* par)
-{
-	if(par[0]<0.)
-	{
-		return (jdDarkMatter->GetTF1IntegratedNdOmegaVsTheta()->Eval(x[0])/x[0]);
-	}
-	else
-	{
-		return (jdDarkMatter->GetTF1IntegratedNdOmegaVsTheta()->Eval(x[0])/x[0])
-			 /(jdDarkMatter->GetTF1IntegratedNdOmegaVsTheta()->Eval(par[0])/par[0]);
-	}
-}
-
-//----------------------------------------------------
-//	It evaluates the Q1Factor vs Theta normalized at a chosen point of normalization
-//
-//	Q1 = Q1 = J_on-J_off/theta
-//  x[0] 	= theta	[deg]
-//  par[0] 	= theta of normalization [deg]
-Double_t JDOptimization::Q1FactorVsTheta(Double_t* x, Double_t* par)
-{
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
-	{
-		if (par[0]<0.)
-			{
-				return (jdDarkMatter->GetTF1IntegratedNdOmegaVsTheta()->Eval(x[0]) -
-						jdDarkMatter->GetTF1IntegratedNdOmegaOffVsTheta(2*GetWobbleDistance())->Eval(x[0]))/x[0];
-			}
-			else
-			{
-				return ((jdDarkMatter->GetTF1IntegratedNdOmegaVsTheta()->Eval(x[0]) -
-						jdDarkMatter->GetTF1IntegratedNdOmegaOffVsTheta(2*GetWobbleDistance())->Eval(x[0]))/x[0])
-						/
-						((jdDarkMatter->GetTF1IntegratedNdOmegaVsTheta()->Eval(par[0]) -
-						jdDarkMatter->GetTF1IntegratedNdOmegaOffVsTheta(2*GetWobbleDistance())->Eval(par[0]))/par[0]);
-			}
-	}
-	// NOT CORRECT IF YOU DONT DEFINE A & B
-	else
-	{
-		if (par[0]<0.)
-		{
-			return (jdDarkMatter->GetTF1IntegratedNdOmegaVsTheta()->Eval(x[0]))/
-					 TMath::Sqrt(
-					 TMath::Power(x[0],2)+
-					 jdDarkMatter->GetTF1IntegratedNdOmegaOffVsTheta(2*GetWobbleDistance())->Eval(x[0]));
-		}
-		else
-		{
-		 return ((jdDarkMatter->GetTF1IntegratedNdOmegaVsTheta()->Eval(x[0]))/
-					 TMath::Sqrt(
-					 TMath::Power(x[0],2)+
-					 jdDarkMatter->GetTF1IntegratedNdOmegaOffVsTheta(2*GetWobbleDistance())->Eval(x[0])))
-				 /
-				 ((jdDarkMatter->GetTF1IntegratedNdOmegaVsTheta()->Eval(par[0]))/
-					 TMath::Sqrt(
-					 TMath::Power(par[0],2)+
-					 jdDarkMatter->GetTF1IntegratedNdOmegaOffVsTheta(2*GetWobbleDistance())->Eval(par[0])));
-		}
 
-	}
 }
 
-//----------------------------------------------------
-//	It evaluates the Q2Factor vs Theta normalized at a chosen point of normalization
+//-----------------------------------------------
+//	It returns the QFactor vs theta [deg] at the nominal wobble distance (see GetWobbleDistance()), normalized at
+//	thetaNorm [deg] (not normalized if thetaNorm<0). It returns NULL if the type is not valid.
+//	The TF1 is created the first time each type is asked and is owned by JDOptimization. The kernel is prepared for
+//	the type here (see PrepareQFactorKernel()), so the TF1 only evaluates it: after ResetSmearing() it must be asked again.
 //
-//	Q2 = JFactor_1sm/Theta
-//  x[0] 	= theta	[deg]
-//  par[0] 	= theta of normalization [deg]
-Double_t JDOptimization::Q2FactorVsTheta(Double_t* x, Double_t* par)
+//	type	= QFactor type (see GetListOfQFactors())
+TF1* JDOptimization::GetTF1QFactorVsTheta(Int_t type, Double_t thetaNorm)
 {
-	if(par[0]<0.)
+	Int_t effects = JDQFactorKernel::GetEffects(type);
+	if(effects<0)
 	{
-		return (jdDarkMatter->GetTF1IntegratedNdOmegaSigma1VsTheta()->Eval(x[0])/x[0]);
-	}
-	else
-	{
-		return (jdDarkMatter->GetTF1IntegratedNdOmegaSigma1VsTheta()->Eval(x[0])/x[0])
-			 /(jdDarkMatter->GetTF1IntegratedNdOmegaSigma1VsTheta()->Eval(par[0])/par[0]);
+		cout << endl;
+		cout << "   ***************************************************************" << endl;
+		cout << "   ***   WARNING: wrong Qfactor type!!!                        ***" << endl;
+		cout << "   ***************************************************************" << endl;
+		cout << endl;
+		GetListOfQFactors();
+		return NULL;
 	}
-}
 
-//----------------------------------------------------
-//	It evaluates the Q3Factor vs Theta normalized at a chosen point of normalization
-//
-//	Q3 = JFactor_eff/Theta_eff
-//  x[0] 	= theta	[deg]
-//  par[0] 	= theta of normalization [deg]
-Double_t JDOptimization::Q3FactorVsTheta(Double_t* x, Double_t* par)
-{
-	fdNdOmegaEpsilonThetaVsThetaPhi->SetParameter(0,par[0]);
+	std::lock_guard<std::mutex> lock(mGridMutex);
+	InitQFactorKernel(effects);
 
-	if(par[0]<0.)
-	{
-		return fdNdOmegaEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2)
-				/
-				TMath::Sqrt(jdInstrument->GetTF2EpsilonThetaVsThetaAndPhi()->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2));
-	}
-	else
+	TF1* qFactorVsTheta = mapTF1QFactorVsTheta[effects];
+	if(!qFactorVsTheta)
 	{
-		return (fdNdOmegaEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2)/
-				TMath::Sqrt(jdInstrument->GetTF2EpsilonThetaVsThetaAndPhi()->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2)))
-				/
-				(fdNdOmegaEpsilonThetaVsThetaPhi->Integral(0.,par[0],0.,2*TMath::Pi(),1e-2)/
-				TMath::Sqrt(jdInstrument->GetTF2EpsilonThetaVsThetaAndPhi()->Integral(0.,par[0],0.,2*TMath::Pi(),1e-2)));
+		qFactorVsTheta = new TF1(Form("fQFactorVsTheta%d",effects), this, &JDOptimization::QFactorVsTheta, 1e-3, GetThetaMax(), 2, "JDOptimization", "QFactorVsTheta");
+		qFactorVsTheta->SetParameter(1, effects);
+		mapTF1QFactorVsTheta[effects] = qFactorVsTheta;
 	}
+	qFactorVsTheta->SetParameter(0, thetaNorm);
+	return qFactorVsTheta;
 }
 
-//----------------------------------------------------
-//	It evaluates the Q12Factor vs Theta normalized at a chosen point of normalization
+//-----------------------------------------------
+//	It returns the QFactor (not normalized) vs theta [deg] (x) and wobble [deg] (y). It returns NULL if the type is not valid.
+//	The TF2 is created the first time each type is asked and is owned by JDOptimization. The kernel is prepared for
+//	the type here (see PrepareQFactorKernel()), so the TF2 only evaluates it: after ResetSmearing() it must be asked again.
 //
-//	Q12 = J_on_1sm-J_off_1sm/theta
-//  x[0] 	= theta	[deg]
-//  par[0] 	= theta of normalization [deg]
-Double_t JDOptimization::Q12FactorVsTheta(Double_t* x, Double_t* par)
+//	type	= QFactor type (see GetListOfQFactors())
+TF2* JDOptimization::GetTF2QFactorVsThetaWobble(Int_t type)
 {
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
+	Int_t effects = JDQFactorKernel::GetEffects(type);
+	if(effects<0)
 	{
-		if(par[0]<0.)
-		{
-			return (jdDarkMatter->GetTF1JFactor_m1VsTheta()->Eval(x[0])
-					-jdDarkMatter->GetTF1JFactor_m1OffFromLOSVsTheta(2*jdInstrument->GetWobbleDistance())->Eval(x[0]))/x[0];
-		}
-		else
-		{
-			return (jdDarkMatter->GetTF1JFactor_m1VsTheta()->Eval(x[0])
-					-jdDarkMatter->GetTF1JFactor_m1OffFromLOSVsTheta(2*jdInstrument->GetWobbleDistance())->Eval(x[0]))/x[0]
-					/
-					((jdDarkMatter->GetTF1JFactor_m1VsTheta()->Eval(par[0])
-					-jdDarkMatter->GetTF1JFactor_m1OffFromLOSVsTheta(2*jdInstrument->GetWobbleDistance())->Eval(par[0]))/par[0]);
-		}
+		cout << endl;
+		cout << "   ***************************************************************" << endl;
+		cout << "   ***   WARNING: wrong Qfactor type!!!                        ***" << endl;
+		cout << "   ***************************************************************" << endl;
+		cout << endl;
+		GetListOfQFactors();
+		return NULL;
 	}
 
-	// NOT USED
+	std::lock_guard<std::mutex> lock(mGridMutex);
+	InitQFactorKernel(effects);
 
-	else
+	TF2* qFactorVsThetaWobble = mapTF2QFactorVsThetaWobble[effects];
+	if(!qFactorVsThetaWobble)
 	{
-		if(par[0]<0.)
-		{
-			return (jdDarkMatter->GetTF1JFactorVsTheta()->Eval(x[0]))/
-					 TMath::Sqrt(
-					 TMath::Power(x[0],2)+
-					 jdDarkMatter->GetTF1JFactorOffFromLOSVsTheta(2*jdInstrument->GetWobbleDistance())->Eval(x[0]));
-		}
-		else
-		{
-		 return ((jdDarkMatter->GetTF1JFactorVsTheta()->Eval(x[0]))/
-					 TMath::Sqrt(
-					 TMath::Power(x[0],2)+
-					 jdDarkMatter->GetTF1JFactorOffFromLOSVsTheta(2*GetWobbleDistance())->Eval(x[0])))
-				 /
-				 ((jdDarkMatter->GetTF1JFactorVsTheta()->Eval(par[0]))/
-					 TMath::Sqrt(
-					 TMath::Power(par[0],2)+
-					 jdDarkMatter->GetTF1JFactorOffFromLOSVsTheta(2*GetWobbleDistance())->Eval(par[0])));
-		}
+		qFactorVsThetaWobble = new TF2(Form("fQFactorVsThetaWobble%d",effects), this, &JDOptimization::QFactorVsThetaWobble, 1e-3, GetThetaMax(), 0., GetDistCameraCenterMax(), 1, "JDOptimization", "QFactorVsThetaWobble");
+		qFactorVsThetaWobble->SetParameter(0, effects);
+		mapTF2QFactorVsThetaWobble[effects] = qFactorVsThetaWobble;
 	}
+	return qFactorVsThetaWobble;
 }
 
 //----------------------------------------------------
-//	It evaluates the Q13Factor vs Theta normalized at a chosen point of normalization
+//	It evaluates the QFactor vs Theta at the nominal wobble distance, normalized at a chosen point of normalization
+//	The QFactor of each type is built by JDQFactorExpression from its effects, with the kernel prepared by
+//	GetTF1QFactorVsTheta(): it only reads it.
 //
-//	Q13 = J_on_eff-J_off_eff/theta_eff   [or A·J_on_eff / Sqrt(theta_eff^2 + B·J_off_eff)]
-//  x[0] 	= theta	[deg]
-//  par[0] 	= theta of normalization [deg]
-Double_t JDOptimization::Q13FactorVsTheta(Double_t* x, Double_t* par)
+//  x[0] 	= theta							[deg]
+//  par[0] 	= theta of normalization		[deg]
+//  par[1] 	= effects (see JDQFactorKernel::Effect)
+Double_t JDOptimization::QFactorVsTheta(Double_t* x, Double_t* par)
 {
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
-	{
-		if(par[0]<0. || par[1]<0.)
-		{
-
-			return (fdNdOmegaEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2)
-					-fdNdOmegaOffEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2))
-					/
-					jdInstrument->GetTF2EpsilonThetaVsThetaAndPhi()->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
-		}
-
-		else
-		{
-			return ((fdNdOmegaEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2)
-					-fdNdOmegaOffEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2))
-					/
-					jdInstrument->GetTF2EpsilonThetaVsThetaAndPhi()->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2))
-					/
-					((fdNdOmegaEpsilonThetaVsThetaPhi->Integral(0.,par[0],0.,2*TMath::Pi(),1e-2)
-					-fdNdOmegaOffEpsilonThetaVsThetaPhi->Integral(0.,par[0],0.,2*TMath::Pi(),1e-2))
-					/
-					jdInstrument->GetTF2EpsilonThetaVsThetaAndPhi()->Integral(0.,par[0],0.,2*TMath::Pi(),1e-2));
-		}
-	}
-	else // NOT USED: you need to define A & B
-	{
+	Int_t effects = TMath::Nint(par[1]);
+	if(!qFactorKernel) return 0.;
 
-		if(par[0]<0. || par[1]<0.)
-		{
-			return fdNdOmegaEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2)
-				   /
-					TMath::Sqrt(TMath::Power(jdInstrument->GetTF2EpsilonThetaVsThetaAndPhi()->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2),2)
-					+ TMath::Power(fdNdOmegaOffEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2),2) );
-		}
-		else // par[1] not used
-		{
-			return (fdNdOmegaEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2)
-				   /
-					TMath::Sqrt(TMath::Power(jdInstrument->GetTF2EpsilonThetaVsThetaAndPhi()->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2),2)
-					+ TMath::Power(fdNdOmegaOffEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2),2) ))
-					/
-					(fdNdOmegaEpsilonThetaVsThetaPhi->Integral(0.,par[0],0.,2*TMath::Pi(),1e-2)
-					 /
-					TMath::Sqrt(TMath::Power(jdInstrument->GetTF2EpsilonThetaVsThetaAndPhi()->Integral(0.,par[0],0.,2*TMath::Pi(),1e-2),2)
-					+ TMath::Power(fdNdOmegaOffEpsilonThetaVsThetaPhi->Integral(0.,par[0],0.,2*TMath::Pi(),1e-2),2) ));
-		}
-	}
+	Double_t qFactor = qFactorKernel->Evaluate(effects,x[0],GetWobbleDistance());
+	if(par[0]<0.)	return qFactor;
+	else			return qFactor/qFactorKernel->Evaluate(effects,par[0],GetWobbleDistance());
 }
 
 //----------------------------------------------------
-//	It evaluates the Q23Factor vs Theta normalized at a chosen point of normalization
+//	It evaluates the QFactor vs Theta and Wobble (not normalized)
+//	The QFactor of each type is built by JDQFactorExpression from its effects, with the kernel prepared by
+//	GetTF2QFactorVsThetaWobble(): it only reads it.
 //
-//	Q23 = J_1sm_eff/theta_eff
-//  x[0] 	= theta	[deg]
-//  par[0] 	= theta of normalization [deg]
-Double_t JDOptimization::Q23FactorVsTheta(Double_t* x, Double_t* par)
+//  x[0] 	= theta							[deg]
+//  x[1] 	= wobble dist					[deg]
+//  par[0] 	= effects (see JDQFactorKernel::Effect)
+Double_t JDOptimization::QFactorVsThetaWobble(Double_t* x, Double_t* par)
 {
-	if(par[0]<0.)
-		{
-			return (jdDarkMatter->GetTF1JFactor_m1VsTheta()->Eval(x[0])*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0])/x[0]);
-		}
-		else
-		{
-			return (jdDarkMatter->GetTF1JFactor_m1VsTheta()->Eval(x[0])*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0])/x[0])
-					/
-					(jdDarkMatter->GetTF1JFactorVsTheta()->Eval(par[0])/par[0]);
-		}
+	Int_t effects = TMath::Nint(par[0]);
+	if(!qFactorKernel) return 0.;
+
+	return qFactorKernel->Evaluate(effects,x[0],x[1]);
 }
 
 //----------------------------------------------------
-//	It evaluates the Q123Factor vs Theta normalized at a chosen point of normalization
-//
-//	Q123 = J_on_1sm_eff-J_off_1sm_eff/theta_eff
-//  x[0] 	= theta	[deg]
-//  par[0] 	= theta of normalization [deg]
-Double_t JDOptimization::Q123FactorVsTheta(Double_t* x, Double_t* par)
+//	Effects of the QFactor of this type (see JDQFactorKernel::GetEffects()) if the kernel has been prepared for it
+//	(see PrepareQFactorKernel()), -1 otherwise
+Int_t JDOptimization::GetPreparedEffects(Int_t type) const
 {
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
-	{
-		if(par[0]<0. || par[1]<0.)
-			{
-
-				return (jdDarkMatter->GetTF1JFactor_m1VsTheta()->Eval(x[0])*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0])
-						-jdDarkMatter->GetTF1JFactor_m1OffFromLOSVsTheta(2*GetWobbleDistance())->Eval(x[0])*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0]))
-						/x[0]*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0]);
-			}
-
-			else
-			{
-				return (jdDarkMatter->GetTF1JFactor_m1VsTheta()->Eval(x[0])*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0])
-						-jdDarkMatter->GetTF1JFactor_m1OffFromLOSVsTheta(2*GetWobbleDistance())->Eval(x[0])*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0]))
-						/x[0]*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0])
-						/
-						(jdDarkMatter->GetTF1JFactorVsTheta()->Eval(par[0])/par[0]);
-			}
-	}
-
-	// NOT USED
-
-	else
-	{
-
-		if(par[0]<0. || par[1]<0.)
-		{
-			return (jdDarkMatter->GetTF1JFactorVsTheta()->Eval(x[0])*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0]))/
-					 TMath::Sqrt(
-					 TMath::Power(x[0]*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0]),2)+
-					 jdDarkMatter->GetTF1JFactorOffFromLOSVsTheta(2*GetWobbleDistance())->Eval(x[0])*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0]));
-		}
-		else
-		{
-		 return ((jdDarkMatter->GetTF1JFactorVsTheta()->Eval(x[0])*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0]))/
-					 TMath::Sqrt(
-					 TMath::Power(x[0]*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0]),2)+
-					 jdDarkMatter->GetTF1JFactorOffFromLOSVsTheta(2*GetWobbleDistance())->Eval(x[0]))*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(x[0]))
-				 /
-				 ((jdDarkMatter->GetTF1JFactorVsTheta()->Eval(par[0])*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(par[0]))/
-					 TMath::Sqrt(
-					 TMath::Power(par[0]*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(par[0]),2)+
-					 jdDarkMatter->GetTF1JFactorOffFromLOSVsTheta(2*GetWobbleDistance())->Eval(par[0]))*jdInstrument->GetTF1EfficiencyVsTheta(GetWobbleDistance())->Eval(par[0]));
-		}
-	}
+	Int_t effects = JDQFactorKernel::GetEffects(type);
+	if(effects<0 || !qFactorKernel) return -1;
+	if(!qFactorKernel->GetIsProfile(JDQFactorKernel::GetProfileIndex(effects))) return -1;
+	if((effects&JDQFactorKernel::kAcceptance) && !qFactorKernel->GetIsEpsilon()) return -1;
+	return effects;
 }
 
 //----------------------------------------------------
-//	Q0Factor vs Theta and Phi. If defined, is normalized at theta_norm and phi_norm
-//	Q0 = J_on/(Sqrt(4pi)·theta)
-//
-//  x[0] 	= theta							[deg]
-//  x[1] 	= wobble dist					[deg]
-//  par[0] 	= theta_norm					[deg]
-//  par[1] 	= phi_norm						[deg]
-Double_t JDOptimization::Q0FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	It evaluates the QFactor of this type (see GetListOfQFactors()) at theta [deg] and wobble [deg], normalized at
+//	thetaNorm [deg] and the same wobble (not normalized if thetaNorm<0). Reentrant: it only reads the kernel, so
+//	PrepareQFactorKernel(type) must be called first. It returns 0 if the type is not valid or not prepared.
+Double_t JDOptimization::EvaluateQFactor(Int_t type, Double_t theta, Double_t wobble, Double_t thetaNorm) const
 {
-	Double_t sqrtEpsilonIdeal = x[0]*TMath::Sqrt(4*TMath::Pi());
+	Int_t effects = GetPreparedEffects(type);
+	if(effects<0) return 0.;
 
-	return (jdDarkMatter->fIntegratedNdOmegaThetaVsTheta->Eval(x[0])/sqrtEpsilonIdeal);
+	Double_t qFactor = qFactorKernel->Evaluate(effects,theta,wobble);
+	if(thetaNorm<0.)	return qFactor;
+	else				return qFactor/qFactorKernel->Evaluate(effects,thetaNorm,wobble);
 }
 
 //----------------------------------------------------
-//	It evaluates the Q1Factor vs Theta and Phi
-//
-//	Q1 = J_on-J_off/(Sqrt(4pi)·theta)    [ or A·J_on /Sqrt(theta^2 - B·J_off)
-//  x[0] 	= theta							[deg]
-//  x[1] 	= wobble dist					[deg]
-Double_t JDOptimization::Q1FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	It evaluates the QFactor of this type at the bin centres of thetaAxis [deg] and wobble [deg] into row, with the
+//	scratch buffers of context (see JDQFactorKernel::EvaluateRow()). Reentrant if every thread uses its own context.
+//	It returns 0 (and leaves row untouched) if the type is not valid or not prepared.
+Bool_t JDOptimization::EvaluateQFactorRow(Int_t type, Double_t wobble, const JDGridAxis& thetaAxis, Double_t* row, JDEvalContext& context) const
 {
-	Double_t sqrtEpsilonIdeal = x[0]*TMath::Sqrt(4*TMath::Pi());
-	jdDarkMatter->fIntegratedNdOmegaOffThetaVsTheta->SetParameter(0,2*x[1]);
+	Int_t effects = GetPreparedEffects(type);
+	if(effects<0) return 0;
 
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
-	{
-		return (jdDarkMatter->fIntegratedNdOmegaThetaVsTheta->Eval(x[0])-
-					jdDarkMatter->fIntegratedNdOmegaOffThetaVsTheta->Eval(x[0]))/sqrtEpsilonIdeal;
-	}
-	else	// NOT CORRECT IF YOU DONT DEFINE A & B
-	{
-		return 	jdDarkMatter->fIntegratedNdOmegaThetaVsTheta->Eval(x[0])
-				/
-				(TMath::Sqrt( TMath::Power(sqrtEpsilonIdeal,2)+
-				jdDarkMatter->fIntegratedNdOmegaOffThetaVsTheta->Eval(x[0])));
-	}
+	qFactorKernel->EvaluateRow(effects,wobble,thetaAxis,row,context);
+	return 1;
 }
 
 //----------------------------------------------------
-//
-Double_t JDOptimization::Q14FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	dN/dOmega · Epsilon (or dN/dOmega_Sigma1 · Epsilon) at theta [deg] and phi [rad] around a source at wobble [deg]
+//	from the camera center. Reentrant.
+Double_t JDOptimization::EvaluatedNdOmegaEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble, Bool_t isSigma1) const
 {
-	if(!GetIsdNdOmegaSmeared()) SetdNdOmegaSmeared();
-
-	Double_t sqrtEpsilonIdeal = x[0]*TMath::Sqrt(4*TMath::Pi());
-	fIntegratedNdOmegaSmearedOffThetaVsTheta->SetParameter(0,2*x[1]);
-
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
-	{
-		return (fIntegratedNdOmegaSmearedThetaVsTheta->Eval(x[0])-
-					fIntegratedNdOmegaSmearedOffThetaVsTheta->Eval(x[0]))/sqrtEpsilonIdeal;
-	}
-	else	// NOT CORRECT IF YOU DONT DEFINE A & B
-	{
-		return 	fIntegratedNdOmegaSmearedThetaVsTheta->Eval(x[0])
-				/
-				(TMath::Sqrt( TMath::Power(sqrtEpsilonIdeal,2)+
-				fIntegratedNdOmegaSmearedOffThetaVsTheta->Eval(x[0])));
-	}
+	return jdDarkMatter->EvaluatedNdOmega(theta,isSigma1)*jdInstrument->EvaluateEpsilonVsThetaPhi(theta,phi,wobble);
 }
 
 //----------------------------------------------------
-//	It evaluates the Q2Factor vs Theta and Phi
-//	Q2 = J_Sigma1/theta
-//
-//  x[0] 	= theta							[deg]
-//  x[1] 	= wobble dist					[deg]
-Double_t JDOptimization::Q2FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	As EvaluatedNdOmegaEpsilonVsThetaPhi(theta,phi,wobble,isSigma1), with the cursors of context. Reentrant.
+Double_t JDOptimization::EvaluatedNdOmegaEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble, JDEvalContext& context, Bool_t isSigma1) const
 {
-	Double_t sqrtEpsilonIdeal = x[0]*TMath::Sqrt(4*TMath::Pi());
-	return (jdDarkMatter->fIntegratedNdOmegaSigma1ThetaVsTheta->Eval(x[0])/sqrtEpsilonIdeal);
+	return jdDarkMatter->EvaluatedNdOmega(theta,context,isSigma1)*jdInstrument->EvaluateEpsilonVsThetaPhi(theta,phi,wobble,context);
 }
 
 //----------------------------------------------------
-//	It evaluates the Q3Factor vs Theta and Phi
-//	Q3 = int{dN/dOmega · epsilon}/int{epsilon}
-//
-//  x[0] 	= theta							[deg]
-//  x[1] 	= wobble dist					[deg]
-Double_t JDOptimization::Q3FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	dN/dOmega_off · Epsilon (or dN/dOmega_off_Sigma1 · Epsilon) at theta [deg] and phi [rad] around the OFF regions
+//	of the background geometry (see SetBackgroundGeometry()), as the leakage of the QFactor kernel: alpha times the sum
+//	over the regions, each one at its distance from the source and turned by its tilt. Reentrant.
+Double_t JDOptimization::EvaluatedNdOmegaOffEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble, Bool_t isSigma1) const
 {
-	fIntegratedNdOmegaEpsilonThetaVsTheta->SetParameter(0,x[1]);
-	jdInstrument->fIntegrateEpsilonThetaVsTheta->SetParameter(0,x[1]);
-	return fIntegratedNdOmegaEpsilonThetaVsTheta->Eval(x[0])
-			/
-			TMath::Sqrt(jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0]));
+	Double_t dNdOmegaOff = 0.;
+	for(Int_t r=0; r<backgroundGeometry.GetNumDistinctOffRegions(); r++)
+	{
+		dNdOmegaOff += backgroundGeometry.GetDistinctOffRegionWeight(r)*
+					   jdDarkMatter->EvaluatedNdOmegaOff(theta,phi+backgroundGeometry.GetOffRegionTilt(r),backgroundGeometry.GetOffRegionDistance(r)*wobble,isSigma1);
+	}
+	return dNdOmegaOff*jdInstrument->EvaluateEpsilonVsThetaPhi(theta,phi,wobble);
 }
 
 //----------------------------------------------------
-//	It evaluates the Q3Factor vs Theta and Phi
-//	Q4
-Double_t JDOptimization::Q4FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	As EvaluatedNdOmegaOffEpsilonVsThetaPhi(theta,phi,wobble,isSigma1), with the cursors of context. Reentrant.
+Double_t JDOptimization::EvaluatedNdOmegaOffEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble, JDEvalContext& context, Bool_t isSigma1) const
 {
-	if(!GetIsdNdOmegaSmeared()) SetdNdOmegaSmeared();
-
-	Double_t sqrtEpsilonIdeal = x[0]*TMath::Sqrt(4*TMath::Pi());
-
-	return fIntegratedNdOmegaSmearedThetaVsTheta->Eval(x[0])
-			/
-			sqrtEpsilonIdeal;
+	Double_t dNdOmegaOff = 0.;
+	for(Int_t r=0; r<backgroundGeometry.GetNumDistinctOffRegions(); r++)
+	{
+		dNdOmegaOff += backgroundGeometry.GetDistinctOffRegionWeight(r)*
+					   jdDarkMatter->EvaluatedNdOmegaOff(theta,phi+backgroundGeometry.GetOffRegionTilt(r),backgroundGeometry.GetOffRegionDistance(r)*wobble,context,isSigma1);
+	}
+	return dNdOmegaOff*jdInstrument->EvaluateEpsilonVsThetaPhi(theta,phi,wobble,context);
 }
 
 //----------------------------------------------------
-//	It evaluates the Q12Factor vs Theta and Phi
-//	Q12 = J_on_1sm-J_off_1sm/theta
+// It evaluates the dNdOmega·Epsilon multiplied by Sin(Theta) vs Theta and Phi.
+// The dNdOmega can be also multiplied by Theta if we are not considering Spherical Coordinates.
 //
-//  x[0] 	= theta							[deg]
-//  x[1] 	= wobble dist					[deg]
-Double_t JDOptimization::Q12FactorVsThetaWobble(Double_t* x, Double_t* par)
+// x[0]		= theta	[deg]
+// x[1]		= phi	[rad]
+// x0rad    = theta [rad]
+// wobble	= the nominal one (see GetWobbleDistance())
+Double_t JDOptimization::dNdOmegaEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par)
 {
-	Double_t sqrtEpsilonIdeal = x[0]*TMath::Sqrt(4*TMath::Pi());
-	jdDarkMatter->fIntegratedNdOmegaSigma1OffThetaVsTheta->SetParameter(0,2*x[1]);
+	Double_t X0rad =x[0]*dDeg2Rad;
 
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
+	if (GetIsSphericalCoordinates()==1)
 	{
-		return (jdDarkMatter->fIntegratedNdOmegaSigma1ThetaVsTheta->Eval(x[0])-
-					jdDarkMatter->fIntegratedNdOmegaSigma1OffThetaVsTheta->Eval(x[0]))/sqrtEpsilonIdeal;
+		return EvaluatedNdOmegaEpsilonVsThetaPhi(x[0],x[1],GetWobbleDistance())*TMath::Sin(X0rad);
 	}
-	else	// NOT CORRECT IF YOU DONT DEFINE A & B
+	else
 	{
-		return 	jdDarkMatter->fIntegratedNdOmegaSigma1ThetaVsTheta->Eval(x[0])
-				/
-				TMath::Sqrt( TMath::Power(sqrtEpsilonIdeal,2)+
-				jdDarkMatter->fIntegratedNdOmegaSigma1OffThetaVsTheta->Eval(x[0]));
+		return EvaluatedNdOmegaEpsilonVsThetaPhi(x[0],x[1],GetWobbleDistance())*x[0];
 	}
 }
 
 //----------------------------------------------------
-//	It evaluates the Q23Factor vs Theta and Phi normalized at a chosen point of normalization
-//
-//	Q23 = J_1sm_eff/theta_eff
-//  x[0] 	= theta							[deg]
-//  x[1] 	= wobble dist					[deg]
-//  par[0] 	= theta of normalization		[deg]
-Double_t JDOptimization::Q23FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	dN/dOmega * Epsilon
+// x[0] = theta [deg]
+// x[1] = phi 	[rad]
+// wobble = the nominal one (see GetWobbleDistance())
+Double_t JDOptimization::dNdOmegaEpsilonVsThetaPhi(Double_t* x, Double_t* par)
 {
-	fIntegratedNdOmegaSigma1EpsilonThetaVsTheta->SetParameter(0,x[1]);
-	jdInstrument->fIntegrateEpsilonThetaVsTheta->SetParameter(0,x[1]);
-	return fIntegratedNdOmegaSigma1EpsilonThetaVsTheta->Eval(x[0])
-			/
-			TMath::Sqrt(jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0]));
+	return EvaluatedNdOmegaEpsilonVsThetaPhi(x[0],x[1],GetWobbleDistance());
 }
 
 //----------------------------------------------------
-//	It evaluates the Q23Factor vs Theta and Phi normalized at a chosen point of normalization
-//
-//	Q24 =
-Double_t JDOptimization::Q24FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	Smeared dN/dOmega vs theta [deg] (0 until it is computed, see InitdNdOmegaSmeared())
+Double_t JDOptimization::dNdOmegaSmearedVsTheta(Double_t* x, Double_t* par)
 {
-	if(!GetIsdNdOmegaSigma1Smeared()) SetdNdOmegaSigma1Smeared();
-
-	Double_t sqrtEpsilonIdeal = x[0]*TMath::Sqrt(4*TMath::Pi());
-	return (fIntegratedNdOmegaSigma1SmearedThetaVsTheta->Eval(x[0])/sqrtEpsilonIdeal);
+	if(!gdNdOmegaSmeared) return 0.;
+	return gdNdOmegaSmeared->Eval(x[0]);
 }
 
 //----------------------------------------------------
-//	It evaluates the Q23Factor vs Theta and Phi normalized at a chosen point of normalization
-//
-//	Q34 =
-Double_t JDOptimization::Q34FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	Smeared dN/dOmega_Sigma1 vs theta [deg] (0 until it is computed, see InitdNdOmegaSigma1Smeared())
+Double_t JDOptimization::dNdOmegaSigma1SmearedVsTheta(Double_t* x, Double_t* par)
 {
-	if(!GetIsdNdOmegaSmeared()) SetdNdOmegaSmeared();
-
-	fIntegratedNdOmegaSmearedEpsilonThetaVsTheta->SetParameter(0,x[1]);
-	jdInstrument->fIntegrateEpsilonThetaVsTheta->SetParameter(0,x[1]);
-	return fIntegratedNdOmegaSmearedEpsilonThetaVsTheta->Eval(x[0])
-			/
-			TMath::Sqrt(jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0]));
+	if(!gdNdOmegaSigma1Smeared) return 0.;
+	return gdNdOmegaSigma1Smeared->Eval(x[0]);
 }
 
 //----------------------------------------------------
-//	It evaluates the Q13Factor vs Theta and Phi normalized at a chosen point of normalization
-//
-//	Q13 = J_on_eff-J_off_eff/theta_eff
-//  x[0] 	= theta							[deg]
-//  x[1] 	= wobble dist					[deg]
-//  par[0] 	= theta of normalization		[deg]
-//  par[1]  = wobble of normalization       [deg]
-Double_t JDOptimization::Q13FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	dN/dOmegaOff * Epsilon
+// x[0] = theta [deg]
+// x[1] = phi 	[rad]
+// wobble = the nominal one (see GetWobbleDistance())
+Double_t JDOptimization::dNdOmegaOffEpsilonVsThetaPhi(Double_t* x, Double_t* par)
 {
-	fIntegratedNdOmegaEpsilonThetaVsTheta->SetParameter(0,x[1]);
-	fIntegratedNdOmegaOffEpsilonThetaVsTheta->SetParameter(0,x[1]);
-	jdInstrument->fIntegrateEpsilonThetaVsTheta->SetParameter(0,x[1]);
-
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
-	{
-		return (fIntegratedNdOmegaEpsilonThetaVsTheta->Eval(x[0])-
-				fIntegratedNdOmegaOffEpsilonThetaVsTheta->Eval(x[0]))
-				/TMath::Sqrt(jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0]));
-	}
-	else	// NOT CORRECT IF YOU DONT DEFINE A & B
-	{
-		return 	fIntegratedNdOmegaEpsilonThetaVsTheta->Eval(x[0])
-				/
-				(TMath::Sqrt( jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0])+
-				fIntegratedNdOmegaOffEpsilonThetaVsTheta->Eval(x[0])));
-	}
+	return EvaluatedNdOmegaOffEpsilonVsThetaPhi(x[0],x[1],GetWobbleDistance());
 }
 
-
 //----------------------------------------------------
-//	It evaluates the Q123Factor vs Theta and Phi normalized at a chosen point of normalization
-//	Q123 = J_on_1sm_eff-J_off_1sm_eff/theta_eff
-//
-//  x[0] 	= theta							[deg]
-//  x[1] 	= wobble dist					[deg]
-Double_t JDOptimization::Q123FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	dN/dOmegaOffTheta * Epsilon
+// x[0] = theta [deg]
+// x[1] = phi 	[rad]
+// wobble = the nominal one (see GetWobbleDistance())
+Double_t JDOptimization::dNdOmegaOffEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par)
 {
-	fIntegratedNdOmegaSigma1EpsilonThetaVsTheta->SetParameter(0,x[1]);
-	fIntegratedNdOmegaSigma1OffEpsilonThetaVsTheta->SetParameter(0,x[1]);
-	jdInstrument->fIntegrateEpsilonThetaVsTheta->SetParameter(0,x[1]);
-
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
-	{
-		return (fIntegratedNdOmegaSigma1EpsilonThetaVsTheta->Eval(x[0])-
-				fIntegratedNdOmegaSigma1OffEpsilonThetaVsTheta->Eval(x[0]))
-				/TMath::Sqrt(jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0]));
-	}
-	else	// NOT CORRECT IF YOU DONT DEFINE A & B
-	{
-		return 	fIntegratedNdOmegaSigma1EpsilonThetaVsTheta->Eval(x[0])
-				/
-				(TMath::Sqrt( jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0])+
-				fIntegratedNdOmegaSigma1OffEpsilonThetaVsTheta->Eval(x[0])));
-	}
+	return dNdOmegaOffEpsilonVsThetaPhi(x,par)*x[0];
 }
 
-//----------------------------------------------------
+//-----------------------------------------------
+//	It returns the grid with the QFactor (not normalized) vs theta [deg] (x) and wobble [deg] (y), evaluated at the bin centres
+//	(see BuildGridsQFactorVsThetaWobble()). The grid is cached for every type asked. It returns NULL if the type is not valid.
 //
-Double_t JDOptimization::Q124FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	type	= QFactor type (see GetListOfQFactors())
+const JDGrid2D* JDOptimization::GetGridQFactorVsThetaWobble(Int_t type)
 {
-	if(!GetIsdNdOmegaSigma1Smeared()) SetdNdOmegaSigma1Smeared();
-
-	fIntegratedNdOmegaSigma1SmearedThetaVsTheta->SetParameter(0,x[1]);
-	fIntegratedNdOmegaSigma1SmearedOffThetaVsTheta->SetParameter(0,x[1]);
-	jdInstrument->fIntegrateEpsilonThetaVsTheta->SetParameter(0,x[1]);
+	std::lock_guard<std::mutex> lock(mGridMutex);
 
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
-	{
-		return (fIntegratedNdOmegaSigma1SmearedThetaVsTheta->Eval(x[0])-
-				fIntegratedNdOmegaSigma1SmearedOffThetaVsTheta->Eval(x[0]))
-				/TMath::Sqrt(jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0]));
-	}
-	else	// NOT CORRECT IF YOU DONT DEFINE A & B
+	Int_t effects = JDQFactorKernel::GetEffects(type);
+	if(effects<0)
 	{
-		return 	fIntegratedNdOmegaSigma1SmearedThetaVsTheta->Eval(x[0])
-				/
-				(TMath::Sqrt( jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0])+
-				fIntegratedNdOmegaSigma1SmearedOffThetaVsTheta->Eval(x[0])));
+		cout << "   *********************************" << endl;
+		cout << "   ***                           ***" << endl;
+		cout << "   ***  WARNING:                 ***" << endl;
+		cout << "   ***  Unknown type of QFactor  ***" << endl;
+		cout << "   ***                           ***" << endl;
+		cout << "   *********************************" << endl;
+		return NULL;
 	}
+
+	if(!mapGridQFactorVsThetaWobble.count(effects)) BuildGridsQFactorVsThetaWobble(vector<Int_t>(1,effects));
+	return mapGridQFactorVsThetaWobble[effects];
 }
 
-//----------------------------------------------------
+//-----------------------------------------------
+//	It fills the grids of all these types (see GetGridQFactorVsThetaWobble()) that are not cached yet, in one pass:
+//	the integrals shared by several types (ON, OFF, ACC) are computed once per bin.
+//	It returns 0 (and fills nothing) if any type is not valid.
 //
-Double_t JDOptimization::Q134FactorVsThetaWobble(Double_t* x, Double_t* par)
+//	types	= QFactor types (see GetListOfQFactors())
+Bool_t JDOptimization::FillGridsQFactorVsThetaWobble(const vector<Int_t>& types)
 {
-	if(!GetIsdNdOmegaSmeared()) SetdNdOmegaSmeared();
-
-	fIntegratedNdOmegaSmearedEpsilonThetaVsTheta->SetParameter(0,x[1]);
-	fIntegratedNdOmegaSmearedEpsilonOffThetaVsTheta->SetParameter(0,x[1]);
-	jdInstrument->fIntegrateEpsilonThetaVsTheta->SetParameter(0,x[1]);
+	std::lock_guard<std::mutex> lock(mGridMutex);
 
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
+	vector<Int_t> effectsList;
+	for(UInt_t t=0; t<types.size(); t++)
 	{
-		return (fIntegratedNdOmegaSmearedEpsilonThetaVsTheta->Eval(x[0])-
-				fIntegratedNdOmegaSmearedEpsilonOffThetaVsTheta->Eval(x[0]))
-				/TMath::Sqrt(jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0]));
+		Int_t effects = JDQFactorKernel::GetEffects(types[t]);
+		if(effects<0)
+		{
+			cout << "   *********************************" << endl;
+			cout << "   ***                           ***" << endl;
+			cout << "   ***  WARNING:                 ***" << endl;
+			cout << "   ***  Unknown type of QFactor  ***" << endl;
+			cout << "   ***                           ***" << endl;
+			cout << "   *********************************" << endl;
+			return 0;
+		}
+		if(!mapGridQFactorVsThetaWobble.count(effects) && std::find(effectsList.begin(),effectsList.end(),effects)==effectsList.end()) effectsList.push_back(effects);
 	}
-	else	// NOT CORRECT IF YOU DONT DEFINE A & B
+
+	if(effectsList.size()>0) BuildGridsQFactorVsThetaWobble(effectsList);
+	return 1;
+}
+
+//-----------------------------------------------
+//	It fills and caches one grid for each effects (see JDQFactorKernel::Effect), reading it from the surface store if
+//	it is there (see SetSurfaceStore()) and storing it otherwise. All the types computed are compiled into one
+//	JDQFactorExpression, so their common integrals and operations are evaluated once per bin. The wobble rows are
+//	distributed over the task scheduler (see SetNumThreads()); each thread has its own JDEvalContext and
+//	writes the rows of all the types directly into their grids (see JDQFactorKernel::EvaluateRows()).
+//	With a store, the rows done are checkpointed every dCheckpointInterval seconds as partial surfaces, and a build
+//	interrupted before (a killed job) only computes the rows missing from its last checkpoint.
+//	mGridMutex must be locked.
+void JDOptimization::BuildGridsQFactorVsThetaWobble(const vector<Int_t>& effectsListAsked)
+{
+	// the surfaces already in the store are only read
+	vector<Int_t> effectsList;
+	for(UInt_t t=0; t<effectsListAsked.size(); t++)
 	{
-		return 	fIntegratedNdOmegaSmearedEpsilonThetaVsTheta->Eval(x[0])
-				/
-				(TMath::Sqrt( jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0])+
-				fIntegratedNdOmegaSmearedEpsilonOffThetaVsTheta->Eval(x[0])));
+		JDGrid2D* grid = (surfaceStore? surfaceStore->LoadSurface(GetConfiguration(effectsListAsked[t])) : NULL);
+		if(grid)	mapGridQFactorVsThetaWobble[effectsListAsked[t]] = grid;
+		else		effectsList.push_back(effectsListAsked[t]);
 	}
-}
+	if(effectsList.size()==0) return;
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::Q234FactorVsThetaWobble(Double_t* x, Double_t* par)
-{
-	if(!GetIsdNdOmegaSigma1Smeared()) SetdNdOmegaSigma1Smeared();
+	// everything that touches ROOT objects is done here, before going parallel
+	for(UInt_t t=0; t<effectsList.size(); t++) InitQFactorKernel(effectsList[t]);
+
+	Double_t resolution = GetBinResolution();			//[deg/bin]
+	Double_t thetaMax = GetThetaMax();					// [deg]
+	Int_t numBinsX = thetaMax/resolution; 				// [#bins]
+	Double_t wobbleMax = GetDistCameraCenterMax();		// [deg]
+	Int_t numBinsY = wobbleMax/resolution; 				// [#bins]
 
-	fIntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta->SetParameter(0,x[1]);
-	jdInstrument->fIntegrateEpsilonThetaVsTheta->SetParameter(0,x[1]);
+	Int_t numTypes = effectsList.size();
+	JDQFactorExpression expression(qFactorKernel->GetIsOnMinusOff());
+	for(Int_t t=0; t<numTypes; t++) expression.AddQFactor(effectsList[t]);
 
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
+	vector<JDGrid2D*> grids(numTypes);
+	for(Int_t t=0; t<numTypes; t++)
 	{
-		return (fIntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta->Eval(x[0]))
-				/TMath::Sqrt(jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0]));
+		grids[t] = new JDGrid2D(JDGridAxis(numBinsX,0.,thetaMax),JDGridAxis(numBinsY,0.,wobbleMax));
+		mapGridQFactorVsThetaWobble[effectsList[t]] = grids[t];
 	}
-	else	// NOT CORRECT IF YOU DONT DEFINE A & B
+
+	const JDGridAxis& thetaAxis = grids[0]->GetXaxis();
+	const JDGridAxis& wobbleAxis = grids[0]->GetYaxis();
+
+	// the rows of the last checkpoint (see SetCheckpointInterval()) are not computed again
+	vector<TString> configurations(numTypes);
+	vector<Bool_t> isRowDone(numBinsY,0);
+	if(surfaceStore)
 	{
-		return 	fIntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta->Eval(x[0])
-				/
-				TMath::Sqrt( jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0]));
+		vector<JDGrid2D*> partialGrids(numTypes);
+		Bool_t isPartial = 1;
+		for(Int_t t=0; t<numTypes; t++)
+		{
+			configurations[t] = GetConfiguration(effectsList[t]);
+			vector<Bool_t> isPartialRowDone;
+			partialGrids[t] = surfaceStore->LoadPartialSurface(configurations[t],isPartialRowDone);
+			if(!partialGrids[t] || partialGrids[t]->GetSize()!=grids[t]->GetSize()) isPartial = 0;
+			else if(t==0) isRowDone = isPartialRowDone;
+			else for(Int_t j=0; j<numBinsY; j++) isRowDone[j] = isRowDone[j] && isPartialRowDone[j];
+		}
+		if(!isPartial) isRowDone.assign(numBinsY,0);
+		for(Int_t j=0; j<numBinsY; j++)
+		{
+			if(!isRowDone[j]) continue;
+			for(Int_t t=0; t<numTypes; t++) std::copy(partialGrids[t]->GetRow(j),partialGrids[t]->GetRow(j)+numBinsX,grids[t]->GetRow(j));
+		}
+		for(Int_t t=0; t<numTypes; t++) delete partialGrids[t];
 	}
-}
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::Q1234FactorVsThetaWobble(Double_t* x, Double_t* par)
-{
-	if(!GetIsdNdOmegaSigma1Smeared()) SetdNdOmegaSigma1Smeared();
+	vector<Int_t> rowsToDo;
+	for(Int_t j=0; j<numBinsY; j++) if(!isRowDone[j]) rowsToDo.push_back(j);
 
-	fIntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta->SetParameter(0,x[1]);
-	fIntegratedNdOmegaSigma1SmearedEpsilonOffThetaVsTheta->SetParameter(0,x[1]);
-	jdInstrument->fIntegrateEpsilonThetaVsTheta->SetParameter(0,x[1]);
+	// flags of the rows done: a row is written before its flag (release), so a checkpoint only copies finished rows
+	vector<std::atomic<Bool_t> > isRowSaved(numBinsY);
+	for(Int_t j=0; j<numBinsY; j++) isRowSaved[j].store(isRowDone[j],std::memory_order_relaxed);
+	Bool_t isCheckpointing = (surfaceStore && dCheckpointInterval>0.);
+	std::chrono::nanoseconds checkpointInterval((Long64_t)(dCheckpointInterval*1.e9));
+	std::chrono::steady_clock::time_point nextCheckpoint = std::chrono::steady_clock::now()+checkpointInterval;
+	std::mutex checkpointMutex;		// one thread saves each checkpoint; the others do not wait for it
 
-	if (GetIsIntegraldNdOmegaOnMinusOFF())
+	const JDQFactorKernel* kernel = qFactorKernel;
+	JDTaskScheduler* scheduler = GetTaskScheduler();
+	vector<JDEvalContext> contexts(scheduler->GetNumThreads());
+	vector<vector<Double_t*> > threadRows(scheduler->GetNumThreads(),vector<Double_t*>(numTypes));		// row j of each grid
+
+	scheduler->ParallelFor(rowsToDo.size(),[&](Int_t r, Int_t thread)
 	{
-		return (fIntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta->Eval(x[0])-
-				fIntegratedNdOmegaSigma1SmearedEpsilonOffThetaVsTheta->Eval(x[0]))
-				/TMath::Sqrt(jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0]));
-	}
-	else	// NOT CORRECT IF YOU DONT DEFINE A & B
+		Int_t j = rowsToDo[r];
+		vector<Double_t*>& rows = threadRows[thread];
+		for(Int_t t=0; t<numTypes; t++) rows[t]=grids[t]->GetRow(j);
+		kernel->EvaluateRows(expression,wobbleAxis.GetBinCenter(j),thetaAxis,rows.data(),contexts[thread]);
+		isRowSaved[j].store(1,std::memory_order_release);
+
+		if(!isCheckpointing || !checkpointMutex.try_lock()) return;
+		if(std::chrono::steady_clock::now()>=nextCheckpoint)
+		{
+			vector<Bool_t> isCheckpointRowDone(numBinsY);
+			for(Int_t i=0; i<numBinsY; i++) isCheckpointRowDone[i] = isRowSaved[i].load(std::memory_order_acquire);
+			for(Int_t t=0; t<numTypes; t++)
+			{
+				JDGrid2D checkpoint(thetaAxis,wobbleAxis);
+				for(Int_t i=0; i<numBinsY; i++)
+				{
+					if(isCheckpointRowDone[i]) std::copy(grids[t]->GetRow(i),grids[t]->GetRow(i)+numBinsX,checkpoint.GetRow(i));
+				}
+				surfaceStore->SavePartialSurface(configurations[t],checkpoint,isCheckpointRowDone);
+			}
+			nextCheckpoint = std::chrono::steady_clock::now()+checkpointInterval;
+		}
+		checkpointMutex.unlock();
+	});
+
+	// the complete surfaces replace their checkpoints
+	if(surfaceStore)
 	{
-		return 	fIntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta->Eval(x[0])
-				/
-				(TMath::Sqrt( jdInstrument->fIntegrateEpsilonThetaVsTheta->Eval(x[0])+
-				fIntegratedNdOmegaSigma1SmearedEpsilonOffThetaVsTheta->Eval(x[0])));
+		for(Int_t t=0; t<numTypes; t++) surfaceStore->SaveSurface(configurations[t],*grids[t]);
 	}
 }
 
 //-----------------------------------------------
-// It integrates the dNdOmega · Epsilon [# · deg^{-2}] vs Theta [deg] and Phi [rad] multiplied by Theta [deg] in order to obtain the N(Delta Omega) [#]
-//
-// x[0] 	= dTheta [deg]
-// par[0] 	= offset distance [deg]
-Double_t JDOptimization::IntegratedNdOmegaEpsilonThetaVsTheta(Double_t* x, Double_t* par)
-{
-	fdNdOmegaEpsilonThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
-}
-
-//-----------------------------------------------
-//
-Double_t JDOptimization::IntegratedNdOmegaSmearedEpsilonThetaVsTheta(Double_t* x, Double_t* par)
-{
-	fdNdOmegaSmearedEpsilonThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSmearedEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
-}
-
-//-----------------------------------------------
-//
-Double_t JDOptimization::IntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta(Double_t* x, Double_t* par)
+//	It deletes the cached grids
+void JDOptimization::ClearGridsQFactorVsThetaWobble()
 {
-	fdNdOmegaSigma1SmearedEpsilonThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1SmearedEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	for(std::map<Int_t, JDGrid2D*>::iterator it=mapGridQFactorVsThetaWobble.begin(); it!=mapGridQFactorVsThetaWobble.end(); it++) delete it->second;
+	mapGridQFactorVsThetaWobble.clear();
 }
 
 //-----------------------------------------------
-//
-Double_t JDOptimization::IntegratedNdOmegaSmearedEpsilonOffThetaVsTheta(Double_t* x, Double_t* par)
-{
-	fdNdOmegaSmearedEpsilonOffThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSmearedEpsilonOffThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+//	It samples (serially) into the QFactor kernel the profile and the acceptance needed for these effects
+//	(see JDQFactorKernel::Effect), smearing the profile first if needed. With a surface store the sampled tables are
+//	read from it if they are there and stored otherwise, so the smearing is done once per source and resolution.
+void JDOptimization::InitQFactorKernel(Int_t effects)
+{
+	if(!qFactorKernel) qFactorKernel = new JDQFactorKernel();
+	qFactorKernel->SetIsSphericalCoordinates(jdDarkMatter->GetIsSphericalCoordinates());
+	qFactorKernel->SetIsOnMinusOff(GetIsIntegraldNdOmegaOnMinusOFF());
+	qFactorKernel->SetPanelWidth(GetBinResolution());
+	qFactorKernel->SetIsSpecialized(bIsQFactorKernelSpecialized);
+	qFactorKernel->SetReductionMode(iReductionMode);
+	qFactorKernel->SetBackgroundGeometry(backgroundGeometry);
+
+	Double_t step = GetBinResolution()/10.;				// [deg]
+
+	Int_t profileIndex = JDQFactorKernel::GetProfileIndex(effects);
+	if(!qFactorKernel->GetIsProfile(profileIndex))
+	{
+		// The OFF regions can be up to thetaMax+2·wobbleMax from the source
+		Double_t thetaMax = GetThetaMax()+2*GetDistCameraCenterMax();
+		TString tableConfiguration;
+		JDGrid1D* table = NULL;
+		if(surfaceStore)
+		{
+			tableConfiguration = TString::Format("table=dNdOmega range=%.10g step=%.10g ",thetaMax,step)+
+								 GetConfiguration(effects&(JDQFactorKernel::kUncertainty|JDQFactorKernel::kSmearing));
+			table = surfaceStore->LoadTable(tableConfiguration);
+		}
+		if(table)
+		{
+			qFactorKernel->SetProfile(profileIndex,*table);
+			delete table;
+		}
+		else
+		{
+			TF1* dNdOmega;
+			if(effects&JDQFactorKernel::kSmearing)
+			{
+				if(effects&JDQFactorKernel::kUncertainty)
+				{
+					InitdNdOmegaSigma1Smeared();
+					dNdOmega = fdNdOmegaSigma1SmearedVsTheta;
+				}
+				else
+				{
+					InitdNdOmegaSmeared();
+					dNdOmega = fdNdOmegaSmearedVsTheta;
+				}
+			}
+			else
+			{
+				dNdOmega = ((effects&JDQFactorKernel::kUncertainty)? jdDarkMatter->GetTF1dNdOmegaSigma1VsTheta() : jdDarkMatter->GetTF1dNdOmegaVsTheta());
+			}
+
+			qFactorKernel->SetProfile(profileIndex,dNdOmega,thetaMax,step);
+			if(surfaceStore) surfaceStore->SaveTable(tableConfiguration,qFactorKernel->GetProfile(profileIndex));
+		}
+	}
+
+	if((effects&JDQFactorKernel::kAcceptance) && !qFactorKernel->GetIsEpsilon())
+	{
+		// the acceptance only depends on the instrument: one table for all the sources
+		TString tableConfiguration;
+		JDGrid1D* table = NULL;
+		if(surfaceStore)
+		{
+			tableConfiguration = TString::Format("table=epsilon instrument=%s acceptance=%s ideal=%d distCameraCenterMax=%.10g step=%.10g",
+												 GetInstrumentName().Data(),GetAcceptanceHash().Data(),GetIsIdeal(),GetDistCameraCenterMax(),step);
+			table = surfaceStore->LoadTable(tableConfiguration);
+		}
+		if(table)
+		{
+			qFactorKernel->SetEpsilon(*table,GetDistCameraCenterMax());
+			delete table;
+		}
+		else
+		{
+			qFactorKernel->SetEpsilon(GetTF1EpsilonVsDcc(),GetDistCameraCenterMax(),step);
+			if(surfaceStore) surfaceStore->SaveTable(tableConfiguration,qFactorKernel->GetEpsilon());
+		}
+	}
 }
 
 //-----------------------------------------------
-//
-Double_t JDOptimization::IntegratedNdOmegaSigma1SmearedEpsilonOffThetaVsTheta(Double_t* x, Double_t* par)
+//	It samples now into the QFactor kernel everything the type needs (see InitQFactorKernel()). It is the only step
+//	of GetGridQFactorVsThetaWobble() and GetOptimalThetaAndWobble() that touches ROOT objects, so after it they
+//	can be run from another thread (see JDCampaign). It returns 0 if the type is not valid.
+Bool_t JDOptimization::PrepareQFactorKernel(Int_t type)
 {
-	fdNdOmegaSigma1SmearedEpsilonOffThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1SmearedEpsilonOffThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	Int_t effects = JDQFactorKernel::GetEffects(type);
+	if(effects<0)
+	{
+		cout << "   *********************************" << endl;
+		cout << "   ***                           ***" << endl;
+		cout << "   ***  WARNING:                 ***" << endl;
+		cout << "   ***  Unknown type of QFactor  ***" << endl;
+		cout << "   ***                           ***" << endl;
+		cout << "   *********************************" << endl;
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> lock(mGridMutex);
+	InitQFactorKernel(effects);
+	return 1;
 }
 
 //-----------------------------------------------
-//
-Double_t JDOptimization::IntegratedNdOmegaSmearedThetaVsTheta(Double_t* x, Double_t* par)
+//	It sets the number of threads used to fill the QFactor grids (0: one per hardware thread)
+void JDOptimization::SetNumThreads(Int_t numThreads)
 {
-	return fdNdOmegaSmearedThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	std::lock_guard<std::mutex> lock(mGridMutex);
+	iNumThreads = numThreads;
+	if(taskScheduler) delete taskScheduler;
+	taskScheduler = NULL;
 }
 
 //-----------------------------------------------
-//
-Double_t JDOptimization::IntegratedNdOmegaSmearedOffThetaVsTheta(Double_t* x, Double_t* par)
+//	It prints the tasks (wobble rows), steals and utilization of each thread in the last fill of the QFactor grids
+void JDOptimization::PrintThreadUtilization()
 {
-	fdNdOmegaSmearedOffThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSmearedOffThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	std::lock_guard<std::mutex> lock(mGridMutex);
+	if(taskScheduler) taskScheduler->PrintUtilization();
 }
 
 //-----------------------------------------------
-// It integrates the dNdOmega_off · Epsilon [# · deg^{-2}] vs Theta [deg] and Phi [rad] multiplied by Theta [deg] in order to obtain the N(Delta Omega) [#]
-//
-// x[0] 	= dTheta [deg]
-// par[0] 	= offset distance [deg]
-Double_t JDOptimization::IntegratedNdOmegaOffEpsilonThetaVsTheta(Double_t* x, Double_t* par)
+//	It chooses the QFactor kernels specialized for each type or the generic one (see JDQFactorKernel).
+//	Both give the same QFactors; the cached grids are computed again with the new choice.
+void JDOptimization::SetIsQFactorKernelSpecialized(Bool_t isQFactorKernelSpecialized)
 {
-	fdNdOmegaOffEpsilonThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaOffEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	std::lock_guard<std::mutex> lock(mGridMutex);
+	bIsQFactorKernelSpecialized = isQFactorKernelSpecialized;
+	ClearGridsQFactorVsThetaWobble();
 }
 
 //-----------------------------------------------
-// It integrates the dNdOmega_off_sig1 · Epsilon [# · deg^{-2}] vs Theta [deg] and Phi [rad] multiplied by Theta [deg] in order to obtain the N(Delta Omega) [#]
-//
-// x[0] 	= dTheta [deg]
-// par[0] 	= offset distance [deg]
-Double_t JDOptimization::IntegratedNdOmegaSigma1OffEpsilonThetaVsTheta(Double_t* x, Double_t* par)
+//	It sets how the QFactor kernel adds its panels (see JDReduction::Mode). The cached grids are computed again.
+void JDOptimization::SetReductionMode(Int_t reductionMode)
 {
-	fdNdOmegaSigma1OffEpsilonThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1OffEpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	std::lock_guard<std::mutex> lock(mGridMutex);
+	iReductionMode = reductionMode;
+	ClearGridsQFactorVsThetaWobble();
 }
 
 //-----------------------------------------------
-// It integrates the dNdOmega_off_sig1 · Epsilon [# · deg^{-2}] vs Theta [deg] and Phi [rad] multiplied by Theta [deg] in order to obtain the N(Delta Omega) [#]
-//
-Double_t JDOptimization::IntegratedNdOmegaSigma1SmearedThetaVsTheta(Double_t* x, Double_t* par)
+//	It sets the wobble pointings and the OFF regions of the leakage (see JDBackgroundGeometry).
+//	The cached grids are computed again with the new OFF regions.
+void JDOptimization::SetBackgroundGeometry(const JDBackgroundGeometry& geometry)
 {
-	fdNdOmegaSigma1SmearedThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1SmearedThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	std::lock_guard<std::mutex> lock(mGridMutex);
+	backgroundGeometry = geometry;
+	ClearGridsQFactorVsThetaWobble();
 }
 
 //-----------------------------------------------
-//
-//
-Double_t JDOptimization::IntegratedNdOmegaSigma1SmearedOffThetaVsTheta(Double_t* x, Double_t* par)
+//	It uses the store in the directory storePath (created if needed) for the QFactor surfaces and the optimal points.
+//	The surfaces are not normalized, so a stored surface serves any normalization (GetTH2QFactorVsThetaWobble()) and
+//	any tolerance (GetOptimalThetaAndWobble() in kGridScan). An empty path stops using the store.
+void JDOptimization::SetSurfaceStore(TString storePath)
 {
-	fdNdOmegaSigma1SmearedOffThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1SmearedOffThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	std::lock_guard<std::mutex> lock(mGridMutex);
+	if(surfaceStore) delete surfaceStore;
+	surfaceStore = (storePath.Length()>0? new JDSurfaceStore(storePath) : NULL);
 }
 
 //-----------------------------------------------
-// It integrates the dNdOmega_sig1 · Epsilon [# · deg^{-2}] vs Theta [deg] and Phi [rad] multiplied by Theta [deg] in order to obtain the N(Delta Omega) [#]
-//
-// x[0] 	= dTheta [deg]
-// par[0] 	= offset distance [deg]
-Double_t JDOptimization::IntegratedNdOmegaSigma1EpsilonThetaVsTheta(Double_t* x, Double_t* par)
+//	It sets every how many seconds the rows of the QFactor grids being filled are saved into the surface store
+//	(see BuildGridsQFactorVsThetaWobble()). A value <=0 disables the checkpoints.
+void JDOptimization::SetCheckpointInterval(Double_t checkpointInterval)
 {
-	fdNdOmegaSigma1EpsilonThetaVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1EpsilonThetaVsThetaPhi->Integral(0.,x[0],0.,2*TMath::Pi(),1e-2);
+	std::lock_guard<std::mutex> lock(mGridMutex);
+	dCheckpointInterval = checkpointInterval;
 }
 
-//----------------------------------------------------
-// It evaluates the dNdOmega·Epsilon multiplied by Sin(Theta) vs Theta and Phi.
-// The dNdOmega can be also multiplied by Theta if we are not considering Spherical Coordinates.
-//
-// x[0]		= theta	[deg]
-// x[1]		= phi	[rad]
-// x0rad    = theta [rad]
-// par[0] 	= offset distance [deg]
-Double_t JDOptimization::dNdOmegaEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It returns the configuration of the QFactor surface of these effects (see JDQFactorKernel::Effect):
+//	everything the surface depends on, as "name=value" pairs. Two JDOptimization with the same configuration
+//	give the same surface, so it is the key of the surface store. The profile and the acceptance are identified by
+//	their content (see GetProfileHash() and GetAcceptanceHash()): the halos and the instruments built from a TGraph
+//	or a txt file have no source, author, candidate nor instrument name.
+TString JDOptimization::GetConfiguration(Int_t effects)
 {
-	Double_t X0rad =x[0]*dDeg2Rad;
-	fdNdOmegaEpsilonThetaVsThetaPhi->SetParameter(0,par[0]);
-
-	if (GetIsSphericalCoordinates()==1)
-	{
-		return fdNdOmegaEpsilonThetaVsThetaPhi->Eval(x[0],x[1])*TMath::Sin(X0rad);
-	}
-	else
-	{
-		return fdNdOmegaEpsilonThetaVsThetaPhi->Eval(x[0],x[1])*x[0];
-	}
+	return TString::Format("source=%s author=%s candidate=%s profile=%s instrument=%s acceptance=%s ideal=%d distCameraCenterMax=%.10g thetaMax=%.10g "
+						   "resolution=%.10g spherical=%d onMinusOff=%d smearingAdaptive=%d smearingCoreResolution=%.10g reduction=%d %s effects=%d",
+						   GetSourceName().Data(), GetAuthor().Data(), GetCandidate().Data(), GetProfileHash().Data(), GetInstrumentName().Data(), GetAcceptanceHash().Data(), GetIsIdeal(),
+						   GetDistCameraCenterMax(), GetThetaMax(), GetBinResolution(), jdDarkMatter->GetIsSphericalCoordinates(),
+						   GetIsIntegraldNdOmegaOnMinusOFF(), GetIsSmearingAdaptive(), GetSmearingCoreResolution(), GetReductionMode(),
+						   backgroundGeometry.GetConfiguration().Data(), effects);
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSmearedOffVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It adds the points of graph to the 64-bit FNV-1a hash (see JDSurfaceStore::GetHash())
+ULong64_t JDOptimization::GetGraphHash(TGraph* graph, ULong64_t hash)
 {
-	Double_t distCenterSource = TMath::Sqrt(x[0]*x[0]+par[0]*par[0]-2*x[0]*par[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
-
-	return fdNdOmegaSmearedVsTheta->Eval(distCenterSource);
+	if(!graph) return hash;
+	hash = JDSurfaceStore::GetHash(graph->GetX(),sizeof(Double_t)*graph->GetN(),hash);
+	return JDSurfaceStore::GetHash(graph->GetY(),sizeof(Double_t)*graph->GetN(),hash);
 }
 
-//----------------------------------------------------
-//	dN/dOmega * Epsilon
-// x[0] = theta [deg]
-// x[1] = phi 	[rad]
-//  par[0] = wobble [deg]
-//
-// dccR [deg] 			distance to fov center
-Double_t JDOptimization::dNdOmegaEpsilonVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It returns the hash of the JFactor of the halo (median, and 1 sigma if it has it), from which dN/dOmega is derived
+TString JDOptimization::GetProfileHash()
 {
-	Double_t dccR = TMath::Sqrt(TMath::Power(par[0],2)+TMath::Power(x[0],2)-2*par[0]*x[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
-	return jdDarkMatter->fdNdOmegaVsTheta->Eval(x[0])*jdInstrument->fEpsilonVsDcc->Eval(dccR);
+	ULong64_t hash = GetGraphHash(jdDarkMatter->GetTGraphJFactorBand(JDDarkMatter::kMedian),JDSurfaceStore::kHashOffsetBasis);
+	if(jdDarkMatter->GetIsJFactorSigma1()) hash = GetGraphHash(jdDarkMatter->GetTGraphJFactorBand(JDDarkMatter::kMinus1Sigma),hash);
+	return TString::Format("%016llx",(unsigned long long)hash);
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSmearedEpsilonVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It returns the hash of the camera acceptance of the instrument
+TString JDOptimization::GetAcceptanceHash()
 {
-	Double_t dccR = TMath::Sqrt(TMath::Power(par[0],2)+TMath::Power(x[0],2)-2*par[0]*x[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
-	return fdNdOmegaSmearedVsTheta->Eval(x[0])*jdInstrument->fEpsilonVsDcc->Eval(dccR);
+	ULong64_t hash = GetGraphHash(jdInstrument->GetTGraphCameraAcceptance(),JDSurfaceStore::kHashOffsetBasis);
+	return TString::Format("%016llx",(unsigned long long)hash);
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSigma1SmearedEpsilonVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It returns the task scheduler, created the first time it is needed
+JDTaskScheduler* JDOptimization::GetTaskScheduler()
 {
-	Double_t dccR = TMath::Sqrt(TMath::Power(par[0],2)+TMath::Power(x[0],2)-2*par[0]*x[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
-	return fdNdOmegaSigma1SmearedVsTheta->Eval(x[0])*jdInstrument->fEpsilonVsDcc->Eval(dccR);
+	if(!taskScheduler) taskScheduler = new JDTaskScheduler(iNumThreads);
+	return taskScheduler;
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSmearedEpsilonOffVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It returns a TH2D with the QFactor vs theta [deg] and wobble [deg]
+//	If thetaNorm or wobbleNorm are negative, it is normalized to its maximum. Otherwise, to its value at (thetaNorm, wobbleNorm)
+//	The caller owns the histogram.
+TH2D* JDOptimization::GetTH2QFactorVsThetaWobble(Int_t type, Double_t thetaNorm, Double_t wobbleNorm)
 {
-	Double_t dccR = TMath::Sqrt(TMath::Power(par[0],2)+TMath::Power(x[0],2)-2*par[0]*x[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
-	fdNdOmegaSmearedOffVsThetaPhi->SetParameter(0,2*par[0]);
-	return fdNdOmegaSmearedOffVsThetaPhi->Eval(x[0],x[1])*jdInstrument->fEpsilonVsDcc->Eval(dccR);
-}
+	const JDGrid2D* grid = GetGridQFactorVsThetaWobble(type);
+	if(!grid) return NULL;
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSigma1SmearedEpsilonOffVsThetaPhi(Double_t* x, Double_t* par)
-{
-	Double_t dccR = TMath::Sqrt(TMath::Power(par[0],2)+TMath::Power(x[0],2)-2*par[0]*x[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
-	fdNdOmegaSigma1SmearedOffVsThetaPhi->SetParameter(0,2*par[0]);
-	return fdNdOmegaSigma1SmearedOffVsThetaPhi->Eval(x[0],x[1])*jdInstrument->fEpsilonVsDcc->Eval(dccR);
-}
+	Double_t normValue;
+	if(thetaNorm <0. || wobbleNorm<0.)
+	{
+		normValue = grid->GetMaximum();
+	}
+	else
+	{
+		Int_t iThetaNorm = grid->GetXaxis().FindBin(thetaNorm);
+		Int_t jWobbleNorm = grid->GetYaxis().FindBin(wobbleNorm);
+		normValue = grid->GetBinContent(iThetaNorm,jWobbleNorm);
+	}
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSmearedVsTheta(Double_t* x, Double_t* par)
-{
-	return gdNdOmegaSmeared->Eval(x[0]);
+	return grid->ToTH2D("h2","",1./normValue);
 }
 
-//----------------------------------------------------
-//	dN/dOmega * Epsilon * theta
-// x[0] = theta [deg]
-// x[1] = phi 	[rad]
-// par[0] = wobble distance
-// dccR [deg] 			distance to fov center
-Double_t JDOptimization::dNdOmegaEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It returns the iso-QFactor contours where the QFactor is level times its maximum, as TGraphs of wobble [deg] vs theta [deg].
+//	They are extracted by marching squares from the cached grid (see JDGrid2D::GetContours()): a closed contour
+//	surrounds the region above the level, an open one ends at the border of the grid.
+std::vector<TGraph*> JDOptimization::GetContoursQFactorVsThetaWobble(Double_t level, Int_t type)
 {
-	fdNdOmegaEpsilonVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaEpsilonVsThetaPhi->Eval(x[0],x[1])*x[0];
-}
+	const JDGrid2D* grid = GetGridQFactorVsThetaWobble(type);
+	if(!grid) return std::vector<TGraph*>();
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSmearedEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par)
-{
-	fdNdOmegaSmearedEpsilonVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSmearedEpsilonVsThetaPhi->Eval(x[0],x[1])*x[0];
+	return grid->GetContours(level*grid->GetMaximum());
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSigma1SmearedEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par)
-{
-	fdNdOmegaSigma1SmearedEpsilonVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1SmearedEpsilonVsThetaPhi->Eval(x[0],x[1])*x[0];
-}
+//-----------------------------------------------
+//	It gives the optimal theta and wobble [deg] and the range where the QFactor is above (1-tolerance) of its maximum,
+//	along theta and wobble through the maximum. It returns the maximum QFactor (not normalized).
+//	The search is done according to the optimization mode (see SetOptimizationMode()):
+//		kGridScan:	maximum of the grid given by GetGridQFactorVsThetaWobble (low edges of the bins)
+//		kBrentScan:	Brent maximization in theta nested in a Brent maximization in wobble (continuous, no grid)
+//		kRefinedScan:	same bins as kGridScan, refined from a coarse grid only where the maximum or the range can be
+Double_t JDOptimization::GetOptimalThetaAndWobble(Double_t &thetaOpt, Double_t &thetaOptRangMin, Double_t &thetaOptRangMax, Double_t &wobbleOpt, Double_t &wobbleOptRangMin, Double_t &wobbleOptRangMax, Int_t type)
+{
+	Double_t tolerance = GetTolerance();
+
+	iNumQFactorEvaluations = 0;
+
+	// optimal point already in the store (see SetSurfaceStore())
+	Int_t effects = JDQFactorKernel::GetEffects(type);
+	Double_t optimum[JDSurfaceStore::kNumOptimumValues];
+	if(surfaceStore && effects>=0 && surfaceStore->LoadOptimum(GetConfiguration(effects),GetOptimizationMode(),tolerance,optimum))
+	{
+		thetaOpt=optimum[1];	thetaOptRangMin=optimum[2];		thetaOptRangMax=optimum[3];
+		wobbleOpt=optimum[4];	wobbleOptRangMin=optimum[5];	wobbleOptRangMax=optimum[6];
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSmearedEpsilonOffThetaVsThetaPhi(Double_t* x, Double_t* par)
-{
-	fdNdOmegaSmearedEpsilonOffVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSmearedEpsilonOffVsThetaPhi->Eval(x[0],x[1])*x[0];
+		if(GetIsVerbose())
+		{
+			cout << "   *******************************************" << endl;
+			cout << "   ***                                     ***" << endl;
+			cout << "   ***  Optimal theta and wobble (stored)  ***" << endl;
+			cout << "   ***                                     ***" << endl;
+			cout << "   *******************************************" << endl;
+		}
+		return optimum[0];
+	}
+
+	Double_t qfactorMax;
+	if(GetOptimizationMode()==kBrentScan)
+	{
+		qfactorMax = GetOptimalThetaAndWobbleFromBrent(thetaOpt,thetaOptRangMin,thetaOptRangMax,wobbleOpt,wobbleOptRangMin,wobbleOptRangMax,type,tolerance);
+	}
+	else if(GetOptimizationMode()==kRefinedScan)
+	{
+		qfactorMax = GetOptimalThetaAndWobbleFromRefinement(thetaOpt,thetaOptRangMin,thetaOptRangMax,wobbleOpt,wobbleOptRangMin,wobbleOptRangMax,type,tolerance);
+	}
+	else
+	{
+		qfactorMax = GetOptimalThetaAndWobbleFromGrid(thetaOpt,thetaOptRangMin,thetaOptRangMax,wobbleOpt,wobbleOptRangMin,wobbleOptRangMax,type,tolerance);
+	}
+
+	if(qfactorMax>0.)
+	{
+		if(surfaceStore)
+		{
+			optimum[0]=qfactorMax;
+			optimum[1]=thetaOpt;	optimum[2]=thetaOptRangMin;		optimum[3]=thetaOptRangMax;
+			optimum[4]=wobbleOpt;	optimum[5]=wobbleOptRangMin;	optimum[6]=wobbleOptRangMax;
+			surfaceStore->SaveOptimum(GetConfiguration(effects),GetOptimizationMode(),tolerance,optimum);
+		}
+
+		if(GetIsVerbose())
+		{
+			cout << "   ****************************************" << endl;
+			cout << "   ***                                  ***" << endl;
+			cout << "   ***  Optimal theta and wobble found  ***" << endl;
+			cout << "   ***                                  ***" << endl;
+			cout << "   ****************************************" << endl;
+		}
+	}
+	else if(!GetIsVerbose())
+	{
+		// one output operation: the lines of several jobs running at the same time do not mix
+		cout << TString::Format("   WARNING: problem occurred maximizing the qfactor %d of %s\n",type,GetSourceName().Data()) << std::flush;
+	}
+	else
+	{
+		cout << "   **************************************************" << endl;
+		cout << "   ***                                            ***" << endl;
+		cout << "   ***  WARNING:                                  ***" << endl;
+		cout << "   ***  problem occurred maximizing the qfactor   ***" << endl;
+		cout << "   ***                                            ***" << endl;
+		cout << "   **************************************************" << endl;
+	}
+
+	return qfactorMax;
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSigma1SmearedEpsilonOffThetaVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	Optimal theta and wobble [deg] from the grid: low edge of the bin with the maximum QFactor,
+//	and ranges by linear scans along the row and the column of the maximum
+Double_t JDOptimization::GetOptimalThetaAndWobbleFromGrid(Double_t &thetaOpt, Double_t &thetaOptRangMin, Double_t &thetaOptRangMax, Double_t &wobbleOpt, Double_t &wobbleOptRangMin, Double_t &wobbleOptRangMax, Int_t type, Double_t tolerance)
 {
-	fdNdOmegaSigma1SmearedEpsilonOffVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1SmearedEpsilonOffVsThetaPhi->Eval(x[0],x[1])*x[0];
+	const JDGrid2D* grid = GetGridQFactorVsThetaWobble(type);
+	if(!grid) return 0.;
+
+	iNumQFactorEvaluations = grid->GetNumBinsX()*grid->GetNumBinsY();
+	return GetOptimalThetaAndWobble(*grid,tolerance,thetaOpt,thetaOptRangMin,thetaOptRangMax,wobbleOpt,wobbleOptRangMin,wobbleOptRangMax);
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSmearedThetaVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	Optimal theta and wobble [deg] of any grid of QFactor vs theta (x) and wobble (y) (see GetGridQFactorVsThetaWobble()):
+//	low edge of the bin with the maximum, and ranges where the QFactor is above (1-tolerance) of it, by linear scans
+//	along the row and the column of the maximum. It returns the maximum QFactor. It touches no ROOT object.
+Double_t JDOptimization::GetOptimalThetaAndWobble(const JDGrid2D& grid, Double_t tolerance, Double_t &thetaOpt, Double_t &thetaOptRangMin, Double_t &thetaOptRangMax, Double_t &wobbleOpt, Double_t &wobbleOptRangMin, Double_t &wobbleOptRangMax)
 {
-	return fdNdOmegaSmearedVsTheta->Eval(x[0])*x[0];
+	const JDGridAxis& thetaAxis = grid.GetXaxis();
+	const JDGridAxis& wobbleAxis = grid.GetYaxis();
+
+	Int_t numBinsX = grid.GetNumBinsX();
+	Int_t numBinsY = grid.GetNumBinsY();
+
+	Int_t thetaBin=0;
+	Int_t wobbleBin=0;
+	Double_t qfactorMax = grid.GetMaximum(&thetaBin,&wobbleBin);
+	thetaOpt=thetaAxis.GetBinLowEdge(thetaBin);
+	wobbleOpt=wobbleAxis.GetBinLowEdge(wobbleBin);
+
+	const Double_t* row = grid.GetRow(wobbleBin);
+	for(Int_t i=0; i<numBinsX; i++)
+	{
+		if(row[i]>=(1-tolerance)*qfactorMax)
+		{
+			thetaOptRangMin=thetaAxis.GetBinLowEdge(i);
+			break;
+		}
+	}
+
+	for(Int_t i=numBinsX-1; i>=0; i--)
+	{
+		if(row[i]>=(1-tolerance)*qfactorMax)
+		{
+			thetaOptRangMax=thetaAxis.GetBinLowEdge(i);
+			break;
+		}
+	}
+
+	for(Int_t j=0; j<numBinsY; j++)
+	{
+		if(grid.GetBinContent(thetaBin,j)>=(1-tolerance)*qfactorMax)
+		{
+			wobbleOptRangMin=wobbleAxis.GetBinLowEdge(j);
+			break;
+		}
+	}
+
+	for(Int_t j=numBinsY-1; j>=0; j--)
+	{
+		if(grid.GetBinContent(thetaBin,j)>=(1-tolerance)*qfactorMax)
+		{
+			wobbleOptRangMax=wobbleAxis.GetBinLowEdge(j);
+			break;
+		}
+	}
+
+	return qfactorMax;
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSmearedOffThetaVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	Coarse nodes of a refinement scan on numBins bins: every blockSize bins, plus the last one
+static vector<Int_t> GetCoarseNodes(Int_t numBins, Int_t blockSize)
 {
-	fdNdOmegaSmearedOffVsThetaPhi->SetParameter(0,2*par[0]);
-	return fdNdOmegaSmearedOffVsThetaPhi->Eval(x[0],x[1])*x[0];
+	vector<Int_t> nodes;
+	for(Int_t i=0; i<numBins-1; i+=blockSize) nodes.push_back(i);
+	nodes.push_back(numBins-1);
+	return nodes;
 }
 
-//----------------------------------------------------
-//	dN/dOmega_Sigma1 * Epsilon
-//
-// x[0] = theta [deg]
-// x[1] = phi 	[rad]
-//  par[0] = wobble [deg]
-// dccR [deg] distance to fov center
-Double_t JDOptimization::dNdOmegaSigma1EpsilonVsThetaPhi(Double_t* x, Double_t* par)
-{
-	Double_t dccR = TMath::Sqrt(TMath::Power(par[0],2)+TMath::Power(x[0],2)-2*par[0]*x[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
-	return jdDarkMatter->fdNdOmegaSigma1VsTheta->Eval(x[0])*jdInstrument->fEpsilonVsDcc->Eval(dccR);
+//-----------------------------------------------
+//	It finds the bin (iMax, jMax) with the maximum of q(i,j) on a numBinsX x numBinsY lattice without evaluating all of it.
+//	q is evaluated on the coarse nodes (every blockSize bins). The slope of q [per bin] of each coarse cell is estimated
+//	as safety times the largest slope of the edges of the cell and of its neighbours, and gives an upper bound of q
+//	inside the cell. The cell with the largest bound is split in four until no cell can exceed the best value found.
+//	The bound is a heuristic, not a proof: a peak narrower than a coarse cell, steeper than safety times the slopes
+//	seen around it, can be missed. The QFactor is smooth on the scale of blockSize bins, so it is not expected.
+//	q should cache its values: corners are shared between cells.
+static Double_t FindMaximumByRefinement(const std::function<Double_t(Int_t,Int_t)>& q, Int_t numBinsX, Int_t numBinsY, Int_t blockSize, Double_t safety, Int_t& iMax, Int_t& jMax)
+{
+	struct Cell
+	{
+		Int_t i0, i1, j0, j1;
+		Double_t slope;
+		Double_t upperBound;
+		Bool_t operator<(const Cell& cell) const {return upperBound<cell.upperBound;}
+	};
+
+	vector<Int_t> nodesX = GetCoarseNodes(numBinsX,blockSize);
+	vector<Int_t> nodesY = GetCoarseNodes(numBinsY,blockSize);
+	Int_t numCellsX = TMath::Max((Int_t)nodesX.size()-1,1);
+	Int_t numCellsY = TMath::Max((Int_t)nodesY.size()-1,1);
+
+	Double_t best = q(0,0);
+	iMax=0;
+	jMax=0;
+	auto updateBest = [&](Int_t i, Int_t j)
+	{
+		Double_t value = q(i,j);
+		if(value>best) {best=value; iMax=i; jMax=j;}
+		return value;
+	};
+
+	// slope of the edges of each coarse cell
+	vector<Double_t> edgeSlope(numCellsX*numCellsY,0.);
+	for(Int_t cy=0; cy<numCellsY; cy++)
+	{
+		for(Int_t cx=0; cx<numCellsX; cx++)
+		{
+			Int_t i0=nodesX[cx], i1=nodesX[TMath::Min(cx+1,(Int_t)nodesX.size()-1)];
+			Int_t j0=nodesY[cy], j1=nodesY[TMath::Min(cy+1,(Int_t)nodesY.size()-1)];
+			Double_t q00=updateBest(i0,j0), q10=updateBest(i1,j0), q01=updateBest(i0,j1), q11=updateBest(i1,j1);
+			Double_t slope=0.;
+			if(i1>i0) slope=TMath::Max(slope,TMath::Max(TMath::Abs(q10-q00),TMath::Abs(q11-q01))/(i1-i0));
+			if(j1>j0) slope=TMath::Max(slope,TMath::Max(TMath::Abs(q01-q00),TMath::Abs(q11-q10))/(j1-j0));
+			edgeSlope[cx+numCellsX*cy]=slope;
+		}
+	}
+
+	auto getUpperBound = [&](const Cell& cell)
+	{
+		Double_t cornerMax = TMath::Max(TMath::Max(q(cell.i0,cell.j0),q(cell.i1,cell.j0)),TMath::Max(q(cell.i0,cell.j1),q(cell.i1,cell.j1)));
+		Double_t halfDiagonal = 0.5*TMath::Sqrt((Double_t)(cell.i1-cell.i0)*(cell.i1-cell.i0)+(Double_t)(cell.j1-cell.j0)*(cell.j1-cell.j0));
+		return cornerMax+cell.slope*halfDiagonal;
+	};
+
+	std::priority_queue<Cell> cells;
+	for(Int_t cy=0; cy<numCellsY; cy++)
+	{
+		for(Int_t cx=0; cx<numCellsX; cx++)
+		{
+			Double_t slope=0.;
+			for(Int_t ny=TMath::Max(cy-1,0); ny<=TMath::Min(cy+1,numCellsY-1); ny++)
+				for(Int_t nx=TMath::Max(cx-1,0); nx<=TMath::Min(cx+1,numCellsX-1); nx++)
+					slope=TMath::Max(slope,edgeSlope[nx+numCellsX*ny]);
+
+			Cell cell = {nodesX[cx], nodesX[TMath::Min(cx+1,(Int_t)nodesX.size()-1)], nodesY[cy], nodesY[TMath::Min(cy+1,(Int_t)nodesY.size()-1)], safety*slope, 0.};
+			cell.upperBound = getUpperBound(cell);
+			cells.push(cell);
+		}
+	}
+
+	while(!cells.empty())
+	{
+		Cell cell = cells.top();
+		cells.pop();
+		if(cell.upperBound<=best) break;
+		if(cell.i1-cell.i0<=1 && cell.j1-cell.j0<=1) continue;
+
+		// halves in each direction (a direction of one bin is not split)
+		Int_t iMid = (cell.i0+cell.i1)/2;
+		Int_t jMid = (cell.j0+cell.j1)/2;
+		Int_t numX = (cell.i1-cell.i0>1? 2 : 1);
+		Int_t numY = (cell.j1-cell.j0>1? 2 : 1);
+		Int_t is[3] = {cell.i0, (numX==2? iMid : cell.i1), cell.i1};
+		Int_t js[3] = {cell.j0, (numY==2? jMid : cell.j1), cell.j1};
+
+		for(Int_t b=0; b<numY; b++)
+		{
+			for(Int_t a=0; a<numX; a++)
+			{
+				Cell child = {is[a], is[a+1], js[b], js[b+1], cell.slope, 0.};
+				updateBest(child.i0,child.j0);
+				updateBest(child.i1,child.j0);
+				updateBest(child.i0,child.j1);
+				updateBest(child.i1,child.j1);
+				child.upperBound = getUpperBound(child);
+				if(child.upperBound>best) cells.push(child);
+			}
+		}
+	}
+
+	return best;
 }
 
-//----------------------------------------------------
-//	dN/dOmega_off_Sigma1 * Epsilon
-//
-// x[0] = theta [deg]
-// x[1] = phi 	[rad]
-//  par[0] = wobble [deg]
-// dccR [deg] distance to fov center
-Double_t JDOptimization::dNdOmegaSigma1OffEpsilonVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It finds the first bin (from the low side if isFromLow, from the high side otherwise) where q(k)>=level,
+//	k in [0, numBins), without evaluating all the bins: segments between coarse nodes whose upper bound
+//	(same slope estimate as FindMaximumByRefinement) is below level are skipped, the others are bisected.
+//	It returns -1 if no bin reaches level.
+static Int_t FindLevelEdgeByRefinement(const std::function<Double_t(Int_t)>& q, Int_t numBins, Double_t level, Int_t blockSize, Double_t safety, Bool_t isFromLow)
 {
-	Double_t dccR = TMath::Sqrt(TMath::Power(par[0],2)+TMath::Power(x[0],2)-2*par[0]*x[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
-	jdDarkMatter->fdNdOmegaSigma1OffVsThetaPhi->SetParameter(0,2*par[0]);
-	return jdDarkMatter->fdNdOmegaSigma1OffVsThetaPhi->Eval(x[0],x[1])*jdInstrument->fEpsilonVsDcc->Eval(dccR);
+	// along the scan direction
+	auto value = [&](Int_t k) {return (isFromLow? q(k) : q(numBins-1-k));};
+
+	vector<Int_t> nodes = GetCoarseNodes(numBins,blockSize);
+	Int_t numSegments = nodes.size()-1;
+	if(numSegments<=0) return (value(0)>=level? 0 : -1);
+
+	vector<Double_t> segmentSlope(numSegments);
+	for(Int_t s=0; s<numSegments; s++) segmentSlope[s]=TMath::Abs(value(nodes[s+1])-value(nodes[s]))/(nodes[s+1]-nodes[s]);
+
+	// recursive search of the first bin >= level in [k0, k1]
+	std::function<Int_t(Int_t,Int_t,Double_t)> search = [&](Int_t k0, Int_t k1, Double_t slope) -> Int_t
+	{
+		if(value(k0)>=level) return k0;
+		if(k1-k0<=1) return (value(k1)>=level? k1 : -1);
+		if(TMath::Max(value(k0),value(k1))+slope*0.5*(k1-k0)<level) return -1;
+
+		Int_t kMid = (k0+k1)/2;
+		Int_t k = search(k0,kMid,slope);
+		return (k>=0? k : search(kMid,k1,slope));
+	};
+
+	for(Int_t s=0; s<numSegments; s++)
+	{
+		Double_t slope = segmentSlope[s];
+		if(s>0) slope=TMath::Max(slope,segmentSlope[s-1]);
+		if(s<numSegments-1) slope=TMath::Max(slope,segmentSlope[s+1]);
+
+		Int_t k = search(nodes[s],nodes[s+1],safety*slope);
+		if(k>=0) return (isFromLow? k : numBins-1-k);
+	}
+	return -1;
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSigma1SmearedOffVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It returns where f crosses level between xIn (f(xIn)>=level) and xOut, by bisection down to precision.
+//	If f(xOut)>=level too, it returns xOut.
+static Double_t FindLevelCrossing(const std::function<Double_t(Double_t)>& f, Double_t level, Double_t xIn, Double_t xOut, Double_t precision)
 {
-	Double_t distCenterSourceOff = TMath::Sqrt(TMath::Power(par[0],2)+TMath::Power(x[0],2)-2*par[0]*x[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
+	if(f(xOut)>=level) return xOut;
 
-	return gdNdOmegaSigma1Smeared->Eval(distCenterSourceOff);
+	while(TMath::Abs(xOut-xIn)>precision)
+	{
+		Double_t x = 0.5*(xIn+xOut);
+		if(f(x)>=level)	xIn=x;
+		else			xOut=x;
+	}
+	return 0.5*(xIn+xOut);
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSigma1SmearedVsTheta(Double_t* x, Double_t* par)
-{
-	return gdNdOmegaSigma1Smeared->Eval(x[0]);
+//-----------------------------------------------
+//	Optimal theta and wobble [deg] on the same bins as the grid, but refining from a coarse grid
+//	(see FindMaximumByRefinement()) instead of evaluating all the bins. The ranges are found along the row and
+//	column of the maximum in the same way (see FindLevelEdgeByRefinement()), so the results are normally the ones of
+//	GetOptimalThetaAndWobbleFromGrid() (the bound of the refinement is a heuristic).
+//	The bins are computed with the radial sweep of the grid, along the wobble rows the refinement touches: a bin
+//	asked beyond the part of its row swept so far continues the sweep of the row up to it (see
+//	JDQFactorKernel::ContinueRow()), so every bin is evaluated once, and only the bins of a row up to the farthest
+//	one asked are evaluated. GetNumQFactorEvaluations() counts the bins swept.
+//	If a range is not found (the bound of the refinement missed it), it is the edge of the axis.
+Double_t JDOptimization::GetOptimalThetaAndWobbleFromRefinement(Double_t &thetaOpt, Double_t &thetaOptRangMin, Double_t &thetaOptRangMax, Double_t &wobbleOpt, Double_t &wobbleOptRangMin, Double_t &wobbleOptRangMax, Int_t type, Double_t tolerance)
+{
+	std::lock_guard<std::mutex> lock(mGridMutex);
+
+	Int_t effects = JDQFactorKernel::GetEffects(type);
+	if(effects<0) return 0.;
+	InitQFactorKernel(effects);
+
+	const Int_t blockSize = 8;		// [bins] of the coarse grid
+	const Double_t safety = 2.;		// on the slope estimated from the coarse grid
+
+	Double_t resolution = GetBinResolution();			//[deg/bin]
+	Double_t thetaMax = GetThetaMax();					// [deg]
+	Int_t numBinsX = thetaMax/resolution; 				// [#bins]
+	Double_t wobbleMax = GetDistCameraCenterMax();		// [deg]
+	Int_t numBinsY = wobbleMax/resolution; 				// [#bins]
+	if(numBinsX<=0 || numBinsY<=0) return 0.;
+
+	JDGrid2D qFactor(JDGridAxis(numBinsX,0.,thetaMax),JDGridAxis(numBinsY,0.,wobbleMax));
+	const JDGridAxis& thetaAxis = qFactor.GetXaxis();
+	const JDGridAxis& wobbleAxis = qFactor.GetYaxis();
+	vector<JDQFactorKernel::RowSweep> sweeps(numBinsY);		// part of each row already evaluated (from theta=0)
+	JDEvalContext context;
+
+	std::function<Double_t(Int_t,Int_t)> q = [&](Int_t i, Int_t j)
+	{
+		JDQFactorKernel::RowSweep& sweep = sweeps[j];
+		if(i>=sweep.iNumBins)
+		{
+			iNumQFactorEvaluations+=i+1-sweep.iNumBins;
+			qFactorKernel->ContinueRow(effects,wobbleAxis.GetBinCenter(j),thetaAxis,i+1,qFactor.GetRow(j),sweep,context);
+		}
+		return qFactor.GetBinContent(i,j);
+	};
+
+	Int_t thetaBin=0;
+	Int_t wobbleBin=0;
+	Double_t qfactorMax = FindMaximumByRefinement(q,numBinsX,numBinsY,blockSize,safety,thetaBin,wobbleBin);
+	thetaOpt=thetaAxis.GetBinLowEdge(thetaBin);
+	wobbleOpt=wobbleAxis.GetBinLowEdge(wobbleBin);
+
+	Double_t level = (1-tolerance)*qfactorMax;
+	std::function<Double_t(Int_t)> alongTheta = [&](Int_t i) {return q(i,wobbleBin);};
+	std::function<Double_t(Int_t)> alongWobble = [&](Int_t j) {return q(thetaBin,j);};
+
+	Int_t bin;
+	bin=FindLevelEdgeByRefinement(alongTheta,numBinsX,level,blockSize,safety,1);
+	thetaOptRangMin=thetaAxis.GetBinLowEdge(bin>=0? bin : 0);
+	bin=FindLevelEdgeByRefinement(alongTheta,numBinsX,level,blockSize,safety,0);
+	thetaOptRangMax=thetaAxis.GetBinLowEdge(bin>=0? bin : numBinsX);
+	bin=FindLevelEdgeByRefinement(alongWobble,numBinsY,level,blockSize,safety,1);
+	wobbleOptRangMin=wobbleAxis.GetBinLowEdge(bin>=0? bin : 0);
+	bin=FindLevelEdgeByRefinement(alongWobble,numBinsY,level,blockSize,safety,0);
+	wobbleOptRangMax=wobbleAxis.GetBinLowEdge(bin>=0? bin : numBinsY);
+
+	return qfactorMax;
 }
 
-//----------------------------------------------------
-//	dN/dOmega * Epsilon * theta
-// x[0] = theta [deg]
-// x[1] = phi 	[rad]
-// par[0] = wobble distance
-// dccR [deg] 			distance to fov center
-Double_t JDOptimization::dNdOmegaSigma1EpsilonThetaVsThetaPhi(Double_t* x, Double_t* par)
-{
-	fdNdOmegaSigma1EpsilonVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1EpsilonVsThetaPhi->Eval(x[0],x[1])*x[0];
+//-----------------------------------------------
+//	Optimal theta and wobble [deg] without grid: for each wobble the QFactor is maximized in theta (Brent),
+//	and this maximum is maximized in wobble (Brent). The ranges where the QFactor is above (1-tolerance) of
+//	the maximum are found by bisection along theta and wobble through the optimum.
+//	Only QFactor evaluations of JDQFactorKernel are used (see GetNumQFactorEvaluations()).
+Double_t JDOptimization::GetOptimalThetaAndWobbleFromBrent(Double_t &thetaOpt, Double_t &thetaOptRangMin, Double_t &thetaOptRangMax, Double_t &wobbleOpt, Double_t &wobbleOptRangMin, Double_t &wobbleOptRangMax, Int_t type, Double_t tolerance)
+{
+	std::lock_guard<std::mutex> lock(mGridMutex);
+
+	Int_t effects = JDQFactorKernel::GetEffects(type);
+	if(effects<0) return 0.;
+	InitQFactorKernel(effects);
+
+	const Int_t numScanPoints = 8;						// coarse scan done by the minimizer to bracket the maximum
+	const Int_t maxIterations = 100;
+	Double_t precision = GetBinResolution()/100.;		// [deg]
+	Double_t thetaMin = GetBinResolution()/10.;			// [deg]
+	Double_t thetaMax = GetThetaMax();					// [deg]
+	Double_t wobbleMax = GetDistCameraCenterMax();		// [deg]
+
+	auto qFactorVsTheta = [&](Double_t theta, Double_t wobble)
+	{
+		iNumQFactorEvaluations++;
+		return qFactorKernel->Evaluate(effects,theta,wobble);
+	};
+
+	// It maximizes the QFactor in theta at fixed wobble
+	auto maximizeTheta = [&](Double_t wobble, Double_t& theta)
+	{
+		ROOT::Math::Functor1D minusQFactor([&](Double_t x) {return -qFactorVsTheta(x,wobble);});
+		ROOT::Math::BrentMinimizer1D minimizer;
+		minimizer.SetNpx(numScanPoints);
+		minimizer.SetFunction(minusQFactor,thetaMin,thetaMax);
+		minimizer.Minimize(maxIterations,precision,0.);
+		theta = minimizer.XMinimum();
+		return -minimizer.FValMinimum();
+	};
+
+	Double_t theta;
+	ROOT::Math::Functor1D minusQFactorMax([&](Double_t x) {return -maximizeTheta(x,theta);});
+	ROOT::Math::BrentMinimizer1D minimizer;
+	minimizer.SetNpx(numScanPoints);
+	minimizer.SetFunction(minusQFactorMax,0.,wobbleMax);
+	minimizer.Minimize(maxIterations,precision,0.);
+
+	wobbleOpt = minimizer.XMinimum();
+	Double_t qfactorMax = maximizeTheta(wobbleOpt,thetaOpt);
+
+	Double_t level = (1-tolerance)*qfactorMax;
+	std::function<Double_t(Double_t)> alongTheta = [&](Double_t x) {return qFactorVsTheta(x,wobbleOpt);};
+	std::function<Double_t(Double_t)> alongWobble = [&](Double_t x) {return qFactorVsTheta(thetaOpt,x);};
+	thetaOptRangMin = FindLevelCrossing(alongTheta,level,thetaOpt,thetaMin,precision);
+	thetaOptRangMax = FindLevelCrossing(alongTheta,level,thetaOpt,thetaMax,precision);
+	wobbleOptRangMin = FindLevelCrossing(alongWobble,level,wobbleOpt,0.,precision);
+	wobbleOptRangMax = FindLevelCrossing(alongWobble,level,wobbleOpt,wobbleMax,precision);
+
+	return qfactorMax;
 }
 
-//----------------------------------------------------
-//	dN/dOmega_off * Epsilon * theta
-// x[0] = theta [deg]
-// x[1] = phi 	[rad]
-// par[0] = wobble distance
-// dccR [deg] 			distance to fov center
-Double_t JDOptimization::dNdOmegaSigma1OffEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	Exponentially scaled modified Bessel function exp(-x)*I0(x), x>=0
+//	Polynomial approximations from Abramowitz & Stegun 9.8.1 and 9.8.2
+static Double_t BesselI0Scaled(Double_t x)
 {
-	fdNdOmegaSigma1OffEpsilonVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1OffEpsilonVsThetaPhi->Eval(x[0],x[1])*x[0];
+	if(x<=3.75)
+	{
+		Double_t t=(x/3.75)*(x/3.75);
+		return TMath::Exp(-x)*(1.+t*(3.5156229+t*(3.0899424+t*(1.2067492+t*(0.2659732+t*(0.0360768+t*0.0045813))))));
+	}
+
+	Double_t t=3.75/x;
+	return (0.39894228+t*(0.01328592+t*(0.00225319+t*(-0.00157565+t*(0.00916281+t*(-0.02057706+t*(0.02635537+t*(-0.01647633+t*0.00392377))))))))/TMath::Sqrt(x);
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSigma1SmearedThetaVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It forgets the smeared profiles (and the grid computed from them), so they are computed again when needed
+//	It must not be called while QFactors are being evaluated
+//	mGridMutex is locked before mSmearingMutex, the same order as InitQFactorKernel()
+void JDOptimization::ResetSmearing()
 {
-	return fdNdOmegaSigma1SmearedVsTheta->Eval(x[0])*x[0];
+	std::lock_guard<std::mutex> gridLock(mGridMutex);
+	std::lock_guard<std::mutex> lock(mSmearingMutex);
+	ClearSmearing();
 }
 
-//----------------------------------------------------
-//
-Double_t JDOptimization::dNdOmegaSigma1SmearedOffThetaVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It chooses the adaptive smearing (see SmeardNdOmegaAdaptive()) or the uniform one (see SmeardNdOmegaUniform()).
+//	The smeared profiles are computed again (see ResetSmearing()).
+void JDOptimization::SetIsSmearingAdaptive(Bool_t isSmearingAdaptive)
 {
-	fdNdOmegaSigma1SmearedOffVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaSigma1SmearedOffVsThetaPhi->Eval(x[0],x[1])*x[0];
+	std::lock_guard<std::mutex> gridLock(mGridMutex);
+	std::lock_guard<std::mutex> lock(mSmearingMutex);
+	bIsSmearingAdaptive=isSmearingAdaptive;
+	ClearSmearing();
 }
 
-//----------------------------------------------------
-//	dN/dOmegaOff * Epsilon
-// x[0] = theta [deg]
-// x[1] = phi 	[rad]
-//  par[0] = wobble [deg]
-//
-// dccR [deg] 			distance to fov center
-Double_t JDOptimization::dNdOmegaOffEpsilonVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	It sets the step [deg] of the adaptive smearing at the centre of the profile (see SmeardNdOmegaAdaptive()).
+//	The smeared profiles are computed again (see ResetSmearing()).
+void JDOptimization::SetSmearingCoreResolution(Double_t smearingCoreResolution)
 {
-	Double_t dccR = TMath::Sqrt(TMath::Power(par[0],2)+TMath::Power(x[0],2)-2*par[0]*x[0]*TMath::Cos(x[1]+(TMath::Pi()/2)));
-	jdDarkMatter->fdNdOmegaOffVsThetaPhi->SetParameter(0,2*par[0]);
-	return jdDarkMatter->fdNdOmegaOffVsThetaPhi->Eval(x[0],x[1])*jdInstrument->fEpsilonVsDcc->Eval(dccR);
+	std::lock_guard<std::mutex> gridLock(mGridMutex);
+	std::lock_guard<std::mutex> lock(mSmearingMutex);
+	dSmearingCoreResolution=smearingCoreResolution;
+	ClearSmearing();
 }
 
-//----------------------------------------------------
-//	dN/dOmegaOffTheta * Epsilon
-// x[0] = theta [deg]
-// x[1] = phi 	[rad]
-//  par[0] = wobble [deg]
-//
-// dccR [deg] 			distance to fov center
-Double_t JDOptimization::dNdOmegaOffEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par)
+//-----------------------------------------------
+//	ResetSmearing() with mGridMutex and mSmearingMutex locked
+void JDOptimization::ClearSmearing()
 {
-	fdNdOmegaOffEpsilonVsThetaPhi->SetParameter(0,par[0]);
-	return fdNdOmegaOffEpsilonVsThetaPhi->Eval(x[0],x[1])*x[0];
+	if(gdNdOmegaSmeared) delete gdNdOmegaSmeared;
+	if(gdNdOmegaSigma1Smeared) delete gdNdOmegaSigma1Smeared;
+	gdNdOmegaSmeared=NULL;
+	gdNdOmegaSigma1Smeared=NULL;
+	SetIsdNdOmegaSmeared(0);
+	SetIsdNdOmegaSigma1Smeared(0);
+	ClearGridsQFactorVsThetaWobble();
+
+	// the kernel keeps a copy of the smeared profiles
+	if(qFactorKernel) delete qFactorKernel;
+	qFactorKernel=NULL;
 }
 
-void JDOptimization::SetdNdOmegaSmeared()
+//-----------------------------------------------
+//	It smears dN/dOmega with a gaussian PSF of width psfSigma [deg] on a log-radial grid.
+//	Both the profile and the PSF are radially symmetric, so the 2D convolution reduces to one radial integral:
+//		dNdOmegaSmeared(r) = 1/sigma^2 int rho drho dNdOmega(rho) exp(-(r-rho)^2/(2 sigma^2)) I0e(r rho/sigma^2)
+//	whose kernel integrates to 1 over rho in [0,inf). The nodes are dSmearingCoreResolution apart at the centre; from
+//	there the step is a fixed fraction of the radius (geometric nodes) up to psfSigma/4. The integral is done with the
+//	integrand but rho linear between nodes, over the nodes within 6 psfSigma of r: they go on beyond thetaMax, so the
+//	edge of the profile is smeared with the profile outside it, as in SmeardNdOmegaUniform().
+//	Against the analytic smearing of a gaussian core with the default core resolution (0.01 deg) and a 0.155 deg PSF,
+//	the deviation is about 2% of the peak for a 0.02 deg core, 0.4% for 0.05 deg and 0.1% for 0.1 deg or more; it
+//	falls as the square of the core resolution (0.5% for the 0.02 deg core with 0.005 deg). Near thetaMax it is below
+//	0.02% of the smeared value.
+//	It returns the smeared dN/dOmega vs theta [deg] at the nodes up to thetaMax. If psfSigma<=0 the profile is just
+//	sampled (no smearing).
+TGraph* JDOptimization::SmeardNdOmegaAdaptive(TF1* dNdOmega, Double_t psfSigma)
 {
 	Double_t thetaMax=GetThetaMax();
-	Double_t resolution = GetBinResolution();			//[deg/bin]
-	Int_t iNumBins=thetaMax/resolution;
-	Int_t numBins=iNumBins+1;
-
-//	TF1* pointSpreadFunction = new TF1("pointSpreadFunction","1/([1]*TMath::Sqrt(2*TMath::Pi()))*exp(-0.5*((x-[0])/[1])^2)",0,thetaMax);
-	TF2* pointSpreadFunction = new TF2("pointSpreadFunction","1/([1]*[1]*2*TMath::Pi())*exp(-0.5*(((x-[0])^2+(y-[0])^2)/[1]^2))",-thetaMax,thetaMax,-thetaMax,thetaMax);
-	TString instrument = jdInstrument->GetInstrumentName();
-
-	if(instrument=="MAGICPointLike")
+	Double_t stepMin=GetSmearingCoreResolution();								// [deg]
+	Double_t stepMax=(psfSigma>0.? TMath::Max(psfSigma/4.,stepMin) : GetBinResolution());	// [deg]
+	const Double_t stepGrowth=0.05;		// step / radius of the geometric nodes
+	const Double_t kernelRange=6.;		// [psfSigma]
+
+	vector<Double_t> rho;
+	for(Double_t r=0.; r<thetaMax; r+=TMath::Min(TMath::Max(stepMin,stepGrowth*r),stepMax)) rho.push_back(r);
+	rho.push_back(thetaMax);
+	Int_t numNodesOut=rho.size();
+
+	TGraph* dNdOmegaSmeared = new TGraph();
+	if(psfSigma<=0.)
 	{
-		pointSpreadFunction->SetParameter(0,0);
-		pointSpreadFunction->SetParameter(1,0.155); // 68% containment at 0.155º for 100 GeV - see Arxiv1409.5594
+		for(Int_t k=0; k<numNodesOut; k++) dNdOmegaSmeared->SetPoint(k,rho[k],dNdOmega->Eval(rho[k]));
+		return dNdOmegaSmeared;
 	}
-	else if(instrument=="CTANorth50To80GeV")
+
+	Double_t rhoMax=thetaMax+kernelRange*psfSigma;
+	for(Double_t r=thetaMax+stepMax; r<rhoMax; r+=stepMax) rho.push_back(r);
+	rho.push_back(rhoMax);
+	Int_t numNodes=rho.size();
+
+	// weights of rho·g(rho) with g linear between nodes, and profile at the nodes
+	vector<Double_t> weight(numNodes,0.);
+	vector<Double_t> profile(numNodes);
+	for(Int_t k=0; k<numNodes-1; k++)
 	{
-		pointSpreadFunction->SetParameter(0,0);
-		pointSpreadFunction->SetParameter(1,0.11);  // 68% containment at 0.11º for 100 GeV - see Arxiv1705.01790
+		Double_t step=rho[k+1]-rho[k];
+		weight[k]+=step*(2*rho[k]+rho[k+1])/6.;
+		weight[k+1]+=step*(rho[k]+2*rho[k+1])/6.;
 	}
-	else
+	for(Int_t k=0; k<numNodes; k++) profile[k]=dNdOmega->Eval(rho[k]);
+
+	Double_t sigma2=psfSigma*psfSigma;
+	Int_t kMin=0;
+	Int_t kMax=0;
+	for(Int_t i=0; i<numNodesOut; i++)
 	{
-		GetWarning();
+		Double_t r=rho[i];
+		while(rho[kMin]<r-kernelRange*psfSigma) kMin++;
+		while(kMax<numNodes-1 && rho[kMax+1]<=r+kernelRange*psfSigma) kMax++;
+
+		Double_t sum=0.;
+		for(Int_t k=kMin; k<=kMax; k++)
+		{
+			Double_t distance=r-rho[k];
+			sum+=weight[k]*TMath::Exp(-0.5*distance*distance/sigma2)*BesselI0Scaled(r*rho[k]/sigma2)*profile[k];
+		}
+		dNdOmegaSmeared->SetPoint(i,r,sum/sigma2);
 	}
+	return dNdOmegaSmeared;
+}
 
-	TH2D* smearingdNdOmegaBefore = new TH2D("smearingdNdOmegaBefore","",numBins,-thetaMax,thetaMax,numBins,-thetaMax,thetaMax);
-	TH2D* smearingdNdOmegaAfter = new TH2D("smearingdNdOmegaAfter","",numBins,-thetaMax,thetaMax,numBins,-thetaMax,thetaMax);
-	TH2D* smearingGauss = new TH2D("smearingGauss","",numBins,-thetaMax,thetaMax,numBins,-thetaMax,thetaMax);
+//-----------------------------------------------
+//	It smears dN/dOmega with a gaussian PSF of width psfSigma [deg].
+//	The profile and the PSF are sampled on a square grid of (2·thetaMax/resolution+1)^2 bins centred at the source
+//	and convolved. It returns the smeared dN/dOmega vs theta [deg].
+//	If psfSigma<=0 the profile is just sampled (no smearing).
+TGraph* JDOptimization::SmeardNdOmegaUniform(TF1* dNdOmega, Double_t psfSigma)
+{
+	Double_t thetaMax=GetThetaMax();
+	Double_t resolution = GetBinResolution();			//[deg/bin]
+	Int_t iNumBins=thetaMax/resolution;
+	Int_t numBins=iNumBins+1;
+	Int_t iCenter=iNumBins/2;
+
+	JDGridAxis axis(numBins,-thetaMax,thetaMax);
+	JDGrid2D smearingGauss(axis,axis);
+	JDGrid2D smearingdNdOmegaBefore(axis,axis);
+	JDGrid2D smearingdNdOmegaAfter(axis,axis);
 
 	Double_t gaussVolume=0;
-	for(Int_t i=1; i<numBins+1; i++)
+	for(Int_t j=0; j<numBins; j++)
 	{
-		Double_t distSourceCenterX = smearingGauss->ProjectionX()->GetBinCenter(i);
-		for(Int_t j=1; j<numBins+1; j++)
+		Double_t distSourceCenterY = axis.GetBinCenter(j);
+		for(Int_t i=0; i<numBins; i++)
 		{
-			Double_t distSourceCenterY = smearingGauss->ProjectionX()->GetBinCenter(j);
+			Double_t distSourceCenterX = axis.GetBinCenter(i);
 			Double_t distanceSourceCenter = TMath::Sqrt(distSourceCenterX*distSourceCenterX + distSourceCenterY*distSourceCenterY);
-			smearingGauss->SetBinContent(i,j,pointSpreadFunction->Eval(distSourceCenterX,distSourceCenterY));
-			smearingdNdOmegaBefore->SetBinContent(i,j,jdDarkMatter->fdNdOmegaVsTheta->Eval(distanceSourceCenter));
-			smearingdNdOmegaAfter->SetBinContent(i,j,0.);
-			gaussVolume=gaussVolume+smearingGauss->GetBinContent(i,j);
+			Double_t gauss;
+			if(psfSigma>0.)	gauss = TMath::Exp(-0.5*(distanceSourceCenter*distanceSourceCenter)/(psfSigma*psfSigma));
+			else			gauss = (i==iCenter && j==iCenter? 1. : 0.);
+
+			smearingGauss.SetBinContent(i,j,gauss);
+			smearingdNdOmegaBefore.SetBinContent(i,j,dNdOmega->Eval(distanceSourceCenter));
+			gaussVolume=gaussVolume+gauss;
 		}
 	}
-	smearingGauss->Scale(1/gaussVolume);
+	smearingGauss.Scale(1/gaussVolume);
 
-	for(Int_t binCenterX=1; binCenterX<numBins+1; binCenterX++)
+	// Each bin of the profile (binCenter) is spread over the bins binSmear with weight Gauss(iCenter+binCenter-binSmear)
+	const Double_t* gauss = smearingGauss.GetArray();
+	const Double_t* before = smearingdNdOmegaBefore.GetArray();
+	Double_t* after = smearingdNdOmegaAfter.GetArray();
+	for(Int_t binCenterY=0; binCenterY<numBins; binCenterY++)
 	{
-		for(Int_t binCenterY=1; binCenterY<numBins+1; binCenterY++)
+		for(Int_t binCenterX=0; binCenterX<numBins; binCenterX++)
 		{
-			for(Int_t binSmearX=1; binSmearX<numBins+1; binSmearX++)
+			Double_t valueBefore = before[binCenterX+numBins*binCenterY];
+			if(valueBefore==0.) continue;
+
+			Int_t binSmearXMin = TMath::Max(0,binCenterX+iCenter-(numBins-1));
+			Int_t binSmearXMax = TMath::Min(numBins-1,binCenterX+iCenter);
+			for(Int_t binSmearY=0; binSmearY<numBins; binSmearY++)
 			{
-				Int_t binDeltaX = binCenterX - binSmearX;
-				for(Int_t binSmearY=1; binSmearY<numBins+1; binSmearY++)
-				{
-					Int_t binDeltaY = binCenterY - binSmearY;
+				Int_t binDeltaY = iCenter+binCenterY-binSmearY;
+				if(binDeltaY<0 || binDeltaY>=numBins) continue;
 
-					smearingdNdOmegaAfter->SetBinContent(binSmearX,binSmearY,
-							smearingdNdOmegaAfter->GetBinContent(binSmearX,binSmearY)+
-							smearingdNdOmegaBefore->GetBinContent(binCenterX,binCenterY)*
-							smearingGauss->GetBinContent(iNumBins/2+1+binDeltaX,iNumBins/2+1+binDeltaY));
+				const Double_t* gaussRow = gauss+numBins*binDeltaY+iCenter+binCenterX;
+				Double_t* afterRow = after+numBins*binSmearY;
+				for(Int_t binSmearX=binSmearXMin; binSmearX<=binSmearXMax; binSmearX++)
+				{
+					afterRow[binSmearX]+=valueBefore*gaussRow[-binSmearX];
 				}
 			}
 		}
 	}
 
-	gdNdOmegaSmeared = new TGraph();
-	for(Int_t binCenterX=0; binCenterX<iNumBins/2+1; binCenterX++)
+	TGraph* dNdOmegaSmeared = new TGraph();
+	for(Int_t k=0; iCenter+k<numBins; k++)
 	{
-		Double_t theta = smearingdNdOmegaAfter->ProjectionX()->GetBinCenter(iNumBins/2+1+binCenterX)-
-				smearingGauss->ProjectionX()->GetBinCenter(iNumBins/2+1);
-		Double_t dNdOmegaSmeared = smearingdNdOmegaAfter->GetBinContent(iNumBins/2+1+1+binCenterX,iNumBins/2+1);
-
-		gdNdOmegaSmeared->SetPoint(binCenterX-1,theta,dNdOmegaSmeared);
+		Double_t theta = axis.GetBinCenter(iCenter+k)-axis.GetBinCenter(iCenter);
+		dNdOmegaSmeared->SetPoint(k,theta,smearingdNdOmegaAfter.GetBinContent(iCenter+k,iCenter));
 	}
+	return dNdOmegaSmeared;
+}
 
-	SetIsdNdOmegaSmeared(1);
+//-----------------------------------------------
+//	Thread-safe lazy initialization of the smeared profiles.
+//	The first caller smears while the others wait on the mutex; once the flag is set (release) the profile
+//	is read without locking (acquire).
+void JDOptimization::InitdNdOmegaSmeared()
+{
+	if(bIsdNdOmegaSmeared.load(std::memory_order_acquire)) return;
+
+	std::lock_guard<std::mutex> lock(mSmearingMutex);
+	if(!bIsdNdOmegaSmeared.load(std::memory_order_relaxed)) SetdNdOmegaSmeared();
 }
 
-void JDOptimization::SetdNdOmegaSigma1Smeared()
+//-----------------------------------------------
+//	Same as InitdNdOmegaSmeared() for dN/dOmega_Sigma1
+void JDOptimization::InitdNdOmegaSigma1Smeared()
 {
-	Double_t thetaMax=GetThetaMax();
-	Double_t resolution = GetBinResolution();			//[deg/bin]
-	Int_t iNumBins=thetaMax/resolution;
-	Int_t numBins=iNumBins+1;
+	if(bIsdNdOmegaSigma1Smeared.load(std::memory_order_acquire)) return;
 
-	TF1* pointSpreadFunction = new TF1("pointSpreadFunction","1/([1]*TMath::Sqrt(2*TMath::Pi()))*exp(-0.5*((x-[0])/[1])^2)",0,thetaMax);
+	std::lock_guard<std::mutex> lock(mSmearingMutex);
+	if(!bIsdNdOmegaSigma1Smeared.load(std::memory_order_relaxed)) SetdNdOmegaSigma1Smeared();
+}
+
+//-----------------------------------------------
+//	It smears dN/dOmega with the PSF of the instrument
+//	Use InitdNdOmegaSmeared() to call it only once
+void JDOptimization::SetdNdOmegaSmeared()
+{
+	Double_t psfSigma = 0.;
 	TString instrument = jdInstrument->GetInstrumentName();
+
 	if(instrument=="MAGICPointLike")
 	{
-		pointSpreadFunction->SetParameter(0,0);
-		pointSpreadFunction->SetParameter(1,0.1);
+		psfSigma = 0.155; // 68% containment at 0.155º for 100 GeV - see Arxiv1409.5594
+	}
+	else if(instrument=="CTANorth50To80GeV")
+	{
+		psfSigma = 0.11;  // 68% containment at 0.11º for 100 GeV - see Arxiv1705.01790
 	}
 	else
 	{
 		GetWarning();
 	}
 
+	gdNdOmegaSmeared = (GetIsSmearingAdaptive()?
+			SmeardNdOmegaAdaptive(jdDarkMatter->GetTF1dNdOmegaVsTheta(),psfSigma) :
+			SmeardNdOmegaUniform(jdDarkMatter->GetTF1dNdOmegaVsTheta(),psfSigma));
 
-	TH2D* smearingdNdOmegaSigma1Before = new TH2D("smearingdNdOmegaSigma1Before","",numBins,-thetaMax,thetaMax,numBins,-thetaMax,thetaMax);
-	TH2D* smearingdNdOmegaSigma1After = new TH2D("smearingdNdOmegaSigma1After","",numBins,-thetaMax,thetaMax,numBins,-thetaMax,thetaMax);
-	TH2D* smearingGauss = new TH2D("smearingGauss","",numBins,-thetaMax,thetaMax,numBins,-thetaMax,thetaMax);
+	SetIsdNdOmegaSmeared(1);
+}
 
-	Double_t gaussVolume=0;
-	for(Int_t i=1; i<numBins+1; i++)
-	{
-		Double_t distSourceCenterX = smearingGauss->ProjectionX()->GetBinCenter(i);
-		for(Int_t j=1; j<numBins+1; j++)
-		{
-			Double_t distSourceCenterY = smearingGauss->ProjectionX()->GetBinCenter(j);
-			Double_t distanceSourceCenter = TMath::Sqrt(distSourceCenterX*distSourceCenterX + distSourceCenterY*distSourceCenterY);
-			smearingGauss->SetBinContent(i,j,pointSpreadFunction->Eval(distanceSourceCenter));
-			smearingdNdOmegaSigma1Before->SetBinContent(i,j,jdDarkMatter->fdNdOmegaSigma1VsTheta->Eval(distanceSourceCenter));
-			smearingdNdOmegaSigma1After->SetBinContent(i,j,0.);
-			gaussVolume=gaussVolume+smearingGauss->GetBinContent(i,j);
-		}
-	}
-	smearingGauss->Scale(1/gaussVolume);
+//-----------------------------------------------
+//	It smears dN/dOmega_Sigma1 with the PSF of the instrument
+//	Use InitdNdOmegaSigma1Smeared() to call it only once
+void JDOptimization::SetdNdOmegaSigma1Smeared()
+{
+	Double_t psfSigma = 0.;
+	TString instrument = jdInstrument->GetInstrumentName();
 
-	for(Int_t binCenterX=1; binCenterX<numBins+1; binCenterX++)
+	if(instrument=="MAGICPointLike")
 	{
-		for(Int_t binCenterY=1; binCenterY<numBins+1; binCenterY++)
-		{
-			for(Int_t binSmearX=1; binSmearX<numBins+1; binSmearX++)
-			{
-				Int_t binDeltaX = binCenterX - binSmearX;
-				for(Int_t binSmearY=1; binSmearY<numBins+1; binSmearY++)
-				{
-					Int_t binDeltaY = binCenterY - binSmearY;
-
-					smearingdNdOmegaSigma1After->SetBinContent(binSmearX,binSmearY,
-							smearingdNdOmegaSigma1After->GetBinContent(binSmearX,binSmearY)+
-							smearingdNdOmegaSigma1Before->GetBinContent(binCenterX,binCenterY)*
-							smearingGauss->GetBinContent(iNumBins/2+1+binDeltaX,iNumBins/2+1+binDeltaY));
-				}
-			}
-		}
+		psfSigma = 0.1;
 	}
-
-	gdNdOmegaSigma1Smeared = new TGraph();
-	for(Int_t binCenterX=0; binCenterX<iNumBins/2+1; binCenterX++)
+	else
 	{
-		Double_t theta = smearingdNdOmegaSigma1After->ProjectionX()->GetBinCenter(iNumBins/2+1+binCenterX)-
-				smearingGauss->ProjectionX()->GetBinCenter(iNumBins/2+1);
-		Double_t dNdOmegaSigma1Smeared = smearingdNdOmegaSigma1After->GetBinContent(iNumBins/2+1+1+binCenterX,iNumBins/2+1);
-
-		gdNdOmegaSigma1Smeared->SetPoint(binCenterX-1,theta,dNdOmegaSigma1Smeared);
+		GetWarning();
 	}
 
+	gdNdOmegaSigma1Smeared = (GetIsSmearingAdaptive()?
+			SmeardNdOmegaAdaptive(jdDarkMatter->GetTF1dNdOmegaSigma1VsTheta(),psfSigma) :
+			SmeardNdOmegaUniform(jdDarkMatter->GetTF1dNdOmegaSigma1VsTheta(),psfSigma));
+
 	SetIsdNdOmegaSigma1Smeared(1);
 }
 
@@ -25,6 +25,15 @@
 
 #include "JDInstrument.h"
 #include "JDDarkMatter.h"
+#include "JDBackgroundGeometry.h"
+#include "JDGrid.h"
+#include "JDQFactorKernel.h"
+#include "JDSurfaceStore.h"
+#include "JDTaskScheduler.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
 
 
 	//	IDEAL: 									Q0 = J_on/theta
@@ -38,8 +47,12 @@
 
 class JDOptimization {
 public:
+	// How GetOptimalThetaAndWobble() searches the maximum
+	enum OptimizationMode {kGridScan=0, kBrentScan=1, kRefinedScan=2};
+
 	JDOptimization(TString txtFile, TString myInstrumentPath, TString instrumentName, Double_t distCameraCenter, Double_t wobble);
 	JDOptimization(TString author, TString source, TString candidate, TString mySourcePath, TString myInstrumentPath, TString instrumentName, Double_t distCameraCenter, Double_t wobble);
+	JDOptimization(JDDarkMatter* darkMatter, JDInstrument* instrument);
 	virtual ~JDOptimization();
 
 
@@ -48,324 +61,92 @@ public:
 
 	Double_t GetBinResolution()					{return dBinResolution;}
 
-	TF1* GetTF1QFactorVsTheta(Int_t type=0, Double_t thetaNorm=0.4)
-	{
-		if(type==0)
-		{
-			fQ0FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ0FactorVsTheta;
-		}
-		else if(type==1)
-		{
-			fQ1FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ1FactorVsTheta;
-		}
-
-		else if(type==2)
-		{
-			fQ2FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ2FactorVsTheta;
-		}
-
-		else if (type==3)
-		{
-			fQ3FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ3FactorVsTheta;
-		}
-
-		else if (type==12 || type==21)
-		{
-			fQ12FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ12FactorVsTheta;
-		}
-
-		else if (type==13 || type==31)
-		{
-			fQ13FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ13FactorVsTheta;
-		}
-
-		else if (type==23 || type==32)
-		{
-			fQ23FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ23FactorVsTheta;
-		}
-
-		else if (type==123 || type==132 || type==213 || type==231 || type==312 || type==321)
-		{
-			fQ123FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ123FactorVsTheta;
-		}
-
-		else if (type==124 || type==142 || type==214 || type==241 || type==412 || type==421)
-		{
-			fQ124FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ124FactorVsTheta;
-		}
-
-		else if (type==134 || type==143 || type==314 || type==341 || type==413 || type==431)
-		{
-			fQ134FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ134FactorVsTheta;
-		}
-
-		else if (type==234 || type==243 || type==324 || type==342 || type==423 || type==432)
-		{
-			fQ134FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ134FactorVsTheta;
-		}
-
-		else if (type==1234 || type==1243 || type==1324 || type==1342 || type==1423 || type==1432 ||
-				 type==2341 || type==2342 || type==2423 || type==2432 || type==2143 || type==2143 ||
-				 type==3412 || type==3421 || type==3124 || type==3142 || type==3241 || type==3214 ||
-				 type==4123 || type==4132 || type==4231 || type==4213 || type==4321 || type==4312 )
-
-		{
-			fQ134FactorVsTheta->SetParameter(0, thetaNorm);
-			return fQ134FactorVsTheta;
-		}
-
-		else
-		{
-			TF1* f1;
-			cout << endl;
-			cout << "   ***************************************************************" << endl;
-			cout << "   ***   WARNING: wrong Qfactor type!!!                        ***" << endl;
-			cout << "   ***************************************************************" << endl;
-			cout << endl;
-			GetListOfQFactors();
-			return f1;
-		}
-	}
+	// Smearing: adaptive (log-radial, default) or uniform grid of dBinResolution
+	void SetIsSmearingAdaptive(Bool_t isSmearingAdaptive);
+	void SetSmearingCoreResolution(Double_t smearingCoreResolution);
+	Bool_t GetIsSmearingAdaptive()				{return bIsSmearingAdaptive;}
+	Double_t GetSmearingCoreResolution()		{return dSmearingCoreResolution;}
+
+	// Threads used to fill the QFactor grids (0: one per hardware thread), scheduled with work stealing (see JDTaskScheduler)
+	void SetNumThreads(Int_t numThreads);
+	Int_t GetNumThreads()						{return (taskScheduler? taskScheduler->GetNumThreads() : iNumThreads);}
+	void PrintThreadUtilization();
+
+	// QFactor kernels specialized at compile time for each type (default) or the generic one (see JDQFactorKernel)
+	void SetIsQFactorKernelSpecialized(Bool_t isQFactorKernelSpecialized);
+	Bool_t GetIsQFactorKernelSpecialized()		{return bIsQFactorKernelSpecialized;}
+	// Sums of the QFactor integrals: compensated (JDReduction::kDeterministic, default) or plain (kFast, see JDReduction)
+	void SetReductionMode(Int_t reductionMode);
+	Int_t GetReductionMode()					{return iReductionMode;}
+
+	// Wobble pointings and OFF regions of the leakage (see JDBackgroundGeometry; one OFF region at 2·wobble by default)
+	void SetBackgroundGeometry(const JDBackgroundGeometry& geometry);
+	const JDBackgroundGeometry& GetBackgroundGeometry()	{return backgroundGeometry;}
+
+	// It samples the QFactor kernel of this type, so that its grid and optimal point can be computed in another thread
+	Bool_t PrepareQFactorKernel(Int_t type=0);
+	// The kernel, after PrepareQFactorKernel() of the types needed (see JDToyMC)
+	const JDQFactorKernel* GetQFactorKernel()	{return qFactorKernel;}
+
+	// Local store of QFactor surfaces, sampled tables and optimal points, looked up before computing them (empty path: no store)
+	void SetSurfaceStore(TString storePath);
+	JDSurfaceStore* GetSurfaceStore()			{return surfaceStore;}
+	// [s] The grids being filled are saved into the store at this interval, and resumed from there (<=0: never; default 60)
+	void SetCheckpointInterval(Double_t checkpointInterval);
+	Double_t GetCheckpointInterval()			{return dCheckpointInterval;}
+	// Everything the QFactor surface of these effects (see JDQFactorKernel::Effect) depends on: the key of the store
+	TString GetConfiguration(Int_t effects);
+
+	// QFactor vs theta at the nominal wobble distance, normalized at thetaNorm (not normalized if thetaNorm<0)
+	TF1* GetTF1QFactorVsTheta(Int_t type=0, Double_t thetaNorm=0.4);
+
+	// Reentrant evaluation: const, with the wobble and the normalization as arguments and without touching any TF1/TF2
+	// (see also JDAstroProfile and JDInstrument), so many threads can call them at the same time.
+	// The QFactor needs PrepareQFactorKernel() of its type first.
+	Double_t EvaluateQFactor(Int_t type, Double_t theta, Double_t wobble, Double_t thetaNorm=-1.) const;
+	Double_t EvaluatedNdOmegaEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble, Bool_t isSigma1=0) const;
+	Double_t EvaluatedNdOmegaOffEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble, Bool_t isSigma1=0) const;
+	// The same with the scratch buffers and cursors of a JDEvalContext (one per thread): they do not allocate once it has grown
+	Bool_t EvaluateQFactorRow(Int_t type, Double_t wobble, const JDGridAxis& thetaAxis, Double_t* row, JDEvalContext& context) const;
+	Double_t EvaluatedNdOmegaEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble, JDEvalContext& context, Bool_t isSigma1=0) const;
+	Double_t EvaluatedNdOmegaOffEpsilonVsThetaPhi(Double_t theta, Double_t phi, Double_t wobble, JDEvalContext& context, Bool_t isSigma1=0) const;
 
 	///////////////////////////////////////////////////////////////////////////////////////
 	// This function gives a value and a range around this value of the theta optimal and the wobble optimal
-	void GetOptimalThetaAndWobble(Double_t &thetaOpt, Double_t &thetaOptRangMin, Double_t &thetaOptRangMax, Double_t &wobbleOpt, Double_t &wobbleOptRangMin, Double_t &wobbleOptRangMax, Int_t type=0)
-	{
-		TH2D* h2;
-		if(!th2QFactorVsThetaWobble) h2 = th2QFactorVsThetaWobble;
-		else h2 = GetTH2QFactorVsThetaWobble(type);
-
-		Int_t numBinsX = h2->GetNbinsX();
-		Int_t numBinsY = h2->GetNbinsY();
-
-		Double_t qfactorMax=0;
-		Double_t qfactorRange=1;
-		Double_t thetaBin=0;
-		Double_t wobbleBin=0;
-
-		for(Int_t i=1; i<numBinsX+1; i++)
-		{
-			for(Int_t j=0; j<numBinsY; j++)
-				{
-					Double_t qfactor = h2->GetBinContent(i,j);
-					if(qfactor>qfactorMax)
-					{
-						qfactorMax=qfactor;
-						thetaOpt=h2->ProjectionX()->GetBinLowEdge(i);
-						wobbleOpt=h2->ProjectionY()->GetBinLowEdge(j);
-						thetaBin=i;
-						wobbleBin=j;
-					}
-
-				}
-		}
-
-		Double_t tolerance = 0.30; // QUIM: This is hardcoded...
-
-		for(Int_t i=1; i<numBinsX+1; i++)
-		{
-			Double_t qfactorRange = h2->GetBinContent(i,wobbleBin);
-			if(qfactorRange>=(1-tolerance)*qfactorMax)
-			{
-				thetaOptRangMin=h2->ProjectionX()->GetBinLowEdge(i);
-				break;
-			}
-		}
-
-		for(Int_t i=1; i<numBinsX+1; i++)
-		{
-			Double_t qfactorRange = h2->GetBinContent(numBinsX+1-i,wobbleBin);
-			if(qfactorRange>=(1-tolerance)*qfactorMax)
-			{
-				thetaOptRangMax=h2->ProjectionX()->GetBinLowEdge(numBinsX+1-i);
-				break;
-			}
-		}
-
-		for(Int_t j=1; j<numBinsY+1; j++)
-		{
-			Double_t qfactorRange = h2->GetBinContent(thetaBin,j);
-			if(qfactorRange>=(1-tolerance)*qfactorMax)
-			{
-				wobbleOptRangMin=h2->ProjectionY()->GetBinLowEdge(j);
-				break;
-			}
-		}
-
-		for(Int_t j=1; j<numBinsY+1; j++)
-		{
-			Double_t qfactorRange = h2->GetBinContent(thetaBin,numBinsY+1-j);
-			if(qfactorRange>=(1-tolerance)*qfactorMax)
-			{
-				wobbleOptRangMax=h2->ProjectionY()->GetBinLowEdge(numBinsY+1-j);
-				break;
-			}
-		}
-
-		if(qfactorMax>0.)
-		{
-			cout << "   ****************************************" << endl;
-			cout << "   ***                                  ***" << endl;
-			cout << "   ***  Optimal theta and wobble found  ***" << endl;
-			cout << "   ***                                  ***" << endl;
-			cout << "   ****************************************" << endl;
-		}
-		else
-		{
-			cout << "   **************************************************" << endl;
-			cout << "   ***                                            ***" << endl;
-			cout << "   ***  WARNING:                                  ***" << endl;
-			cout << "   ***  problem occurred maximizing the qfactor   ***" << endl;
-			cout << "   ***                                            ***" << endl;
-			cout << "   **************************************************" << endl;
-		}
-
-		return;
-	}
+	// It returns the maximum QFactor (not normalized)
+	Double_t GetOptimalThetaAndWobble(Double_t &thetaOpt, Double_t &thetaOptRangMin, Double_t &thetaOptRangMax, Double_t &wobbleOpt, Double_t &wobbleOptRangMin, Double_t &wobbleOptRangMax, Int_t type=0);
+
+	// The optimal ranges are where the QFactor is above (1-tolerance) of its maximum (0.30 by default)
+	void SetTolerance(Double_t tolerance)				{dTolerance=tolerance;}
+	Double_t GetTolerance()								{return dTolerance;}
+	void SetOptimizationMode(Int_t optimizationMode)	{iOptimizationMode=optimizationMode;}
+	Int_t GetOptimizationMode()							{return iOptimizationMode;}
+	// QFactor evaluations done by the last GetOptimalThetaAndWobble()
+	Int_t GetNumQFactorEvaluations()					{return iNumQFactorEvaluations;}
+	// Not verbose: GetOptimalThetaAndWobble() prints no banner, only one line for a warning (see JDCampaign)
+	void SetIsVerbose(Bool_t isVerbose)					{bIsVerbose=isVerbose;}
+	Bool_t GetIsVerbose()								{return bIsVerbose;}
+	// Optimal point of a grid of QFactor vs theta and wobble (as in kGridScan)
+	static Double_t GetOptimalThetaAndWobble(const JDGrid2D& grid, Double_t tolerance, Double_t &thetaOpt, Double_t &thetaOptRangMin, Double_t &thetaOptRangMax, Double_t &wobbleOpt, Double_t &wobbleOptRangMin, Double_t &wobbleOptRangMax);
 
 	//////////////////////////////////////////////////////////////////////////////////////////////////////
 	// This TH2 is filled with the content of the TF2 corresponding to GetTF2QFactorvsThetaAndWobble
-	TH2D* GetTH2QFactorVsThetaWobble(Int_t type=0, Double_t thetaNorm=-1, Double_t wobbleNorm=-1)
-	{
-		TF2* qFactor=GetTF2QFactorVsThetaWobble(type);
-
-		Double_t resolution = GetBinResolution();			//[deg/bin]
-		Double_t thetaMax = GetThetaMax();					// [deg]
-		Int_t numBinsX = thetaMax/resolution; 				// [#bins]
-		Double_t wobbleMax = GetDistCameraCenterMax();		// [deg]
-		Int_t numBinsY = wobbleMax/resolution; 				// [#bins]
-
-		th2QFactorVsThetaWobble = new TH2D("h2","",numBinsX,0.,thetaMax,numBinsY,0.,wobbleMax);
-		for(Int_t i=1; i<numBinsX+1; i++)
-		{
-			for(Int_t j=1; j<numBinsY+1; j++)
-			{
-				th2QFactorVsThetaWobble->SetBinContent(i,j,qFactor->Eval(th2QFactorVsThetaWobble->ProjectionX()->GetBinCenter(i),th2QFactorVsThetaWobble->ProjectionY()->GetBinCenter(j)));
-			}
-		}
-
-		if(thetaNorm <0. || wobbleNorm<0.)
-		{
-			th2QFactorVsThetaWobble->Scale(1/(th2QFactorVsThetaWobble->GetMaximum()));
-		}
-		else
-		{
-			Int_t iThetaNorm = th2QFactorVsThetaWobble->ProjectionX()->FindBin(thetaNorm);
-			Int_t jWobbleNorm = th2QFactorVsThetaWobble->ProjectionY()->FindBin(wobbleNorm);
-			Double_t normValue = th2QFactorVsThetaWobble->GetBinContent(iThetaNorm,jWobbleNorm);
-			th2QFactorVsThetaWobble->Scale(1/(normValue));
-		}
-		return th2QFactorVsThetaWobble;
-	}
-
-	TF2* GetTF2QFactorVsThetaWobble(Int_t type=0)
-	{
-		if(type==0)
-		{
-			return fQ0FactorVsThetaWobble;
-		}
-		else if(type==1)
-		{
-			return fQ1FactorVsThetaWobble;
-		}
-
-		else if(type==2)
-		{
-			return fQ2FactorVsThetaWobble;
-		}
-
-		else if(type==3)
-		{
-			return fQ3FactorVsThetaWobble;
-		}
-
-		else if(type==4)
-		{
-			return fQ4FactorVsThetaWobble;
-		}
-
-		else if(type==12 || type==21)
-		{
-			return fQ12FactorVsThetaWobble;
-		}
-
-		else if(type==13 || type==31)
-		{
-			return fQ13FactorVsThetaWobble;
-		}
-
-		else if (type==14 || type==41)
-		{
-			return fQ14FactorVsThetaWobble;
-		}
-
-		else if(type==23 || type==32)
-		{
-			return fQ23FactorVsThetaWobble;
-		}
-
-		else if(type==24 || type==42)
-		{
-			return fQ24FactorVsThetaWobble;
-		}
-
-		else if(type==34 || type==43)
-		{
-			return fQ34FactorVsThetaWobble;
-		}
-
-		else if (type==123 || type==132 || type==213 || type==231 || type==312 || type==321)
-		{
-			return fQ123FactorVsThetaWobble;
-		}
-
-		else if (type==124 || type==142 || type==214 || type==241 || type==412 || type==421)
-		{
-			return fQ124FactorVsThetaWobble;
-		}
-
-		else if (type==134 || type==143 || type==314 || type==341 || type==413 || type==431)
-		{
-			return fQ134FactorVsThetaWobble;
-		}
-
-		else if (type==234 || type==243 || type==324 || type==342 || type==423 || type==432)
-		{
-			return fQ234FactorVsThetaWobble;
-		}
-
-		else if (type==1234 || type==1243 || type==1324 || type==1342 || type==1423 || type==1432 ||
-				 type==2341 || type==2342 || type==2423 || type==2432 || type==2143 || type==2143 ||
-				 type==3412 || type==3421 || type==3124 || type==3142 || type==3241 || type==3214 ||
-				 type==4123 || type==4132 || type==4231 || type==4213 || type==4321 || type==4312 )
-
-		{
-			return fQ1234FactorVsThetaWobble;
-		}
-
-		else
-		{
-			TF2* f2;
-			cout << endl;
-			cout << "   ***************************************************************" << endl;
-			cout << "   ***   WARNING: wrong Qfactor type!!!                        ***" << endl;
-			cout << "   ***************************************************************" << endl;
-			cout << endl;
-			GetListOfQFactors();
-			return f2;
-		}
-	}
+	// It is only meant for plotting: the computation is done on the JDGrid2D given by GetGridQFactorVsThetaWobble
+	TH2D* GetTH2QFactorVsThetaWobble(Int_t type=0, Double_t thetaNorm=-1, Double_t wobbleNorm=-1);
+
+	// Not normalized QFactor vs theta (x) and wobble (y) at the bin centres. It is cached for every type asked
+	// (see JDQFactorScan to receive its rows as they are computed, and to cancel it)
+	const JDGrid2D* GetGridQFactorVsThetaWobble(Int_t type=0);
+
+	// It fills (and caches) the grids of all these types in one pass, computing the integrals they share only once
+	Bool_t FillGridsQFactorVsThetaWobble(const std::vector<Int_t>& types);
+
+	// Iso-QFactor contours (theta, wobble) [deg] at level x maximum QFactor (e.g. level=1-GetTolerance()), from the cached grid
+	// The caller owns the graphs
+	std::vector<TGraph*> GetContoursQFactorVsThetaWobble(Double_t level, Int_t type=0);
+
+	// Not normalized QFactor vs theta (x) and wobble (y)
+	TF2* GetTF2QFactorVsThetaWobble(Int_t type=0);
 
 	/**************************************************/
 
@@ -410,27 +191,11 @@ public:
 	TF2* GetTF2LOS_m1OffThetaVSThetaPhi()	{return jdDarkMatter->GetTF2LOS_m1OffThetaVSThetaPhi(2*jdInstrument->GetWobbleDistance());}
 
 
-	// QUIM NEW
-	TF2* GetTF2dNdOmegaEpsilonVsThetaPhi()
-	{
-		fdNdOmegaEpsilonVsThetaPhi->SetParameter(0,jdInstrument->GetWobbleDistance());
-		return fdNdOmegaEpsilonVsThetaPhi;
-	}
-	TF2* GetTF2dNdOmegaOffEpsilonVsThetaPhi()
-	{
-		fdNdOmegaOffEpsilonVsThetaPhi->SetParameter(0,jdInstrument->GetWobbleDistance());
-		return fdNdOmegaOffEpsilonVsThetaPhi;
-	}
-	TF2* GetTF2dNdOmegaEpsilonThetaVsThetaPhi()
-	{
-		fdNdOmegaEpsilonThetaVsThetaPhi->SetParameter(0,jdInstrument->GetWobbleDistance());
-		return fdNdOmegaEpsilonThetaVsThetaPhi;
-	}
-	TF2* GetTF2dNdOmegaOffEpsilonThetaVsThetaPhi()
-	{
-		fdNdOmegaOffEpsilonThetaVsThetaPhi->SetParameter(0,jdInstrument->GetWobbleDistance());
-		return fdNdOmegaOffEpsilonThetaVsThetaPhi;
-	}
+	// dN/dOmega·Epsilon (on and OFF) vs theta and phi at the nominal wobble distance, read when they are evaluated
+	TF2* GetTF2dNdOmegaEpsilonVsThetaPhi()			{return fdNdOmegaEpsilonVsThetaPhi;}
+	TF2* GetTF2dNdOmegaOffEpsilonVsThetaPhi()		{return fdNdOmegaOffEpsilonVsThetaPhi;}
+	TF2* GetTF2dNdOmegaEpsilonThetaVsThetaPhi()		{return fdNdOmegaEpsilonThetaVsThetaPhi;}
+	TF2* GetTF2dNdOmegaOffEpsilonThetaVsThetaPhi()	{return fdNdOmegaOffEpsilonThetaVsThetaPhi;}
 
 	//***** JDDarkMatter Setters
 	void SetCandidate(TString candidate)							{jdDarkMatter->SetCandidate(candidate);}
@@ -466,176 +231,93 @@ protected:
 
 	void SetdNdOmegaSmeared();
 	void SetdNdOmegaSigma1Smeared();
-	void SetIsdNdOmegaSmeared(Bool_t isdNdOmegaSmeared)					{bIsdNdOmegaSmeared = isdNdOmegaSmeared;}
-	void SetIsdNdOmegaSigma1Smeared(Bool_t isdNdOmegaSigma1Smeared)		{bIsdNdOmegaSigma1Smeared = isdNdOmegaSigma1Smeared;}
-
-
-	Double_t Q0FactorVsTheta(Double_t* x, Double_t* par);
-	Double_t Q1FactorVsTheta(Double_t* x, Double_t* par);
-	Double_t Q2FactorVsTheta(Double_t* x, Double_t* par);
-	Double_t Q3FactorVsTheta(Double_t* x, Double_t* par);
-
-	Double_t Q12FactorVsTheta(Double_t* x, Double_t* par);
-	Double_t Q13FactorVsTheta(Double_t* x, Double_t* par);
-	Double_t Q23FactorVsTheta(Double_t* x, Double_t* par);
-	Double_t Q123FactorVsTheta(Double_t* x, Double_t* par);
-
-	Double_t Q0FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q1FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q2FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q3FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q4FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q12FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q13FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q14FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q23FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q24FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q34FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q123FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q124FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q134FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q234FactorVsThetaWobble(Double_t* x, Double_t* par);
-	Double_t Q1234FactorVsThetaWobble(Double_t* x, Double_t* par);
+	void ResetSmearing();
+	void ClearSmearing();
+	void InitQFactorKernel(Int_t effects);
+	void BuildGridsQFactorVsThetaWobble(const std::vector<Int_t>& effectsList);
+	void ClearGridsQFactorVsThetaWobble();
+	Double_t GetOptimalThetaAndWobbleFromGrid(Double_t &thetaOpt, Double_t &thetaOptRangMin, Double_t &thetaOptRangMax, Double_t &wobbleOpt, Double_t &wobbleOptRangMin, Double_t &wobbleOptRangMax, Int_t type, Double_t tolerance);
+	Double_t GetOptimalThetaAndWobbleFromRefinement(Double_t &thetaOpt, Double_t &thetaOptRangMin, Double_t &thetaOptRangMax, Double_t &wobbleOpt, Double_t &wobbleOptRangMin, Double_t &wobbleOptRangMax, Int_t type, Double_t tolerance);
+	Double_t GetOptimalThetaAndWobbleFromBrent(Double_t &thetaOpt, Double_t &thetaOptRangMin, Double_t &thetaOptRangMax, Double_t &wobbleOpt, Double_t &wobbleOptRangMin, Double_t &wobbleOptRangMax, Int_t type, Double_t tolerance);
+	JDTaskScheduler* GetTaskScheduler();
+	static ULong64_t GetGraphHash(TGraph* graph, ULong64_t hash);
+	TString GetProfileHash();
+	TString GetAcceptanceHash();
+	TGraph* SmeardNdOmegaUniform(TF1* dNdOmega, Double_t psfSigma);
+	TGraph* SmeardNdOmegaAdaptive(TF1* dNdOmega, Double_t psfSigma);
+	void InitdNdOmegaSmeared();
+	void InitdNdOmegaSigma1Smeared();
+	void SetIsdNdOmegaSmeared(Bool_t isdNdOmegaSmeared)					{bIsdNdOmegaSmeared.store(isdNdOmegaSmeared,std::memory_order_release);}
+	void SetIsdNdOmegaSigma1Smeared(Bool_t isdNdOmegaSigma1Smeared)		{bIsdNdOmegaSigma1Smeared.store(isdNdOmegaSigma1Smeared,std::memory_order_release);}
+
+
+	// QFactor of any type (see JDQFactorExpression)
+	Double_t QFactorVsTheta(Double_t* x, Double_t* par);
+	Double_t QFactorVsThetaWobble(Double_t* x, Double_t* par);
 
 	// ...VsTheta
-	Double_t dNdOmegaEpsilonVsTheta(Double_t* x, Double_t* par);
 	Double_t dNdOmegaSmearedVsTheta(Double_t* x, Double_t* par);
 	Double_t dNdOmegaSigma1SmearedVsTheta(Double_t* x, Double_t* par);
 
 	// ...VsThetaPhi
-	Double_t dNdOmegaSmearedVsThetaPhi(Double_t* x, Double_t* par);
 	Double_t dNdOmegaEpsilonVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSmearedEpsilonVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSigma1SmearedEpsilonVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSmearedEpsilonOffVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSigma1SmearedEpsilonOffVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSmearedOffVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSigma1EpsilonVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSigma1OffEpsilonVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSigma1SmearedOffVsThetaPhi(Double_t* x, Double_t* par);
 	Double_t dNdOmegaOffEpsilonVsThetaPhi(Double_t* x, Double_t* par);
 
 	// ...ThetaVsThetaPhi
-	Double_t dNdOmegaSmearedThetaVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSmearedOffThetaVsThetaPhi(Double_t* x, Double_t* par);
 	Double_t dNdOmegaEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSmearedEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSigma1SmearedEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSmearedEpsilonOffThetaVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSigma1SmearedEpsilonOffThetaVsThetaPhi(Double_t* x, Double_t* par);
 	Double_t dNdOmegaOffEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSigma1SmearedThetaVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSigma1EpsilonThetaVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSigma1OffEpsilonThetaVsThetaPhi(Double_t* x, Double_t* par);
-	Double_t dNdOmegaSigma1SmearedOffThetaVsThetaPhi(Double_t* x, Double_t* par);
-
-	// Integrate...ThetaVsTheta
-	Double_t IntegratedNdOmegaEpsilonThetaVsTheta(Double_t* x, Double_t* par);
-	Double_t IntegratedNdOmegaSmearedThetaVsTheta(Double_t* x, Double_t* par);
-	Double_t IntegratedNdOmegaSmearedEpsilonThetaVsTheta(Double_t* x, Double_t* par);
-	Double_t IntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta(Double_t* x, Double_t* par);
-	Double_t IntegratedNdOmegaSmearedEpsilonOffThetaVsTheta(Double_t* x, Double_t* par);
-	Double_t IntegratedNdOmegaSigma1SmearedEpsilonOffThetaVsTheta(Double_t* x, Double_t* par);
-	Double_t IntegratedNdOmegaSmearedOffThetaVsTheta(Double_t* x, Double_t* par);
-	Double_t IntegratedNdOmegaSigma1EpsilonThetaVsTheta(Double_t* x, Double_t* par);
-	Double_t IntegratedNdOmegaOffEpsilonThetaVsTheta(Double_t* x, Double_t* par);
-	Double_t IntegratedNdOmegaSigma1OffEpsilonThetaVsTheta(Double_t* x, Double_t* par);
-	Double_t IntegratedNdOmegaSigma1SmearedThetaVsTheta(Double_t* x, Double_t* par);
-	Double_t IntegratedNdOmegaSigma1SmearedOffThetaVsTheta(Double_t* x, Double_t* par);
+
+	Int_t GetPreparedEffects(Int_t type) const;
 
 	void SetIsJFactorOnLessOff(Bool_t IsJFactorOnLessOff) 			{bIsJFactorOnLessOff=IsJFactorOnLessOff;}
 
 private:
 
-	TF1* fQ0FactorVsTheta;
-	TF1* fQ1FactorVsTheta;
-	TF1* fQ2FactorVsTheta;
-	TF1* fQ3FactorVsTheta;
-
-	TF1* fQ12FactorVsTheta;
-	TF1* fQ13FactorVsTheta;
-	TF1* fQ23FactorVsTheta;
-	TF1* fQ123FactorVsTheta;
-	TF1* fQ124FactorVsTheta;
-	TF1* fQ134FactorVsTheta;
-	TF1* fQ234FactorVsTheta;
-	TF1* fQ1234FactorVsTheta;
-
-	TF2* fQ0FactorVsThetaWobble;
-	TF2* fQ1FactorVsThetaWobble;
-	TF2* fQ2FactorVsThetaWobble;
-	TF2* fQ3FactorVsThetaWobble;
-	TF2* fQ4FactorVsThetaWobble;
-	TF2* fQ12FactorVsThetaWobble;
-	TF2* fQ13FactorVsThetaWobble;
-	TF2* fQ14FactorVsThetaWobble;
-	TF2* fQ23FactorVsThetaWobble;
-	TF2* fQ24FactorVsThetaWobble;
-	TF2* fQ34FactorVsThetaWobble;
-	TF2* fQ123FactorVsThetaWobble;
-	TF2* fQ124FactorVsThetaWobble;
-	TF2* fQ134FactorVsThetaWobble;
-	TF2* fQ234FactorVsThetaWobble;
-	TF2* fQ1234FactorVsThetaWobble;
-
-
-	// IntegratedNdOmega...
-	TF1* fIntegratedNdOmegaEpsilonThetaVsTheta;
-	TF1* fIntegratedNdOmegaSmearedThetaVsTheta;
-	TF1* fIntegratedNdOmegaSmearedEpsilonThetaVsTheta;
-	TF1* fIntegratedNdOmegaSigma1SmearedEpsilonThetaVsTheta;
-	TF1* fIntegratedNdOmegaSmearedEpsilonOffThetaVsTheta;
-	TF1* fIntegratedNdOmegaSigma1SmearedEpsilonOffThetaVsTheta;
-	TF1* fIntegratedNdOmegaSmearedOffThetaVsTheta;
-	TF1* fIntegratedNdOmegaSigma1EpsilonThetaVsTheta;
-	TF1* fIntegratedNdOmegaOffEpsilonThetaVsTheta;
-	TF1* fIntegratedNdOmegaSigma1OffEpsilonThetaVsTheta;
-	TF1* fIntegratedNdOmegaSigma1SmearedThetaVsTheta;
-	TF1* fIntegratedNdOmegaSigma1SmearedOffThetaVsTheta;
+	std::map<Int_t, TF1*> mapTF1QFactorVsTheta;				// key: effects of the type (see JDQFactorKernel::GetEffects())
+	std::map<Int_t, TF2*> mapTF2QFactorVsThetaWobble;
+
 
 	// ...VsTheta
 	TF1* fdNdOmegaSmearedVsTheta;
 	TF1* fdNdOmegaSigma1SmearedVsTheta;
 
 	// ...VsThetaPhi
-	TF2* fdNdOmegaSmearedOffVsThetaPhi;
 	TF2* fdNdOmegaEpsilonVsThetaPhi;
-	TF2* fdNdOmegaSmearedEpsilonVsThetaPhi;
-	TF2* fdNdOmegaSigma1SmearedEpsilonVsThetaPhi;
-	TF2* fdNdOmegaSmearedEpsilonOffVsThetaPhi;
-	TF2* fdNdOmegaSigma1SmearedEpsilonOffVsThetaPhi;
 	TF2* fdNdOmegaOffEpsilonVsThetaPhi;
-	TF2* fdNdOmegaSigma1EpsilonVsThetaPhi;
-	TF2* fdNdOmegaSigma1OffEpsilonVsThetaPhi;
-	TF2* fdNdOmegaSigma1SmearedOffVsThetaPhi;
-	TF2* fdNdOmegaSigma1SmearedOffVsThetaPhi;
 
 	// ...ThetaVsThetaPhi
-	TF2* fdNdOmegaSmearedThetaVsThetaPhi;
-	TF2* fdNdOmegaSmearedOffThetaVsThetaPhi;
 	TF2* fdNdOmegaEpsilonThetaVsThetaPhi;
-	TF2* fdNdOmegaSmearedEpsilonThetaVsThetaPhi;
-	TF2* fdNdOmegaSigma1SmearedEpsilonThetaVsThetaPhi;
-	TF2* fdNdOmegaSmearedEpsilonOffThetaVsThetaPhi;
-	TF2* fdNdOmegaSigma1SmearedEpsilonOffThetaVsThetaPhi;
 	TF2* fdNdOmegaOffEpsilonThetaVsThetaPhi;
-	TF2* fdNdOmegaSigma1EpsilonThetaVsThetaPhi;
-	TF2* fdNdOmegaSigma1OffEpsilonThetaVsThetaPhi;
-	TF2* fdNdOmegaSigma1SmearedThetaVsThetaPhi;
-	TF2* fdNdOmegaSigma1SmearedOffThetaVsThetaPhi;
-
 
 	TGraph* gdNdOmegaSmeared;
 	TGraph* gdNdOmegaSigma1Smeared;
 
 	Double_t dDeg2Rad;
 	Double_t dBinResolution;
+	Double_t dSmearingCoreResolution;
+	Bool_t bIsSmearingAdaptive;
 
 	Bool_t bIsJFactorOnLessOff;
-	Bool_t bIsdNdOmegaSmeared;
-	Bool_t bIsdNdOmegaSigma1Smeared;
-
-	TH2D* th2QFactorVsThetaWobble;
+	std::atomic<Bool_t> bIsdNdOmegaSmeared;
+	std::atomic<Bool_t> bIsdNdOmegaSigma1Smeared;
+	std::mutex mSmearingMutex;	// serializes the lazy smearing (InitdNdOmega...Smeared())
+	std::mutex mGridMutex;		// serializes the build of the cached QFactor grids
+
+	std::map<Int_t, JDGrid2D*> mapGridQFactorVsThetaWobble;		// key: effects of the type (see JDQFactorKernel::GetEffects())
+
+	JDQFactorKernel* qFactorKernel;
+	JDTaskScheduler* taskScheduler;
+	Int_t iNumThreads;
+	Bool_t bIsQFactorKernelSpecialized;
+	Int_t iReductionMode;
+	JDBackgroundGeometry backgroundGeometry;
+	JDSurfaceStore* surfaceStore;
+	Double_t dCheckpointInterval;
+
+	Int_t iOptimizationMode;
+	Double_t dTolerance;
+	Int_t iNumQFactorEvaluations;
+	Bool_t bIsVerbose;
 };
 
 #endif /* 	JDOptimitzation_H_ */
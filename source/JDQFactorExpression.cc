@@ -0,0 +1,113 @@
+/*
+ * JDQFactorExpression.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 QFACTORS AS A SMALL EXPRESSION GRAPH OVER THE INTEGRALS OF JDQFactorKernel.
+ */
+
+#include "JDQFactorExpression.h"
+#include "JDQFactorKernel.h"
+
+#include <TMath.h>
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+//-----------------------------------------------
+//	Empty expression. isOnMinusOff chooses how the OFF integral enters the QFactors (see JDQFactorExpression.h)
+JDQFactorExpression::JDQFactorExpression(Bool_t isOnMinusOff):
+iComponents(0), bIsOnMinusOff(isOnMinusOff)
+{
+}
+
+//-----------------------------------------------
+//	It returns the index of the node (operation, left, right, component), creating it only if it does not exist yet
+Int_t JDQFactorExpression::AddNode(Int_t operation, Int_t left, Int_t right, Int_t component)
+{
+	// a+b and b+a are the same node
+	if(operation==kAdd && right<left) std::swap(left,right);
+
+	Node node;
+	node.iOperation = operation;
+	node.iLeft = left;
+	node.iRight = right;
+	node.iComponent = component;
+
+	std::map<Node, Int_t>::const_iterator it = mapNodes.find(node);
+	if(it!=mapNodes.end()) return it->second;
+
+	vNodes.push_back(node);
+	mapNodes[node] = vNodes.size()-1;
+	if(operation==kComponent) iComponents |= 1<<component;
+	return vNodes.size()-1;
+}
+
+//-----------------------------------------------
+//	It adds the QFactor with these effects (see JDQFactorKernel::Effect) and returns its index
+Int_t JDQFactorExpression::AddQFactor(Int_t effects)
+{
+	Int_t profileIndex = JDQFactorKernel::GetProfileIndex(effects);
+	Bool_t isAcceptance = effects&JDQFactorKernel::kAcceptance;
+
+	Int_t on = AddNode(kComponent,-1,-1,JDQFactorKernel::GetOnComponent(profileIndex,isAcceptance));
+	Int_t noise = (isAcceptance? AddNode(kComponent,-1,-1,JDQFactorKernel::kAccComponent) : AddNode(kSolidAngle));
+
+	Int_t root;
+	if(effects&JDQFactorKernel::kLeakage)
+	{
+		Int_t off = AddNode(kComponent,-1,-1,JDQFactorKernel::GetOffComponent(profileIndex,isAcceptance));
+		if(bIsOnMinusOff)	root = AddNode(kDivide,AddNode(kSubtract,on,off),AddNode(kSqrt,noise));
+		else				root = AddNode(kDivide,on,AddNode(kSqrt,AddNode(kAdd,noise,off)));		// NOT CORRECT IF YOU DONT DEFINE A & B
+	}
+	else
+	{
+		root = AddNode(kDivide,on,AddNode(kSqrt,noise));
+	}
+
+	vRoots.push_back(root);
+	vEffects.push_back(effects);
+	return vRoots.size()-1;
+}
+
+//-----------------------------------------------
+//	It evaluates all the nodes (values must have GetNumNodes() elements) from the integrals over the disk of
+//	radius theta [deg] (sums, see JDQFactorKernel::GetComponents()). The QFactors are read with GetQFactor().
+void JDQFactorExpression::Evaluate(const Double_t* sums, Double_t theta, Double_t* values) const
+{
+	Int_t numNodes = vNodes.size();
+	for(Int_t n=0; n<numNodes; n++)
+	{
+		const Node& node = vNodes[n];
+		switch(node.iOperation)
+		{
+			case kComponent:	values[n] = sums[node.iComponent]; break;
+			case kSolidAngle:	values[n] = 4*TMath::Pi()*theta*theta; break;
+			case kAdd:			values[n] = values[node.iLeft]+values[node.iRight]; break;
+			case kSubtract:		values[n] = values[node.iLeft]-values[node.iRight]; break;
+			case kDivide:		values[n] = values[node.iLeft]/values[node.iRight]; break;
+			case kSqrt:			values[n] = TMath::Sqrt(values[node.iLeft]); break;
+		}
+	}
+}
+
+//-----------------------------------------------
+//	It prints the nodes in evaluation order and the node of each QFactor
+void JDQFactorExpression::Print() const
+{
+	const char* names[6] = {"Component", "SolidAngle", "Add", "Subtract", "Divide", "Sqrt"};
+
+	cout << "   JDQFactorExpression: " << vNodes.size() << " nodes, " << vRoots.size() << " QFactors" << endl;
+	for(UInt_t n=0; n<vNodes.size(); n++)
+	{
+		const Node& node = vNodes[n];
+		cout << "      [" << n << "] " << names[node.iOperation];
+		if(node.iOperation==kComponent)	cout << " " << node.iComponent;
+		if(node.iLeft>=0)				cout << " [" << node.iLeft << "]";
+		if(node.iRight>=0)				cout << " [" << node.iRight << "]";
+		cout << endl;
+	}
+	for(UInt_t q=0; q<vRoots.size(); q++) cout << "      QFactor (effects " << vEffects[q] << ") = [" << vRoots[q] << "]" << endl;
+}
@@ -0,0 +1,74 @@
+/*
+ * JDQFactorExpression.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 QFACTORS AS A SMALL EXPRESSION GRAPH OVER THE INTEGRALS OF JDQFactorKernel.
+ *  		 EACH QFACTOR TYPE IS BUILT FROM ITS EFFECTS (LEAKAGE, UNCERTAINTY, ACCEPTANCE, SMEARING):
+ *  		 	Q = (ON-OFF)/Sqrt(NOISE)		[or ON/Sqrt(NOISE+OFF) if ON-OFF is not used]
+ *  		 WHERE ON AND OFF ARE THE INTEGRALS OF THE PROFILE OF THE EFFECTS (WITH ACCEPTANCE IF NEEDED)
+ *  		 AND NOISE IS ACC (ACCEPTANCE) OR 4pi·theta^2. THE (1+alpha) OF THE BACKGROUND IN THE NOISE IS A CONSTANT FACTOR
+ *  		 OF THE QFACTOR, APPLIED BY JDQFactorKernel (SEE JDBackgroundGeometry::GetQFactorScale()).
+ *  		 IDENTICAL NODES ARE CREATED ONLY ONCE, SO SEVERAL QFACTORS IN THE SAME EXPRESSION SHARE
+ *  		 THEIR INTEGRALS AND OPERATIONS. THE NODES ARE KEPT IN EVALUATION ORDER.
+ */
+
+#ifndef JDQFactorExpression_H_
+#define JDQFactorExpression_H_
+
+#include <Rtypes.h>
+
+#include <map>
+#include <vector>
+
+class JDQFactorExpression {
+public:
+	// Operations of the nodes. The leaves are integrals of JDQFactorKernel (kComponent) or 4pi·theta^2 (kSolidAngle)
+	enum Operation {kComponent=0, kSolidAngle=1, kAdd=2, kSubtract=3, kDivide=4, kSqrt=5};
+	// Nodes of an expression of one QFactor: ON, NOISE, OFF, ON-OFF (or NOISE+OFF), Sqrt, Divide
+	static const Int_t kMaxNumNodesQFactor = 6;
+
+	JDQFactorExpression(Bool_t isOnMinusOff=1);
+	virtual ~JDQFactorExpression() {}
+
+	Int_t AddQFactor(Int_t effects);
+
+	Int_t GetNumQFactors() const				{return vRoots.size();}
+	Int_t GetNumNodes() const					{return vNodes.size();}
+	Int_t GetComponents() const					{return iComponents;}
+	Int_t GetEffects(Int_t qFactor) const		{return vEffects[qFactor];}
+
+	void Evaluate(const Double_t* sums, Double_t theta, Double_t* values) const;
+	Double_t GetQFactor(const Double_t* values, Int_t qFactor) const		{return values[vRoots[qFactor]];}
+
+	void Print() const;
+
+private:
+	class Node {
+	public:
+		Int_t iOperation;
+		Int_t iLeft;
+		Int_t iRight;
+		Int_t iComponent;
+
+		Bool_t operator<(const Node& node) const
+		{
+			if(iOperation!=node.iOperation) return iOperation<node.iOperation;
+			if(iLeft!=node.iLeft) return iLeft<node.iLeft;
+			if(iRight!=node.iRight) return iRight<node.iRight;
+			return iComponent<node.iComponent;
+		}
+	};
+
+	Int_t AddNode(Int_t operation, Int_t left=-1, Int_t right=-1, Int_t component=-1);
+
+	std::vector<Node> vNodes;				// the arguments of a node are always before it
+	std::map<Node, Int_t> mapNodes;			// node -> index in vNodes
+	std::vector<Int_t> vRoots;				// node of each QFactor
+	std::vector<Int_t> vEffects;			// effects of each QFactor
+
+	Int_t iComponents;						// mask of the integrals used (see JDQFactorKernel::GetComponents())
+	Bool_t bIsOnMinusOff;
+};
+
+#endif /* JDQFactorExpression_H_ */
@@ -0,0 +1,498 @@
+/*
+ * JDQFactorKernel.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 THREAD-SAFE EVALUATION OF THE QFACTOR VS THETA AND WOBBLE.
+ */
+
+#include "JDQFactorKernel.h"
+#include "JDQuadrature.h"
+
+#include <TMath.h>
+
+using namespace std;
+
+//-----------------------------------------------
+//	Empty kernel: the tables are filled with SetProfile() and SetEpsilon()
+JDQFactorKernel::JDQFactorKernel():
+dDccMax(0.), vSinPhi(kNumPhi), dPanelWidth(0.05), dDeg2Rad(TMath::Pi()/180.),
+bIsSphericalCoordinates(0), bIsOnMinusOff(1), bIsSpecialized(1), iReductionMode(JDReduction::kDeterministic)
+{
+	for(Int_t m=0; m<kNumPhi; m++) vSinPhi[m]=TMath::Sin(2*TMath::Pi()*m/kNumPhi);
+	SetBackgroundGeometry(JDBackgroundGeometry());
+	SetExpressions();
+}
+
+//-----------------------------------------------
+//	It sets how the OFF integral enters the QFactors (see JDQFactorExpression)
+void JDQFactorKernel::SetIsOnMinusOff(Bool_t isOnMinusOff)
+{
+	bIsOnMinusOff = isOnMinusOff;
+	SetExpressions();
+}
+
+//-----------------------------------------------
+//	It builds the expression of the QFactor of every effects once, so the generic Evaluate() and EvaluateRow()
+//	do not build one at each call
+void JDQFactorKernel::SetExpressions()
+{
+	for(Int_t effects=0; effects<kNumEffects; effects++)
+	{
+		vExpressions[effects] = JDQFactorExpression(bIsOnMinusOff);
+		vExpressions[effects].AddQFactor(effects);
+	}
+}
+
+//-----------------------------------------------
+//	It sets the OFF regions of the leakage (see JDBackgroundGeometry). The distance between the source and the
+//	point theta', phi of an OFF region at distance d with tilt t is Sqrt(theta'^2+d^2+2·theta'·d·cos(phi-pi/2+t)).
+//	The single OFF region (d=2, t=0) keeps exactly the cos(phi-pi/2)=sin(phi) of the table.
+//	The noise of the QFactors has the (1+alpha) of the background estimated in them (see JDBackgroundGeometry::GetQFactorScale()).
+void JDQFactorKernel::SetBackgroundGeometry(const JDBackgroundGeometry& backgroundGeometry)
+{
+	dQFactorScale = backgroundGeometry.GetQFactorScale();
+	iNumOffRegions = backgroundGeometry.GetNumDistinctOffRegions();
+	vOffCosAngle.resize(iNumOffRegions*kNumPhi);
+	for(Int_t r=0; r<iNumOffRegions; r++)
+	{
+		vOffDistance[r] = backgroundGeometry.GetOffRegionDistance(r);
+		vOffWeight[r] = backgroundGeometry.GetDistinctOffRegionWeight(r);
+		Double_t tilt = backgroundGeometry.GetOffRegionTilt(r);
+		Double_t cosTilt = (tilt==0.? 1. : TMath::Cos(tilt));
+		Double_t sinTilt = (tilt==0.? 0. : TMath::Sin(tilt));
+		for(Int_t m=0; m<kNumPhi; m++)
+		{
+			Double_t cosPhi = TMath::Cos(2*TMath::Pi()*m/kNumPhi);
+			vOffCosAngle[r*kNumPhi+m] = vSinPhi[m]*cosTilt+cosPhi*sinTilt;
+		}
+	}
+}
+
+//-----------------------------------------------
+//	It converts the QFactor type (digits 1: leakage, 2: uncertainty, 3: acceptance, 4: smearing; 0: ideal)
+//	into a mask of Effect. It returns -1 if the type is not valid (unknown or repeated digit).
+Int_t JDQFactorKernel::GetEffects(Int_t type)
+{
+	if(type<0) return -1;
+
+	Int_t effects=0;
+	for(; type>0; type/=10)
+	{
+		Int_t effect;
+		switch(type%10)
+		{
+			case 1: effect=kLeakage; break;
+			case 2: effect=kUncertainty; break;
+			case 3: effect=kAcceptance; break;
+			case 4: effect=kSmearing; break;
+			default: return -1;
+		}
+		if(effects&effect) return -1;
+		effects|=effect;
+	}
+	return effects;
+}
+
+//-----------------------------------------------
+//	It returns the mask (bit c for the component c) of the integrals needed by the QFactor with these effects
+Int_t JDQFactorKernel::GetComponents(Int_t effects)
+{
+	Int_t profileIndex = GetProfileIndex(effects);
+	Bool_t isAcceptance = effects&kAcceptance;
+
+	Int_t components = 1<<GetOnComponent(profileIndex,isAcceptance);
+	if(effects&kLeakage) components |= 1<<GetOffComponent(profileIndex,isAcceptance);
+	if(isAcceptance) components |= 1<<kAccComponent;
+	return components;
+}
+
+//-----------------------------------------------
+//	It samples dNdOmega vs theta [deg] in [0, thetaMax] every step [deg].
+//	Beyond the range of dNdOmega it is 0: a TF1 over a TGraph would extrapolate it linearly (and negative).
+//	Must be called before evaluating from several threads.
+void JDQFactorKernel::SetProfile(Int_t profileIndex, TF1* dNdOmega, Double_t thetaMax, Double_t step)
+{
+	Int_t numBins = TMath::CeilNint(thetaMax/step);
+	gProfile[profileIndex] = JDGrid1D(JDGridAxis(numBins,0.,numBins*step));
+
+	const JDGridAxis& axis = gProfile[profileIndex].GetXaxis();
+	for(Int_t i=0; i<numBins; i++)
+	{
+		Double_t theta = axis.GetBinCenter(i);
+		gProfile[profileIndex].SetBinContent(i,(theta<=dNdOmega->GetXmax()? dNdOmega->Eval(theta) : 0.));
+	}
+}
+
+//-----------------------------------------------
+//	It samples the camera acceptance vs dcc [deg] in [0, dccMax] every step [deg]
+//	Must be called before evaluating from several threads.
+void JDQFactorKernel::SetEpsilon(TF1* epsilonVsDcc, Double_t dccMax, Double_t step)
+{
+	Int_t numBins = TMath::CeilNint(dccMax/step);
+	gEpsilon = JDGrid1D(JDGridAxis(numBins,0.,numBins*step));
+	dDccMax = dccMax;
+
+	const JDGridAxis& axis = gEpsilon.GetXaxis();
+	for(Int_t i=0; i<numBins; i++) gEpsilon.SetBinContent(i,epsilonVsDcc->Eval(TMath::Min(axis.GetBinCenter(i),dccMax)));
+}
+
+//-----------------------------------------------
+//	It adds to sums the integrals in components (see GetComponents()) over the ring thetaLow<theta'<thetaUp [deg]
+//	(Gauss-Legendre in theta', trapezoid in phi). The source is at wobble [deg] from the camera center, and the OFF
+//	region at 2·wobble [deg] from the source. The acceptance and the distances are computed once for all the components.
+void JDQFactorKernel::IntegrateShell(Int_t components, Double_t thetaLow, Double_t thetaUp, Double_t wobble, Double_t* sums) const
+{
+	Bool_t isOnProfile[kNumProfiles];
+	Bool_t isOffProfile[kNumProfiles];
+	Bool_t isAnyOff = 0;
+	Bool_t isEpsilon = components&(1<<kAccComponent);
+	for(Int_t p=0; p<kNumProfiles; p++)
+	{
+		isOnProfile[p] = components&((1<<GetOnComponent(p,0))|(1<<GetOnComponent(p,1)));
+		isOffProfile[p] = components&((1<<GetOffComponent(p,0))|(1<<GetOffComponent(p,1)));
+		isAnyOff |= isOffProfile[p];
+		isEpsilon |= (components&((1<<GetOnComponent(p,1))|(1<<GetOffComponent(p,1))))!=0;
+	}
+
+	Double_t halfWidth = 0.5*(thetaUp-thetaLow);
+	Double_t middle = 0.5*(thetaUp+thetaLow);
+	Double_t dPhi = 2*TMath::Pi()/kNumPhi;
+	const Double_t* sinPhi = vSinPhi.data();
+	const Double_t* offCosAngle = vOffCosAngle.data();
+	Double_t distOff[kMaxNumOffRegions];
+	for(Int_t r=0; r<iNumOffRegions; r++) distOff[r] = vOffDistance[r]*wobble;
+
+	for(Int_t g=0; g<JDQuadrature::kNumGaussNodes; g++)
+	{
+		Double_t theta = middle+halfWidth*JDQuadrature::kGaussNodes[g];
+		Double_t weight = halfWidth*JDQuadrature::kGaussWeights[g]*dPhi*(bIsSphericalCoordinates? TMath::Sin(theta*dDeg2Rad) : theta);
+
+		Double_t sumEpsilon = kNumPhi;
+		Double_t sumOff[kNumProfiles][2] = {{0.,0.},{0.,0.},{0.,0.},{0.,0.}};
+		if(isEpsilon || isAnyOff)
+		{
+			sumEpsilon = 0.;
+			for(Int_t m=0; m<kNumPhi; m++)
+			{
+				Double_t epsilon = 1.;
+				if(isEpsilon) epsilon = GetEpsilon(TMath::Sqrt(TMath::Max(0.,wobble*wobble+theta*theta+2*wobble*theta*sinPhi[m])));
+				sumEpsilon += epsilon;
+
+				if(!isAnyOff) continue;
+				for(Int_t r=0; r<iNumOffRegions; r++)
+				{
+					Double_t distSourceOff = TMath::Sqrt(TMath::Max(0.,theta*theta+distOff[r]*distOff[r]+2*theta*distOff[r]*offCosAngle[r*kNumPhi+m]));
+					for(Int_t p=0; p<kNumProfiles; p++)
+					{
+						if(!isOffProfile[p]) continue;
+						Double_t dNdOmegaOff = vOffWeight[r]*gProfile[p].Interpolate(distSourceOff);
+						sumOff[p][0] += dNdOmegaOff;
+						sumOff[p][1] += dNdOmegaOff*epsilon;
+					}
+				}
+			}
+		}
+
+		for(Int_t p=0; p<kNumProfiles; p++)
+		{
+			if(isOnProfile[p])
+			{
+				Double_t dNdOmega = gProfile[p].Interpolate(theta);
+				sums[GetOnComponent(p,0)] += weight*dNdOmega*kNumPhi;
+				sums[GetOnComponent(p,1)] += weight*dNdOmega*sumEpsilon;
+			}
+			if(isOffProfile[p])
+			{
+				sums[GetOffComponent(p,0)] += weight*sumOff[p][0];
+				sums[GetOffComponent(p,1)] += weight*sumOff[p][1];
+			}
+		}
+		sums[kAccComponent] += weight*sumEpsilon;
+	}
+}
+
+//-----------------------------------------------
+//	It computes the integrals in components over the disk of radius theta [deg], in panels of dPanelWidth
+void JDQFactorKernel::IntegrateDisk(Int_t components, Double_t theta, Double_t wobble, Double_t* sums) const
+{
+	JDNeumaierSum diskSums[kNumComponents];
+	Double_t panelSums[kNumComponents];
+
+	Int_t numPanels = TMath::Max(1,TMath::CeilNint(theta/dPanelWidth));
+	Double_t panelWidth = theta/numPanels;
+	for(Int_t p=0; p<numPanels; p++)
+	{
+		for(Int_t c=0; c<kNumComponents; c++) panelSums[c]=0.;
+		IntegrateShell(components,p*panelWidth,(p+1)*panelWidth,wobble,panelSums);
+		AddPanel(panelSums,kNumComponents,diskSums);
+	}
+	for(Int_t c=0; c<kNumComponents; c++) sums[c]=diskSums[c].GetSum();
+}
+
+//-----------------------------------------------
+//	It evaluates the QFactor (not normalized) at theta [deg] and wobble [deg]. Thread-safe.
+Double_t JDQFactorKernel::Evaluate(Int_t effects, Double_t theta, Double_t wobble) const
+{
+	if(bIsSpecialized) return (this->*GetSpecialization(effects,bIsSphericalCoordinates).fEvaluate)(theta,wobble);
+
+	const JDQFactorExpression& expression = vExpressions[effects];
+
+	Double_t sums[kNumComponents];
+	IntegrateDisk(expression.GetComponents(),theta,wobble,sums);
+
+	Double_t values[JDQFactorExpression::kMaxNumNodesQFactor];
+	expression.Evaluate(sums,theta,values);
+	return dQFactorScale*expression.GetQFactor(values,0);
+}
+
+//-----------------------------------------------
+//	It evaluates the QFactor (not normalized) at the centres of thetaAxis for one wobble [deg] and writes it in row.
+//	Thread-safe if every thread uses its own context.
+void JDQFactorKernel::EvaluateRow(Int_t effects, Double_t wobble, const JDGridAxis& thetaAxis, Double_t* row, JDEvalContext& context) const
+{
+	if(bIsSpecialized)
+	{
+		JDNeumaierSum diskSums[kNumComponents];
+		(this->*GetSpecialization(effects,bIsSphericalCoordinates).fEvaluateRow)(wobble,thetaAxis,0,thetaAxis.GetNumBins(),row,diskSums);
+		return;
+	}
+
+	EvaluateRows(vExpressions[effects],wobble,thetaAxis,&row,context);
+}
+
+//-----------------------------------------------
+//	As EvaluateRow(), but only for the bins of thetaAxis from the last one evaluated in sweep up to numBins, going on
+//	with the integrals of sweep: the row is swept in several steps as in one, with the same values.
+//	Thread-safe if every thread uses its own context and sweep.
+void JDQFactorKernel::ContinueRow(Int_t effects, Double_t wobble, const JDGridAxis& thetaAxis, Int_t numBins, Double_t* row, RowSweep& sweep, JDEvalContext& context) const
+{
+	numBins = TMath::Min(numBins,thetaAxis.GetNumBins());
+	Int_t firstBin = sweep.iNumBins;
+	if(numBins<=firstBin) return;
+
+	if(bIsSpecialized)
+	{
+		(this->*GetSpecialization(effects,bIsSphericalCoordinates).fEvaluateRow)(wobble,thetaAxis,firstBin,numBins,row,sweep.vSums);
+	}
+	else
+	{
+		const JDQFactorExpression& expression = vExpressions[effects];
+		context.vSums.resize((numBins-firstBin)*kNumComponents);
+		context.vValues.resize(expression.GetNumNodes());
+		Double_t* sums = context.vSums.data();
+		Double_t* values = context.vValues.data();
+
+		SweepDisk(expression.GetComponents(),wobble,thetaAxis,firstBin,numBins,sweep.vSums,sums);
+		for(Int_t i=firstBin; i<numBins; i++)
+		{
+			expression.Evaluate(sums+(i-firstBin)*kNumComponents,thetaAxis.GetBinCenter(i),values);
+			row[i] = dQFactorScale*expression.GetQFactor(values,0);
+		}
+	}
+	sweep.iNumBins = numBins;
+}
+
+//-----------------------------------------------
+//	Ascending radial sweep of the bins [firstBin, endBin) of thetaAxis: the disks of consecutive theta are nested, so
+//	the integrals at the centre i are the ones at the centre i-1 (in diskSums, updated) plus the ring between both
+//	centres (added panel by panel, see AddPanel()). The integrals of the bin i are written in sums+(i-firstBin)*kNumComponents.
+void JDQFactorKernel::SweepDisk(Int_t components, Double_t wobble, const JDGridAxis& thetaAxis, Int_t firstBin, Int_t endBin, JDNeumaierSum* diskSums, Double_t* sums) const
+{
+	Double_t panelSums[kNumComponents];
+	Double_t thetaLow = (firstBin>0? thetaAxis.GetBinCenter(firstBin-1) : 0.);
+	for(Int_t i=firstBin; i<endBin; i++)
+	{
+		Double_t thetaUp = thetaAxis.GetBinCenter(i);
+		Int_t numPanels = TMath::Max(1,TMath::CeilNint((thetaUp-thetaLow)/dPanelWidth));
+		Double_t panelWidth = (thetaUp-thetaLow)/numPanels;
+		for(Int_t p=0; p<numPanels; p++)
+		{
+			for(Int_t c=0; c<kNumComponents; c++) panelSums[c]=0.;
+			IntegrateShell(components,thetaLow+p*panelWidth,thetaLow+(p+1)*panelWidth,wobble,panelSums);
+			AddPanel(panelSums,kNumComponents,diskSums);
+		}
+
+		Double_t* sumsBin = sums+(i-firstBin)*kNumComponents;
+		for(Int_t c=0; c<kNumComponents; c++) sumsBin[c]=diskSums[c].GetSum();
+		thetaLow = thetaUp;
+	}
+}
+
+//-----------------------------------------------
+//	It evaluates all the QFactors of expression (not normalized) at the centres of thetaAxis for one wobble [deg]
+//	and writes the QFactor q in rows[q]. The integrals used by the expression are computed once (see GetComponents()),
+//	in one ascending radial sweep (see SweepDisk()).
+//	Thread-safe if every thread uses its own context.
+void JDQFactorKernel::EvaluateRows(const JDQFactorExpression& expression, Double_t wobble, const JDGridAxis& thetaAxis, Double_t* const* rows, JDEvalContext& context) const
+{
+	Int_t numBins = thetaAxis.GetNumBins();
+	Int_t numQFactors = expression.GetNumQFactors();
+	if(numBins<=0 || numQFactors<=0) return;
+
+	// one QFactor: nothing to share, the specialized kernel is faster
+	if(numQFactors==1 && bIsSpecialized)
+	{
+		JDNeumaierSum diskSums[kNumComponents];
+		(this->*GetSpecialization(expression.GetEffects(0),bIsSphericalCoordinates).fEvaluateRow)(wobble,thetaAxis,0,numBins,rows[0],diskSums);
+		return;
+	}
+
+	Int_t components = expression.GetComponents();
+
+	context.vSums.resize(numBins*kNumComponents);
+	context.vValues.resize(expression.GetNumNodes());
+	Double_t* sums = context.vSums.data();
+	Double_t* values = context.vValues.data();
+
+	JDNeumaierSum diskSums[kNumComponents];
+	SweepDisk(components,wobble,thetaAxis,0,numBins,diskSums,sums);
+
+	for(Int_t i=0; i<numBins; i++)
+	{
+		expression.Evaluate(sums+i*kNumComponents,thetaAxis.GetBinCenter(i),values);
+		for(Int_t q=0; q<numQFactors; q++) rows[q][i] = dQFactorScale*expression.GetQFactor(values,q);
+	}
+}
+
+//-----------------------------------------------
+//	Specialized kernels: the effects and the geometry are template parameters, so every test on them is resolved at
+//	compile time and only the integrals of this QFactor (ON, OFF if leakage, ACC if acceptance) are computed.
+//	They follow IntegrateShell(), IntegrateDisk() and EvaluateRows() with sums = {ON, OFF, ACC}.
+
+//-----------------------------------------------
+//	It returns the specialized functions of these effects (see Effect) and geometry
+JDQFactorKernel::Specialization JDQFactorKernel::GetSpecialization(Int_t effects, Bool_t isSphericalCoordinates)
+{
+	switch(effects)
+	{
+		case 0:		return (isSphericalCoordinates? GetSpecialization<0,1>() : GetSpecialization<0,0>());
+		case 1:		return (isSphericalCoordinates? GetSpecialization<1,1>() : GetSpecialization<1,0>());
+		case 2:		return (isSphericalCoordinates? GetSpecialization<2,1>() : GetSpecialization<2,0>());
+		case 3:		return (isSphericalCoordinates? GetSpecialization<3,1>() : GetSpecialization<3,0>());
+		case 4:		return (isSphericalCoordinates? GetSpecialization<4,1>() : GetSpecialization<4,0>());
+		case 5:		return (isSphericalCoordinates? GetSpecialization<5,1>() : GetSpecialization<5,0>());
+		case 6:		return (isSphericalCoordinates? GetSpecialization<6,1>() : GetSpecialization<6,0>());
+		case 7:		return (isSphericalCoordinates? GetSpecialization<7,1>() : GetSpecialization<7,0>());
+		case 8:		return (isSphericalCoordinates? GetSpecialization<8,1>() : GetSpecialization<8,0>());
+		case 9:		return (isSphericalCoordinates? GetSpecialization<9,1>() : GetSpecialization<9,0>());
+		case 10:	return (isSphericalCoordinates? GetSpecialization<10,1>() : GetSpecialization<10,0>());
+		case 11:	return (isSphericalCoordinates? GetSpecialization<11,1>() : GetSpecialization<11,0>());
+		case 12:	return (isSphericalCoordinates? GetSpecialization<12,1>() : GetSpecialization<12,0>());
+		case 13:	return (isSphericalCoordinates? GetSpecialization<13,1>() : GetSpecialization<13,0>());
+		case 14:	return (isSphericalCoordinates? GetSpecialization<14,1>() : GetSpecialization<14,0>());
+		default:	return (isSphericalCoordinates? GetSpecialization<15,1>() : GetSpecialization<15,0>());
+	}
+}
+
+//-----------------------------------------------
+template<Int_t kEffects, Bool_t kSpherical>
+JDQFactorKernel::Specialization JDQFactorKernel::GetSpecialization()
+{
+	Specialization specialization;
+	specialization.fEvaluate = &JDQFactorKernel::EvaluateSpecialized<kEffects,kSpherical>;
+	specialization.fEvaluateRow = &JDQFactorKernel::EvaluateRowSpecialized<kEffects,kSpherical>;
+	return specialization;
+}
+
+//-----------------------------------------------
+//	QFactor from sums = {ON, OFF, ACC} over the disk of radius theta [deg]
+template<Int_t kEffects>
+Double_t JDQFactorKernel::GetQFactorSpecialized(Double_t theta, const Double_t* sums) const
+{
+	Double_t off = ((kEffects&kLeakage)? sums[1] : 0.);
+	Double_t noise2 = ((kEffects&kAcceptance)? sums[2] : 4*TMath::Pi()*theta*theta);
+
+	if(bIsOnMinusOff)	return dQFactorScale*(sums[0]-off)/TMath::Sqrt(noise2);
+	else				return dQFactorScale*sums[0]/TMath::Sqrt(noise2+off);		// NOT CORRECT IF YOU DONT DEFINE A & B
+}
+
+//-----------------------------------------------
+//	It adds to sums = {ON, OFF, ACC} the integrals over the ring thetaLow<theta'<thetaUp [deg] (see IntegrateShell())
+template<Int_t kEffects, Bool_t kSpherical>
+void JDQFactorKernel::IntegrateShellSpecialized(Double_t thetaLow, Double_t thetaUp, Double_t wobble, Double_t* sums) const
+{
+	const Bool_t isLeakage = kEffects&kLeakage;
+	const Bool_t isAcceptance = kEffects&kAcceptance;
+	const JDGrid1D& profile = gProfile[((kEffects&kUncertainty)? 1 : 0)+((kEffects&kSmearing)? 2 : 0)];
+
+	Double_t halfWidth = 0.5*(thetaUp-thetaLow);
+	Double_t middle = 0.5*(thetaUp+thetaLow);
+	Double_t dPhi = 2*TMath::Pi()/kNumPhi;
+	const Double_t* sinPhi = vSinPhi.data();
+	const Double_t* offCosAngle = vOffCosAngle.data();
+	Double_t distOff[kMaxNumOffRegions];
+	for(Int_t r=0; r<iNumOffRegions; r++) distOff[r] = vOffDistance[r]*wobble;
+
+	for(Int_t g=0; g<JDQuadrature::kNumGaussNodes; g++)
+	{
+		Double_t theta = middle+halfWidth*JDQuadrature::kGaussNodes[g];
+		Double_t weight = halfWidth*JDQuadrature::kGaussWeights[g]*dPhi*(kSpherical? TMath::Sin(theta*dDeg2Rad) : theta);
+
+		Double_t sumEpsilon = kNumPhi;
+		Double_t sumOff = 0.;
+		if(isAcceptance || isLeakage)
+		{
+			sumEpsilon = 0.;
+			for(Int_t m=0; m<kNumPhi; m++)
+			{
+				Double_t epsilon = (isAcceptance? GetEpsilon(TMath::Sqrt(TMath::Max(0.,wobble*wobble+theta*theta+2*wobble*theta*sinPhi[m]))) : 1.);
+				sumEpsilon += epsilon;
+				if(!isLeakage) continue;
+				for(Int_t r=0; r<iNumOffRegions; r++)
+				{
+					Double_t distSourceOff = TMath::Sqrt(TMath::Max(0.,theta*theta+distOff[r]*distOff[r]+2*theta*distOff[r]*offCosAngle[r*kNumPhi+m]));
+					sumOff += vOffWeight[r]*profile.Interpolate(distSourceOff)*epsilon;
+				}
+			}
+		}
+
+		sums[0] += weight*profile.Interpolate(theta)*sumEpsilon;
+		if(isLeakage) sums[1] += weight*sumOff;
+		if(isAcceptance) sums[2] += weight*sumEpsilon;
+	}
+}
+
+//-----------------------------------------------
+//	Specialized Evaluate()
+template<Int_t kEffects, Bool_t kSpherical>
+Double_t JDQFactorKernel::EvaluateSpecialized(Double_t theta, Double_t wobble) const
+{
+	JDNeumaierSum diskSums[3];
+
+	Int_t numPanels = TMath::Max(1,TMath::CeilNint(theta/dPanelWidth));
+	Double_t panelWidth = theta/numPanels;
+	for(Int_t p=0; p<numPanels; p++)
+	{
+		Double_t panelSums[3] = {0.,0.,0.};
+		IntegrateShellSpecialized<kEffects,kSpherical>(p*panelWidth,(p+1)*panelWidth,wobble,panelSums);
+		AddPanel(panelSums,3,diskSums);
+	}
+
+	Double_t sums[3] = {diskSums[0].GetSum(),diskSums[1].GetSum(),diskSums[2].GetSum()};
+	return GetQFactorSpecialized<kEffects>(theta,sums);
+}
+
+//-----------------------------------------------
+//	Specialized EvaluateRow(): the same ascending radial sweep as EvaluateRows(). It needs no scratch buffers.
+template<Int_t kEffects, Bool_t kSpherical>
+void JDQFactorKernel::EvaluateRowSpecialized(Double_t wobble, const JDGridAxis& thetaAxis, Int_t firstBin, Int_t endBin, Double_t* row, JDNeumaierSum* diskSums) const
+{
+	Double_t thetaLow = (firstBin>0? thetaAxis.GetBinCenter(firstBin-1) : 0.);
+	for(Int_t i=firstBin; i<endBin; i++)
+	{
+		Double_t thetaUp = thetaAxis.GetBinCenter(i);
+		Int_t numPanels = TMath::Max(1,TMath::CeilNint((thetaUp-thetaLow)/dPanelWidth));
+		Double_t panelWidth = (thetaUp-thetaLow)/numPanels;
+		for(Int_t p=0; p<numPanels; p++)
+		{
+			Double_t panelSums[3] = {0.,0.,0.};
+			IntegrateShellSpecialized<kEffects,kSpherical>(thetaLow+p*panelWidth,thetaLow+(p+1)*panelWidth,wobble,panelSums);
+			AddPanel(panelSums,3,diskSums);
+		}
+
+		Double_t sums[3] = {diskSums[0].GetSum(),diskSums[1].GetSum(),diskSums[2].GetSum()};
+		row[i] = GetQFactorSpecialized<kEffects>(thetaUp,sums);
+		thetaLow = thetaUp;
+	}
+}
@@ -0,0 +1,175 @@
+/*
+ * JDQFactorKernel.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 THREAD-SAFE EVALUATION OF THE QFACTOR VS THETA AND WOBBLE.
+ *  		 THE PROFILES dN/dOmega (NOMINAL, SIGMA1, SMEARED, SIGMA1 SMEARED) AND THE CAMERA ACCEPTANCE
+ *  		 ARE SAMPLED ONCE (SERIALLY) FROM THEIR TF1s INTO READ-ONLY TABLES. AFTERWARDS THE KERNEL
+ *  		 DOES NOT TOUCH ANY ROOT OBJECT, SO MANY THREADS CAN EVALUATE IT AT THE SAME TIME,
+ *  		 EACH ONE WITH ITS OWN JDEvalContext (SCRATCH BUFFERS).
+ *
+ *  		 THE QFACTOR IS BUILT FROM THREE INTEGRALS OVER THE DISK OF RADIUS theta AROUND THE SOURCE:
+ *  		 	ON  = int dN/dOmega(theta') · epsilon(dcc) dOmega
+ *  		 	OFF = alpha · sum over the OFF regions of
+ *  		 	      int dN/dOmega(distance to the source from the OFF region) · epsilon(dcc) dOmega		(LEAKAGE)
+ *  		 	ACC = int epsilon(dcc) dOmega																(ACCEPTANCE)
+ *  		 	Q   = (ON-OFF)/Sqrt((1+alpha)·ACC)	[or ON/Sqrt((1+alpha)·(ACC+OFF)) if ON-OFF is not used]
+ *  		 WITHOUT ACCEPTANCE epsilon=1 AND ACC=4pi·theta^2.
+ *  		 THE RADIAL INTEGRAL USES GAUSS-LEGENDRE PANELS AND THE AZIMUTHAL ONE A PERIODIC TRAPEZOID.
+ *  		 THE OFF REGIONS ARE THE ONES OF A JDBackgroundGeometry (ONE AT 2·wobble BY DEFAULT). THE PROFILE IS
+ *  		 SYMMETRIC AROUND THE SOURCE, SO EACH OFF REGION ONLY NEEDS ITS DISTANCE TO THE SOURCE AND ITS TILT:
+ *  		 ITS INTEGRAND SHARES epsilon(dcc) WITH THE ON ONE AND READS THE SAME PROFILE TABLE, AND THE REGIONS
+ *  		 ARE SUMMED IN THE SAME AZIMUTHAL LOOP. (1+alpha) IS THE VARIANCE OF THE BACKGROUND ESTIMATED IN THE M OFF
+ *  		 REGIONS (alpha=1/M, SEE JDBackgroundGeometry::GetQFactorScale()).
+ *
+ *  		 THE INTEGRALS ARE SHARED BETWEEN QFACTOR TYPES: ON AND OFF FOR EACH PROFILE, WITH AND WITHOUT
+ *  		 ACCEPTANCE, AND ACC (SEE GetComponents()). EvaluateRows() COMPUTES EACH OF THEM ONCE AND
+ *  		 COMBINES THEM FOR ALL THE QFACTORS OF A JDQFactorExpression.
+ *
+ *  		 ONE QFACTOR ALONE (Evaluate(), EvaluateRow()) USES A KERNEL SPECIALIZED AT COMPILE TIME FOR ITS
+ *  		 EFFECTS AND GEOMETRY (SEE GetSpecialization()): THE INNER LOOP HAS NO BRANCHES ON THE EFFECTS
+ *  		 AND ONLY COMPUTES THE ON, OFF AND ACC INTEGRALS THAT THE QFACTOR USES.
+ *
+ *  		 THE INTEGRAL OF EACH PANEL IS ADDED TO THE DISK WITH A COMPENSATED SUM (SEE JDReduction), SO THE ROUNDING OF
+ *  		 THE QFACTOR AT A THETA DOES NOT GROW WITH THE NUMBER OF PANELS SUMMED BEFORE IT. THE ROW SWEEP AND THE DIRECT
+ *  		 EVALUATION SPLIT THE DISK IN DIFFERENT PANELS, SO THEY STILL DIFFER BY THE QUADRATURE ERROR.
+ *  		 SetReductionMode(JDReduction::kFast) USES PLAIN SUMS INSTEAD.
+ *
+ *  		 THE VALUES ARE NOT THE ONES OF THE ORIGINAL TF2::Integral() OF JDOptimization, WHICH WERE ADAPTIVE WITH A
+ *  		 RELATIVE TOLERANCE OF 1e-2 (THE FIXED PANELS ARE CONVERGED FAR BELOW IT). THE DIFFERENCE HAS NOT BEEN
+ *  		 BOUNDED: BenchmarkQFactorKernels() OF exampleJDOptimization.cxx PRINTS IT FOR THE TYPE 3, THE ONLY ONE
+ *  		 WHOSE EXPRESSION DID NOT CHANGE. WHERE THE QFACTOR IS FLAT WITHIN IT THE OPTIMAL THETA AND WOBBLE CAN MOVE.
+ *  		 THE PROFILE IS ALSO 0 BEYOND ITS RANGE (SEE SetProfile()): THE TF1s EXTRAPOLATED THE TGraph LINEARLY, SO
+ *  		 OFF REGIONS REACHING PAST thetaMax GOT A LEAKAGE THAT COULD EVEN BE NEGATIVE.
+ */
+
+#ifndef JDQFactorKernel_H_
+#define JDQFactorKernel_H_
+
+#include "JDBackgroundGeometry.h"
+#include "JDEvalContext.h"
+#include "JDGrid.h"
+#include "JDQFactorExpression.h"
+#include "JDQuadrature.h"
+#include "JDReduction.h"
+
+#include <Rtypes.h>
+#include <TF1.h>
+
+class JDQFactorKernel {
+public:
+	// Effects of the QFactor: each digit of the QFactor type (see JDOptimization::GetListOfQFactors())
+	enum Effect {kLeakage=1, kUncertainty=2, kAcceptance=4, kSmearing=8};
+
+	// Integrals combined into the QFactors: ON and OFF of each profile (see GetProfileIndex()) without/with acceptance, and ACC
+	static const Int_t kNumComponents = 17;
+	static Int_t GetOnComponent(Int_t profileIndex, Bool_t isAcceptance)		{return 2*profileIndex+(isAcceptance? 1 : 0);}
+	static Int_t GetOffComponent(Int_t profileIndex, Bool_t isAcceptance)	{return 8+2*profileIndex+(isAcceptance? 1 : 0);}
+	static const Int_t kAccComponent = 16;
+
+	// A row swept in several steps (see ContinueRow()): its bins evaluated so far and the integrals over the disk up
+	// to the centre of the last one
+	class RowSweep {
+	public:
+		RowSweep(): iNumBins(0) {}
+		Int_t iNumBins;
+		JDNeumaierSum vSums[kNumComponents];
+	};
+
+	JDQFactorKernel();
+	virtual ~JDQFactorKernel() {}
+
+	static Int_t GetEffects(Int_t type);
+	static Int_t GetProfileIndex(Int_t effects)		{return ((effects&kUncertainty)? 1 : 0)+((effects&kSmearing)? 2 : 0);}
+	static Int_t GetComponents(Int_t effects);
+
+	void SetProfile(Int_t profileIndex, TF1* dNdOmega, Double_t thetaMax, Double_t step);
+	void SetProfile(Int_t profileIndex, const JDGrid1D& dNdOmega)		{gProfile[profileIndex]=dNdOmega;}
+	void SetEpsilon(TF1* epsilonVsDcc, Double_t dccMax, Double_t step);
+	void SetEpsilon(const JDGrid1D& epsilonVsDcc, Double_t dccMax)		{gEpsilon=epsilonVsDcc; dDccMax=dccMax;}
+	void SetIsSphericalCoordinates(Bool_t isSphericalCoordinates)		{bIsSphericalCoordinates=isSphericalCoordinates;}
+	void SetIsOnMinusOff(Bool_t isOnMinusOff);
+	void SetPanelWidth(Double_t panelWidth)								{dPanelWidth=panelWidth;}
+	void SetIsSpecialized(Bool_t isSpecialized)							{bIsSpecialized=isSpecialized;}
+	void SetReductionMode(Int_t reductionMode)							{iReductionMode=reductionMode;}
+	void SetBackgroundGeometry(const JDBackgroundGeometry& backgroundGeometry);
+
+	Bool_t GetIsProfile(Int_t profileIndex) const	{return !gProfile[profileIndex].IsEmpty();}
+	const JDGrid1D& GetProfile(Int_t profileIndex) const	{return gProfile[profileIndex];}
+	Bool_t GetIsEpsilon() const						{return !gEpsilon.IsEmpty();}
+	const JDGrid1D& GetEpsilon() const				{return gEpsilon;}
+	Double_t GetPanelWidth() const					{return dPanelWidth;}
+	Bool_t GetIsOnMinusOff() const					{return bIsOnMinusOff;}
+	Bool_t GetIsSpecialized() const					{return bIsSpecialized;}
+	Int_t GetReductionMode() const					{return iReductionMode;}
+	Int_t GetNumOffRegions() const					{return iNumOffRegions;}
+	Double_t GetQFactorScale() const				{return dQFactorScale;}
+
+	Double_t Evaluate(Int_t effects, Double_t theta, Double_t wobble) const;
+	void EvaluateRow(Int_t effects, Double_t wobble, const JDGridAxis& thetaAxis, Double_t* row, JDEvalContext& context) const;
+	void EvaluateRows(const JDQFactorExpression& expression, Double_t wobble, const JDGridAxis& thetaAxis, Double_t* const* rows, JDEvalContext& context) const;
+	void ContinueRow(Int_t effects, Double_t wobble, const JDGridAxis& thetaAxis, Int_t numBins, Double_t* row, RowSweep& sweep, JDEvalContext& context) const;
+
+private:
+	// Evaluation functions specialized for one effects and geometry
+	class Specialization {
+	public:
+		Double_t (JDQFactorKernel::*fEvaluate)(Double_t theta, Double_t wobble) const;
+		void (JDQFactorKernel::*fEvaluateRow)(Double_t wobble, const JDGridAxis& thetaAxis, Int_t firstBin, Int_t endBin, Double_t* row, JDNeumaierSum* diskSums) const;
+	};
+	static Specialization GetSpecialization(Int_t effects, Bool_t isSphericalCoordinates);
+	template<Int_t kEffects, Bool_t kSpherical> static Specialization GetSpecialization();
+
+	template<Int_t kEffects, Bool_t kSpherical> Double_t EvaluateSpecialized(Double_t theta, Double_t wobble) const;
+	template<Int_t kEffects, Bool_t kSpherical> void EvaluateRowSpecialized(Double_t wobble, const JDGridAxis& thetaAxis, Int_t firstBin, Int_t endBin, Double_t* row, JDNeumaierSum* diskSums) const;
+	template<Int_t kEffects, Bool_t kSpherical> void IntegrateShellSpecialized(Double_t thetaLow, Double_t thetaUp, Double_t wobble, Double_t* sums) const;
+	template<Int_t kEffects> Double_t GetQFactorSpecialized(Double_t theta, const Double_t* sums) const;
+
+	void SetExpressions();
+
+	void IntegrateShell(Int_t components, Double_t thetaLow, Double_t thetaUp, Double_t wobble, Double_t* sums) const;
+	void IntegrateDisk(Int_t components, Double_t theta, Double_t wobble, Double_t* sums) const;
+	void SweepDisk(Int_t components, Double_t wobble, const JDGridAxis& thetaAxis, Int_t firstBin, Int_t endBin, JDNeumaierSum* diskSums, Double_t* sums) const;
+	void AddPanel(const Double_t* panelSums, Int_t numSums, JDNeumaierSum* sums) const
+	{
+		for(Int_t c=0; c<numSums; c++) sums[c].Add(panelSums[c],iReductionMode);
+	}
+
+	Double_t GetEpsilon(Double_t dcc) const
+	{
+		if(dcc>dDccMax) return 1.e-20;							// To make integrals converge (as JDInstrument)
+		return gEpsilon.Interpolate(dcc);
+	}
+
+	static const Int_t kNumProfiles = 4;
+	static const Int_t kNumPhi = JDQuadrature::kNumPhi;
+	static const Int_t kNumEffects = 16;
+
+	// Expression of the QFactor of each effects, for the generic kernel (see SetExpressions())
+	JDQFactorExpression vExpressions[kNumEffects];
+
+	JDGrid1D gProfile[kNumProfiles];
+	JDGrid1D gEpsilon;
+	Double_t dDccMax;
+
+	JDAlignedBuffer vSinPhi;
+
+	// Distinct OFF regions of a pointing (see JDBackgroundGeometry): distance to the source [wobble], weight
+	// (alpha times their number) and cosine of the angle between the source and theta' seen from each region, per phi
+	static const Int_t kMaxNumOffRegions = (JDBackgroundGeometry::kMaxNumOffRegions+1)/2;
+	Int_t iNumOffRegions;
+	Double_t vOffDistance[kMaxNumOffRegions];
+	Double_t vOffWeight[kMaxNumOffRegions];
+	JDAlignedBuffer vOffCosAngle;		// kNumPhi per region
+	Double_t dQFactorScale;				// 1/Sqrt(1+alpha): background variance of the noise
+
+	Double_t dPanelWidth;
+	Double_t dDeg2Rad;
+	Bool_t bIsSphericalCoordinates;
+	Bool_t bIsOnMinusOff;
+	Bool_t bIsSpecialized;
+	Int_t iReductionMode;
+};
+
+#endif /* JDQFactorKernel_H_ */
@@ -0,0 +1,127 @@
+/*
+ * JDQFactorScan.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 STREAMED QFACTOR VS THETA AND WOBBLE.
+ */
+
+#include "JDQFactorScan.h"
+#include "JDEvalContext.h"
+#include "JDTaskScheduler.h"
+
+#include <vector>
+
+using namespace std;
+
+//-----------------------------------------------
+//	Scan of the QFactor of this type of optimization (nothing is computed until Start()).
+//	Without token, the scan can only be cancelled with Cancel() or from the callback of Run().
+JDQFactorScan::JDQFactorScan(JDOptimization* optimization, Int_t type, JDCancelToken* token):
+jdOptimization(optimization), iType(type), cancelToken(token),
+qRowsDone(0), iNumRowsReceived(0), bIsStarted(0), bIsAbandoned(0)
+{
+}
+
+//-----------------------------------------------
+//	It stops the rows not started yet and waits for the background thread
+JDQFactorScan::~JDQFactorScan()
+{
+	bIsAbandoned = 1;
+	if(tScan.joinable()) tScan.join();
+}
+
+//-----------------------------------------------
+//	It prepares the kernel of the type (serially: it touches ROOT objects) and starts computing the rows in a background
+//	thread. It returns 0 if the type is not valid.
+Bool_t JDQFactorScan::Start()
+{
+	if(bIsStarted) return 1;
+	if(!jdOptimization->PrepareQFactorKernel(iType)) return 0;
+
+	// the binning of JDOptimization::GetGridQFactorVsThetaWobble()
+	Double_t resolution = jdOptimization->GetBinResolution();		//[deg/bin]
+	Double_t thetaMax = jdOptimization->GetThetaMax();				// [deg]
+	Int_t numBinsX = thetaMax/resolution; 							// [#bins]
+	Double_t wobbleMax = jdOptimization->GetDistCameraCenterMax();	// [deg]
+	Int_t numBinsY = wobbleMax/resolution; 							// [#bins]
+	gridQFactor = JDGrid2D(JDGridAxis(numBinsX,0.,thetaMax),JDGridAxis(numBinsY,0.,wobbleMax));
+	vIsRowReceived.assign(gridQFactor.GetNumBinsY(),0);
+	iNumRowsReceived = 0;
+
+	bIsStarted = 1;
+	tScan = std::thread(&JDQFactorScan::Scan,this);
+	return 1;
+}
+
+//-----------------------------------------------
+//	Background thread: it computes the rows in parallel (see JDOptimization::EvaluateQFactorRow()), queueing each one as
+//	it ends, until all are done or the scan is cancelled
+void JDQFactorScan::Scan()
+{
+	const JDGridAxis& thetaAxis = gridQFactor.GetXaxis();
+	const JDGridAxis& wobbleAxis = gridQFactor.GetYaxis();
+
+	JDTaskScheduler scheduler(jdOptimization->GetNumThreads());
+	vector<JDEvalContext> contexts(scheduler.GetNumThreads());
+	scheduler.ParallelFor(wobbleAxis.GetNumBins(),[&](Int_t j, Int_t thread)
+	{
+		if(GetIsCancelled()) return;
+		jdOptimization->EvaluateQFactorRow(iType,wobbleAxis.GetBinCenter(j),thetaAxis,gridQFactor.GetRow(j),contexts[thread]);
+		qRowsDone.Push(j);
+	});
+	qRowsDone.Close();
+}
+
+//-----------------------------------------------
+//	It waits for the next row computed (starting the scan if needed). It returns 0 once all the rows have been received
+//	or, after a cancellation, the rows that were running.
+Bool_t JDQFactorScan::Next(Row& row)
+{
+	if(!Start()) return 0;
+
+	Int_t j;
+	if(!qRowsDone.Pop(j))
+	{
+		if(tScan.joinable()) tScan.join();
+		return 0;
+	}
+
+	vIsRowReceived[j] = 1;
+	iNumRowsReceived++;
+	row.iWobbleBin = j;
+	row.dWobble = gridQFactor.GetYaxis().GetBinCenter(j);
+	row.qFactors = gridQFactor.GetRow(j);
+	row.iNumThetaBins = gridQFactor.GetNumBinsX();
+	return 1;
+}
+
+//-----------------------------------------------
+//	It gives every row to callback as it is computed (on the caller thread). If it returns 0 the scan is cancelled (see
+//	Cancel(): the token is not), and the rows that were running are received but not given to it. It returns 1 if the
+//	whole grid was computed.
+Bool_t JDQFactorScan::Run(const RowCallback& callback)
+{
+	Bool_t isStopped = 0;
+	Row row;
+	while(Next(row))
+	{
+		if(isStopped) continue;
+		if(!callback(row))
+		{
+			Cancel();
+			isStopped = 1;
+		}
+	}
+	return GetIsComplete();
+}
+
+#ifdef JD_WITH_COROUTINES
+//-----------------------------------------------
+//	The rows as a C++20 generator: each step of the loop waits for the next row computed (see Next())
+JDGenerator<JDQFactorScan::Row> JDQFactorScan::Rows()
+{
+	Row row;
+	while(Next(row)) co_yield row;
+}
+#endif
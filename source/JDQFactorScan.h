@@ -0,0 +1,86 @@
+/*
+ * JDQFactorScan.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 STREAMED QFACTOR VS THETA AND WOBBLE: THE SAME GRID AS JDOptimization::GetGridQFactorVsThetaWobble(), BUT
+ *  		 GIVEN ROW BY ROW (ONE WOBBLE BIN, ALL THE THETA BINS) AS SOON AS EACH ROW IS COMPUTED, SO THAT A DASHBOARD
+ *  		 CAN SHOW THE PARTIAL SURFACE AND AN INTERACTIVE TOOL CAN STOP ONCE THE OPTIMUM IS BRACKETED.
+ *  		 Start() PREPARES THE KERNEL (IT TOUCHES ROOT, ON THE CALLER) AND COMPUTES THE ROWS IN A BACKGROUND THREAD
+ *  		 (WITH THE THREADS OF THE JDOptimization, SEE JDTaskScheduler). THE ROWS ARE RECEIVED ON THE CALLER, IN THE
+ *  		 ORDER THEY END (NOT IN WOBBLE ORDER), IN ONE OF THREE WAYS:
+ *  		 	Next():		while(scan.Next(row)) {...}
+ *  		 	Run():		A CALLBACK FOR EACH ROW; IT CANCELS THE SCAN BY RETURNING 0
+ *  		 	Rows():		for(const JDQFactorScan::Row& row : scan.Rows()) {...} (ONLY WITH C++20 COROUTINES, SEE JDGenerator)
+ *  		 Cancel(), OR A JDCancelToken (ITS Cancel() OR A DEADLINE), STOPS THE SCAN AFTER THE ROWS ALREADY RUNNING: THE
+ *  		 OTHER ROWS ARE LEFT AT 0 AND GetIsComplete() IS 0. THE SCAN NEVER CANCELS THE TOKEN (IT MAY BE SHARED).
+ *  		 THE JDOptimization MUST NOT BE CHANGED WHILE THE SCAN IS RUNNING.
+ */
+
+#ifndef JDQFactorScan_H_
+#define JDQFactorScan_H_
+
+#include "JDBoundedQueue.h"
+#include "JDCancelToken.h"
+#include "JDGenerator.h"
+#include "JDGrid.h"
+#include "JDOptimization.h"
+
+#include <Rtypes.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+class JDQFactorScan {
+public:
+	// One wobble bin of the grid: iNumThetaBins QFactors, not normalized (see GetGrid())
+	class Row {
+	public:
+		Int_t iWobbleBin;
+		Double_t dWobble;						// [deg]
+		const Double_t* qFactors;
+		Int_t iNumThetaBins;
+	};
+	// It returns 0 to cancel the scan
+	typedef std::function<Bool_t(const Row&)> RowCallback;
+
+	// token: NULL if the scan is only cancelled with Cancel()
+	JDQFactorScan(JDOptimization* optimization, Int_t type=0, JDCancelToken* token=NULL);
+	virtual ~JDQFactorScan();
+
+	Bool_t Start();
+	Bool_t Next(Row& row);
+	Bool_t Run(const RowCallback& callback);
+#ifdef JD_WITH_COROUTINES
+	JDGenerator<Row> Rows();
+#endif
+
+	// It stops this scan only, not the other users of the token
+	void Cancel()								{bIsAbandoned=1;}
+	Bool_t GetIsCancelled()						{return bIsAbandoned || (cancelToken && cancelToken->IsCancelled());}
+
+	// The grid of QFactors, with the rows received so far (the others are 0)
+	const JDGrid2D& GetGrid()					{return gridQFactor;}
+	Int_t GetNumRows()							{return gridQFactor.GetNumBinsY();}
+	Int_t GetNumRowsReceived()					{return iNumRowsReceived;}
+	Bool_t GetIsRowReceived(Int_t wobbleBin)	{return vIsRowReceived[wobbleBin];}
+	Bool_t GetIsComplete()						{return iNumRowsReceived==GetNumRows();}
+
+private:
+	void Scan();
+
+	JDOptimization* jdOptimization;
+	Int_t iType;
+	JDCancelToken* cancelToken;
+
+	JDGrid2D gridQFactor;
+	JDBoundedQueue<Int_t> qRowsDone;			// wobble bins computed and not received yet
+	std::vector<Bool_t> vIsRowReceived;
+	Int_t iNumRowsReceived;
+	Bool_t bIsStarted;
+	std::atomic<Bool_t> bIsAbandoned;			// cancelled (see Cancel()) or destroyed before the end
+	std::thread tScan;
+};
+
+#endif /* JDQFactorScan_H_ */
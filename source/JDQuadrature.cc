@@ -0,0 +1,13 @@
+/*
+ * JDQuadrature.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 FIXED QUADRATURE OVER THE DISK OF RADIUS theta.
+ */
+
+#include "JDQuadrature.h"
+
+// 4-point Gauss-Legendre nodes and weights on [-1,1]
+const Double_t JDQuadrature::kGaussNodes[JDQuadrature::kNumGaussNodes] = {-0.8611363115940526, -0.3399810435848563, 0.3399810435848563, 0.8611363115940526};
+const Double_t JDQuadrature::kGaussWeights[JDQuadrature::kNumGaussNodes] = {0.3478548451374538, 0.6521451548625461, 0.6521451548625461, 0.3478548451374538};
@@ -0,0 +1,51 @@
+/*
+ * JDQuadrature.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 FIXED QUADRATURE OVER THE DISK OF RADIUS theta: GAUSS-LEGENDRE PANELS IN theta' AND A PERIODIC TRAPEZOID
+ *  		 IN phi (THE SAME AS JDQFactorKernel). IT DOES NOT KEEP ANY STATE, SO IT CAN BE CALLED FROM MANY THREADS
+ *  		 AT THE SAME TIME WITH CONST INTEGRANDS (SEE THE Evaluate FUNCTIONS OF JDAstroProfile, JDInstrument AND
+ *  		 JDOptimization).
+ */
+
+#ifndef JDQuadrature_H_
+#define JDQuadrature_H_
+
+#include <Rtypes.h>
+#include <TMath.h>
+
+class JDQuadrature {
+public:
+	static const Int_t kNumGaussNodes = 4;
+	static const Double_t kGaussNodes[kNumGaussNodes];		// on [-1,1]
+	static const Double_t kGaussWeights[kNumGaussNodes];
+	static const Int_t kNumPhi = 64;
+
+	//	int_0^theta dtheta' int_0^2pi dphi integrand(theta',phi)·Sin(theta') (or ·theta' if not spherical),
+	//	with theta, theta' [deg], phi [rad] and panels of at most panelWidth [deg]
+	template<class Integrand>
+	static Double_t IntegrateDisk(const Integrand& integrand, Double_t theta, Double_t panelWidth, Bool_t isSphericalCoordinates)
+	{
+		Int_t numPanels = TMath::Max(1,TMath::CeilNint(theta/panelWidth));
+		Double_t halfWidth = 0.5*theta/numPanels;
+		Double_t dPhi = 2*TMath::Pi()/kNumPhi;
+		Double_t deg2Rad = TMath::Pi()/180.;
+
+		Double_t sum = 0.;
+		for(Int_t p=0; p<numPanels; p++)
+		{
+			Double_t middle = (2*p+1)*halfWidth;
+			for(Int_t g=0; g<kNumGaussNodes; g++)
+			{
+				Double_t thetaNode = middle+halfWidth*kGaussNodes[g];
+				Double_t sumPhi = 0.;
+				for(Int_t m=0; m<kNumPhi; m++) sumPhi += integrand(thetaNode,m*dPhi);
+				sum += halfWidth*kGaussWeights[g]*dPhi*(isSphericalCoordinates? TMath::Sin(thetaNode*deg2Rad) : thetaNode)*sumPhi;
+			}
+		}
+		return sum;
+	}
+};
+
+#endif /* JDQuadrature_H_ */
@@ -0,0 +1,51 @@
+/*
+ * JDReduction.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 COMPENSATED SUMS. A PLAIN SUM OF n TERMS HAS A ROUNDING ERROR THAT GROWS WITH n AND DEPENDS ON THE ORDER OF
+ *  		 THE TERMS. JDNeumaierSum IS A COMPENSATED (KAHAN-BABUSKA-NEUMAIER) RUNNING SUM: ITS ERROR DOES NOT GROW WITH
+ *  		 n, SO THE PANELS OF THE RADIAL SWEEPS OF JDQFactorKernel ADD UP THE SAME WHATEVER THE NUMBER SUMMED BEFORE.
+ *  		 IT ONLY REMOVES ROUNDING: AN INTEGRAL SPLIT IN DIFFERENT PANELS (THE ROW SWEEP AND ONE DISK AT A TIME, FOR
+ *  		 EXAMPLE) HAS DIFFERENT QUADRATURE NODES, AND THAT DISCRETIZATION DIFFERENCE, FAR ABOVE THE ROUNDING, STAYS.
+ *  		 kFast SELECTS THE PLAIN SUMS INSTEAD (FASTER, BUT ORDER DEPENDENT).
+ */
+
+#ifndef JDReduction_H_
+#define JDReduction_H_
+
+#include <Rtypes.h>
+#include <TMath.h>
+#include <TString.h>
+
+class JDReduction {
+public:
+	enum Mode {kDeterministic=0, kFast=1};
+
+	static TString GetModeName(Int_t mode)		{return (mode==kFast? "fast" : "deterministic");}
+};
+
+//-----------------------------------------------
+//	Compensated running sum: the low-order bits lost by each addition are kept apart and added at the end
+class JDNeumaierSum {
+public:
+	JDNeumaierSum(): dSum(0.), dCompensation(0.) {}
+
+	void Reset()								{dSum=0.; dCompensation=0.;}
+	void Add(Double_t value)
+	{
+		Double_t sum = dSum+value;
+		if(TMath::Abs(dSum)>=TMath::Abs(value))	dCompensation += (dSum-sum)+value;
+		else									dCompensation += (value-sum)+dSum;
+		dSum = sum;
+	}
+	void Add(Double_t value, Int_t mode)		{if(mode==JDReduction::kFast) dSum+=value; else Add(value);}
+
+	Double_t GetSum() const						{return dSum+dCompensation;}
+
+private:
+	Double_t dSum;
+	Double_t dCompensation;
+};
+
+#endif /* JDReduction_H_ */
@@ -0,0 +1,80 @@
+/*
+ * JDResultBuffers.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 RESULTS OF MANY PRODUCER THREADS GATHERED BY ONE CONSUMER THREAD WITHOUT LOCKS (SEE JDCampaign).
+ *  		 EACH PRODUCER HAS A RING BUFFER OF ITS OWN (SINGLE PRODUCER, SINGLE CONSUMER) ON CACHE LINES OF ITS OWN:
+ *  		 Push() ONLY TOUCHES THE RING OF ITS THREAD, SO THE PRODUCERS NEVER WAIT FOR EACH OTHER, WHATEVER THEIR
+ *  		 NUMBER, AND Drain() TAKES ALL THE ITEMS WAITING IN ALL THE RINGS IN ONE PASS (A BATCH).
+ *  		 A PRODUCER ONLY WAITS IF ITS RING IS FULL, UNTIL THE CONSUMER DRAINS IT.
+ */
+
+#ifndef JDResultBuffers_H_
+#define JDResultBuffers_H_
+
+#include "JDGrid.h"
+
+#include <Rtypes.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+template <typename T>
+class JDResultBuffers {
+public:
+	// capacity: items of each ring (rounded up to a power of 2)
+	JDResultBuffers(Int_t numProducers, Int_t capacity=256): vRings(numProducers>0? numProducers : 1)
+	{
+		UInt_t size = 1;
+		while((Int_t)size<capacity) size*=2;
+		for(UInt_t p=0; p<vRings.size(); p++) vRings[p].vItems.resize(size);
+	}
+
+	//-----------------------------------------------
+	//	It adds item to the ring of producer. Only the thread of producer can call it.
+	void Push(Int_t producer, const T& item)
+	{
+		Ring& ring = vRings[producer];
+		UInt_t tail = ring.iTail.load(std::memory_order_relaxed);
+		while(tail-ring.iHead.load(std::memory_order_acquire)>=ring.vItems.size()) std::this_thread::yield();
+		ring.vItems[tail&(ring.vItems.size()-1)] = item;
+		ring.iTail.store(tail+1,std::memory_order_release);
+	}
+
+	//-----------------------------------------------
+	//	It gives consume(item) all the items waiting, ring after ring (in the order of each producer).
+	//	Only one thread (the consumer) can call it. It returns the number of items.
+	template <typename Consumer>
+	Int_t Drain(Consumer consume)
+	{
+		Int_t numItems = 0;
+		for(UInt_t p=0; p<vRings.size(); p++)
+		{
+			Ring& ring = vRings[p];
+			UInt_t head = ring.iHead.load(std::memory_order_relaxed);
+			UInt_t tail = ring.iTail.load(std::memory_order_acquire);
+			for(; head!=tail; head++, numItems++) consume(ring.vItems[head&(ring.vItems.size()-1)]);
+			ring.iHead.store(head,std::memory_order_release);
+		}
+		return numItems;
+	}
+
+	Int_t GetNumProducers() const				{return vRings.size();}
+
+private:
+	// The indices grow forever (modulo 2^32): the item of index i is at i&(size-1)
+	class alignas(kJDCacheLineSize) Ring {
+	public:
+		Ring(): iHead(0), iTail(0) {}
+
+		std::vector<T> vItems;
+		alignas(kJDCacheLineSize) std::atomic<UInt_t> iHead;	// next item to drain (written by the consumer)
+		alignas(kJDCacheLineSize) std::atomic<UInt_t> iTail;	// next item to push (written by the producer)
+	};
+
+	std::vector<Ring> vRings;
+};
+
+#endif /* JDResultBuffers_H_ */
@@ -0,0 +1,339 @@
+/*
+ * JDSurfaceStore.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 LOCAL STORE OF QFACTOR SURFACES, TABLES AND OPTIMAL POINTS.
+ */
+
+#include "JDSurfaceStore.h"
+
+#include <TMath.h>
+#include <TSystem.h>
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Header of the binary files: surfaces, tables (see SaveTable()) and partial surfaces (see SavePartialSurface())
+static const char kSurfaceMagic[4] = {'J','D','S','S'};
+static const char kTableMagic[4] = {'J','D','S','T'};
+static const char kPartialSurfaceMagic[4] = {'J','D','S','P'};
+static const Int_t kSurfaceVersion = 2;		// 2: QFactors with the (1+alpha) of the background
+
+//-----------------------------------------------
+//	It writes the header of a binary file: magic, version and configuration
+static void WriteHeader(ofstream& file, const char* magic, const TString& configuration)
+{
+	Int_t length = configuration.Length();
+	file.write(magic,4);
+	file.write((const char*)&kSurfaceVersion,sizeof(Int_t));
+	file.write((const char*)&length,sizeof(Int_t));
+	file.write(configuration.Data(),length);
+}
+
+//-----------------------------------------------
+//	It reads the header of a binary file. It returns 0 if it is not of this kind (magic) or of this configuration.
+static Bool_t ReadHeader(ifstream& file, const char* magic, const TString& configuration)
+{
+	char storedMagic[4];
+	Int_t version = 0;
+	Int_t length = 0;
+	file.read(storedMagic,4);
+	file.read((char*)&version,sizeof(Int_t));
+	file.read((char*)&length,sizeof(Int_t));
+	if(!file || storedMagic[0]!=magic[0] || storedMagic[1]!=magic[1] || storedMagic[2]!=magic[2] || storedMagic[3]!=magic[3] ||
+	   version!=kSurfaceVersion || length!=configuration.Length()) return 0;
+
+	string storedConfiguration(length,' ');
+	file.read(&storedConfiguration[0],length);
+	return (file && storedConfiguration==configuration.Data());
+}
+
+//-----------------------------------------------
+//	It writes (reads) an axis: number of bins, minimum and maximum
+static void WriteAxis(ofstream& file, const JDGridAxis& axis)
+{
+	Int_t numBins = axis.GetNumBins();
+	Double_t min = axis.GetMin();
+	Double_t max = axis.GetMax();
+	file.write((const char*)&numBins,sizeof(Int_t));
+	file.write((const char*)&min,sizeof(Double_t));
+	file.write((const char*)&max,sizeof(Double_t));
+}
+static Bool_t ReadAxis(ifstream& file, JDGridAxis& axis)
+{
+	Int_t numBins;
+	Double_t min, max;
+	file.read((char*)&numBins,sizeof(Int_t));
+	file.read((char*)&min,sizeof(Double_t));
+	file.read((char*)&max,sizeof(Double_t));
+	if(!file || numBins<=0) return 0;
+	axis = JDGridAxis(numBins,min,max);
+	return 1;
+}
+
+//-----------------------------------------------
+//	It uses (and creates if needed) the directory path
+JDSurfaceStore::JDSurfaceStore(TString path):
+sPath(path)
+{
+	gSystem->mkdir(sPath, kTRUE);
+}
+
+//-----------------------------------------------
+//	64-bit FNV-1a hash of the configuration
+ULong64_t JDSurfaceStore::GetHash(const TString& configuration)
+{
+	return GetHash(configuration.Data(),configuration.Length());
+}
+
+//-----------------------------------------------
+//	64-bit FNV-1a hash of numBytes bytes of data, going on from hash (to hash several arrays as one)
+ULong64_t JDSurfaceStore::GetHash(const void* data, Long64_t numBytes, ULong64_t hash)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for(Long64_t b=0; b<numBytes; b++)
+	{
+		hash ^= bytes[b];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+//-----------------------------------------------
+//	File of the surface (extension "jds"), table ("jdt") or partial surface ("jdp") with this hash
+TString JDSurfaceStore::GetFile(ULong64_t hash, const char* extension) const
+{
+	return sPath+TString::Format("/%016llx.%s",(unsigned long long)hash,extension);
+}
+
+//-----------------------------------------------
+//	It returns a new temporary file where fileName is written before renaming it (see CloseFile()), so that readers
+//	never see it half written. The name is unique in this process (the stores of several threads can write the same
+//	file at the same time) and among the processes sharing the path.
+TString JDSurfaceStore::GetTemporaryFile(const TString& fileName)
+{
+	static std::atomic<ULong64_t> numTemporaryFiles(0);
+	return fileName+TString::Format(".%d.%llu.tmp",gSystem->GetPid(),(unsigned long long)numTemporaryFiles++);
+}
+
+//-----------------------------------------------
+//	It closes the temporary file and renames it to fileName. It returns 0 (removing it) if it could not be written.
+Bool_t JDSurfaceStore::CloseFile(ofstream& file, const TString& temporaryFileName, const TString& fileName)
+{
+	file.close();
+	if(!file || gSystem->Rename(temporaryFileName,fileName)!=0)
+	{
+		gSystem->Unlink(temporaryFileName);
+		return 0;
+	}
+	return 1;
+}
+
+//-----------------------------------------------
+//	It returns the surface stored for this configuration, or NULL if there is none (or it was stored for another
+//	configuration with the same hash). The caller owns the surface.
+JDGrid2D* JDSurfaceStore::LoadSurface(const TString& configuration)
+{
+	ifstream file(GetFile(GetHash(configuration),"jds"), ios::binary);
+	if(!file.is_open() || !ReadHeader(file,kSurfaceMagic,configuration)) return NULL;
+
+	JDGridAxis axisX, axisY;
+	if(!ReadAxis(file,axisX) || !ReadAxis(file,axisY)) return NULL;
+
+	JDGrid2D* surface = new JDGrid2D(axisX,axisY);
+	file.read((char*)surface->GetArray(),sizeof(Double_t)*surface->GetSize());
+	if(!file)
+	{
+		delete surface;
+		return NULL;
+	}
+	return surface;
+}
+
+//-----------------------------------------------
+//	It stores the surface of this configuration and adds it to the index (a partial surface of it, if any, is removed).
+//	It returns 0 if it could not be written.
+Bool_t JDSurfaceStore::SaveSurface(const TString& configuration, const JDGrid2D& surface)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	ULong64_t hash = GetHash(configuration);
+	TString fileName = GetFile(hash,"jds");
+
+	TString temporaryFileName = GetTemporaryFile(fileName);
+	ofstream file(temporaryFileName, ios::binary);
+	if(!file.is_open())
+	{
+		cout << "   *****************************************" << endl;
+		cout << "   ***                                   ***" << endl;
+		cout << "   ***  WARNING:                         ***" << endl;
+		cout << "   ***  the surface could not be stored  ***" << endl;
+		cout << "   ***                                   ***" << endl;
+		cout << "   *****************************************" << endl;
+		return 0;
+	}
+
+	WriteHeader(file,kSurfaceMagic,configuration);
+	WriteAxis(file,surface.GetXaxis());
+	WriteAxis(file,surface.GetYaxis());
+	file.write((const char*)surface.GetArray(),sizeof(Double_t)*surface.GetSize());
+	if(!CloseFile(file,temporaryFileName,fileName)) return 0;
+	gSystem->Unlink(GetFile(hash,"jdp"));
+
+	// one write per line (see SaveOptimum())
+	ofstream index(sPath+"/index.txt", ios::app);
+	index << TString::Format("%016llx ",(unsigned long long)hash)+configuration+"\n" << flush;
+	return 1;
+}
+
+//-----------------------------------------------
+//	It returns the table (a sampled function, see JDOptimization::InitQFactorKernel()) stored for this configuration,
+//	or NULL if there is none. The caller owns the table.
+JDGrid1D* JDSurfaceStore::LoadTable(const TString& configuration)
+{
+	ifstream file(GetFile(GetHash(configuration),"jdt"), ios::binary);
+	if(!file.is_open() || !ReadHeader(file,kTableMagic,configuration)) return NULL;
+
+	JDGridAxis axis;
+	if(!ReadAxis(file,axis)) return NULL;
+
+	JDGrid1D* table = new JDGrid1D(axis);
+	file.read((char*)table->GetArray(),sizeof(Double_t)*table->GetNumBins());
+	if(!file)
+	{
+		delete table;
+		return NULL;
+	}
+	return table;
+}
+
+//-----------------------------------------------
+//	It stores the table of this configuration and adds it to the index. It returns 0 if it could not be written.
+Bool_t JDSurfaceStore::SaveTable(const TString& configuration, const JDGrid1D& table)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	ULong64_t hash = GetHash(configuration);
+	TString fileName = GetFile(hash,"jdt");
+
+	TString temporaryFileName = GetTemporaryFile(fileName);
+	ofstream file(temporaryFileName, ios::binary);
+	if(!file.is_open()) return 0;
+
+	WriteHeader(file,kTableMagic,configuration);
+	WriteAxis(file,table.GetXaxis());
+	file.write((const char*)table.GetArray(),sizeof(Double_t)*table.GetNumBins());
+	if(!CloseFile(file,temporaryFileName,fileName)) return 0;
+
+	ofstream index(sPath+"/index.txt", ios::app);
+	index << TString::Format("%016llx ",(unsigned long long)hash)+configuration+"\n" << flush;
+	return 1;
+}
+
+//-----------------------------------------------
+//	It returns the partial surface (see SavePartialSurface()) stored for this configuration, with the rows (wobble bins)
+//	already computed in isRowDone, or NULL if there is none. The caller owns the surface.
+JDGrid2D* JDSurfaceStore::LoadPartialSurface(const TString& configuration, std::vector<Bool_t>& isRowDone)
+{
+	ifstream file(GetFile(GetHash(configuration),"jdp"), ios::binary);
+	if(!file.is_open() || !ReadHeader(file,kPartialSurfaceMagic,configuration)) return NULL;
+
+	JDGridAxis axisX, axisY;
+	if(!ReadAxis(file,axisX) || !ReadAxis(file,axisY)) return NULL;
+
+	std::vector<char> rows(axisY.GetNumBins());
+	file.read(rows.data(),rows.size());
+	JDGrid2D* surface = new JDGrid2D(axisX,axisY);
+	file.read((char*)surface->GetArray(),sizeof(Double_t)*surface->GetSize());
+	if(!file)
+	{
+		delete surface;
+		return NULL;
+	}
+	isRowDone.assign(rows.begin(),rows.end());
+	return surface;
+}
+
+//-----------------------------------------------
+//	It stores the surface of this configuration being computed: only the rows (wobble bins) with isRowDone are valid.
+//	It is a checkpoint: it replaces the previous one, and SaveSurface() removes it. It returns 0 if it could not be written.
+Bool_t JDSurfaceStore::SavePartialSurface(const TString& configuration, const JDGrid2D& surface, const std::vector<Bool_t>& isRowDone)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	TString fileName = GetFile(GetHash(configuration),"jdp");
+	TString temporaryFileName = GetTemporaryFile(fileName);
+	ofstream file(temporaryFileName, ios::binary);
+	if(!file.is_open()) return 0;
+
+	std::vector<char> rows(isRowDone.begin(),isRowDone.end());
+	WriteHeader(file,kPartialSurfaceMagic,configuration);
+	WriteAxis(file,surface.GetXaxis());
+	WriteAxis(file,surface.GetYaxis());
+	file.write(rows.data(),rows.size());
+	file.write((const char*)surface.GetArray(),sizeof(Double_t)*surface.GetSize());
+	return CloseFile(file,temporaryFileName,fileName);
+}
+
+//-----------------------------------------------
+//	It looks for the optimal point of this configuration found with this mode (see JDOptimization::OptimizationMode)
+//	and tolerance, and copies its kNumOptimumValues values into optimum. It returns 0 if there is none.
+Bool_t JDSurfaceStore::LoadOptimum(const TString& configuration, Int_t mode, Double_t tolerance, Double_t* optimum)
+{
+	ifstream file(sPath+"/optima.txt");
+	if(!file.is_open()) return 0;
+
+	string hash = TString::Format("%016llx",(unsigned long long)GetHash(configuration)).Data();
+
+	// the last line of the configuration wins
+	Bool_t isFound = 0;
+	string line;
+	while(getline(file,line))
+	{
+		istringstream stream(line);
+		string storedHash;
+		Int_t storedMode;
+		Double_t storedTolerance;
+		Double_t values[kNumOptimumValues];
+		if(!(stream >> storedHash >> storedMode >> storedTolerance)) continue;
+		if(storedHash!=hash || storedMode!=mode || TMath::Abs(storedTolerance-tolerance)>1e-9) continue;
+
+		Int_t v=0;
+		while(v<kNumOptimumValues && stream >> values[v]) v++;
+		if(v<kNumOptimumValues) continue;
+
+		// the configuration is the rest of the line: another one with the same hash is not taken
+		string storedConfiguration;
+		stream.get();
+		getline(stream,storedConfiguration);
+		if(storedConfiguration!=configuration.Data()) continue;
+
+		for(v=0; v<kNumOptimumValues; v++) optimum[v]=values[v];
+		isFound = 1;
+	}
+	return isFound;
+}
+
+//-----------------------------------------------
+//	It stores the optimal point (kNumOptimumValues values) of this configuration, mode and tolerance
+Bool_t JDSurfaceStore::SaveOptimum(const TString& configuration, Int_t mode, Double_t tolerance, const Double_t* optimum)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	ofstream file(sPath+"/optima.txt", ios::app);
+	if(!file.is_open()) return 0;
+
+	// one write per line, so that lines of several processes (or stores sharing the path) do not mix
+	TString line = TString::Format("%016llx %d %.10g",(unsigned long long)GetHash(configuration),mode,tolerance);
+	for(Int_t v=0; v<kNumOptimumValues; v++) line += TString::Format(" %.17g",optimum[v]);
+	line += " "+configuration+"\n";
+	file << line << flush;
+	return 1;
+}
@@ -0,0 +1,65 @@
+/*
+ * JDSurfaceStore.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 LOCAL STORE OF QFACTOR SURFACES (NOT NORMALIZED QFACTOR VS THETA AND WOBBLE) AND OPTIMAL POINTS.
+ *  		 EVERYTHING IS KEYED BY THE CONFIGURATION THAT PRODUCED IT (A TEXT WITH SOURCE, AUTHOR, CANDIDATE,
+ *  		 INSTRUMENT, RANGES, RESOLUTION, QFACTOR TYPE...; SEE JDOptimization::GetConfiguration()).
+ *  		 THE FILES ARE NAMED BY THE 64-BIT FNV-1a HASH OF THE CONFIGURATION:
+ *  		 	<path>/<hash>.jds		BINARY SURFACE (IT ALSO KEEPS THE CONFIGURATION, CHECKED WHEN LOADING)
+ *  		 	<path>/<hash>.jdt		BINARY TABLE: A PROFILE OR ACCEPTANCE SAMPLED (AND SMEARED) FOR THE QFACTOR KERNEL
+ *  		 	<path>/<hash>.jdp		BINARY PARTIAL SURFACE: THE LAST CHECKPOINT OF A SURFACE BEING COMPUTED, WITH ITS ROWS DONE
+ *  		 	<path>/index.txt		ONE LINE PER SURFACE OR TABLE: <hash> <configuration>
+ *  		 	<path>/optima.txt		ONE LINE PER OPTIMAL POINT: <hash> <mode> <tolerance> <qfactorMax> <theta...> <wobble...> <configuration>
+ *  		 THE SURFACES ARE NOT NORMALIZED, SO THEY ARE REUSED FOR ANY NORMALIZATION AND TOLERANCE.
+ */
+
+#ifndef JDSurfaceStore_H_
+#define JDSurfaceStore_H_
+
+#include "JDGrid.h"
+
+#include <Rtypes.h>
+#include <TString.h>
+
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+class JDSurfaceStore {
+public:
+	// Values of an optimal point: qfactorMax, thetaOpt, thetaOptRangMin, thetaOptRangMax, wobbleOpt, wobbleOptRangMin, wobbleOptRangMax
+	static const Int_t kNumOptimumValues = 7;
+
+	JDSurfaceStore(TString path);
+	virtual ~JDSurfaceStore() {}
+
+	TString GetPath() const						{return sPath;}
+
+	static const ULong64_t kHashOffsetBasis = 14695981039346656037ULL;
+	static ULong64_t GetHash(const TString& configuration);
+	static ULong64_t GetHash(const void* data, Long64_t numBytes, ULong64_t hash=kHashOffsetBasis);
+
+	JDGrid2D* LoadSurface(const TString& configuration);
+	Bool_t SaveSurface(const TString& configuration, const JDGrid2D& surface);
+
+	JDGrid1D* LoadTable(const TString& configuration);
+	Bool_t SaveTable(const TString& configuration, const JDGrid1D& table);
+
+	JDGrid2D* LoadPartialSurface(const TString& configuration, std::vector<Bool_t>& isRowDone);
+	Bool_t SavePartialSurface(const TString& configuration, const JDGrid2D& surface, const std::vector<Bool_t>& isRowDone);
+
+	Bool_t LoadOptimum(const TString& configuration, Int_t mode, Double_t tolerance, Double_t* optimum);
+	Bool_t SaveOptimum(const TString& configuration, Int_t mode, Double_t tolerance, const Double_t* optimum);
+
+private:
+	TString GetFile(ULong64_t hash, const char* extension) const;
+	static TString GetTemporaryFile(const TString& fileName);
+	static Bool_t CloseFile(std::ofstream& file, const TString& temporaryFileName, const TString& fileName);
+
+	TString sPath;
+	std::mutex mMutex;		// serializes the writes of this store
+};
+
+#endif /* JDSurfaceStore_H_ */
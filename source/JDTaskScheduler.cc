@@ -0,0 +1,243 @@
+/*
+ * JDTaskScheduler.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 WORK-STEALING SCHEDULER OF A FIXED SET OF WORKER THREADS.
+ */
+
+#include "JDTaskScheduler.h"
+
+#include <TMath.h>
+#include <TString.h>
+
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+//-----------------------------------------------
+//	It starts numThreads-1 workers, the caller of ParallelFor() being the worker 0
+//	(numThreads<=0: one per hardware thread; 1: none, the tasks run on the caller)
+JDTaskScheduler::JDTaskScheduler(Int_t numThreads, Int_t grainSize):
+iNumThreads(numThreads>0? numThreads : GetDefaultNumThreads()), iGrainSize(grainSize>0? grainSize : 1), vWorkers(iNumThreads),
+fTask(NULL), iNumPending(0), iNumQueued(0), iNumActive(0), iGeneration(0), bStop(0), dRealTime(0.)
+{
+	for(Int_t thread=1; thread<iNumThreads; thread++)
+	{
+		vThreads.push_back(std::thread(&JDTaskScheduler::Work,this,thread));
+	}
+}
+
+//-----------------------------------------------
+//	It stops and joins the workers
+JDTaskScheduler::~JDTaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		bStop=1;
+	}
+	cvStart.notify_all();
+
+	for(UInt_t thread=0; thread<vThreads.size(); thread++) vThreads[thread].join();
+}
+
+//-----------------------------------------------
+//	It returns the number of hardware threads (at least 1)
+Int_t JDTaskScheduler::GetDefaultNumThreads()
+{
+	Int_t numThreads = std::thread::hardware_concurrency();
+	return (numThreads>0? numThreads : 1);
+}
+
+//-----------------------------------------------
+//	It runs task(index, thread) for every index in [0, numTasks) and waits until all of them are done
+void JDTaskScheduler::ParallelFor(Int_t numTasks, const Task& task)
+{
+	std::lock_guard<std::mutex> runLock(mRunMutex);
+	for(Int_t thread=0; thread<iNumThreads; thread++)
+	{
+		vWorkers[thread].dBusyTime = 0.;
+		vWorkers[thread].iNumTasks = 0;
+		vWorkers[thread].iNumSteals = 0;
+	}
+	dRealTime = 0.;
+	if(numTasks<=0) return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if(vThreads.size()==0)
+	{
+		for(Int_t index=0; index<numTasks; index++) task(index,0);
+		dRealTime = std::chrono::duration<Double_t>(std::chrono::steady_clock::now()-start).count();
+		vWorkers[0].dBusyTime = dRealTime;
+		vWorkers[0].iNumTasks = numTasks;
+		return;
+	}
+
+	// one contiguous range per worker (nobody is running yet)
+	iNumPending = numTasks;
+	iNumQueued = 0;
+	for(Int_t thread=0; thread<iNumThreads; thread++)
+	{
+		Range range;
+		range.iBegin = (Long64_t)numTasks*thread/iNumThreads;
+		range.iEnd = (Long64_t)numTasks*(thread+1)/iNumThreads;
+		if(range.iEnd>range.iBegin) PushRange(thread,range);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		fTask=&task;
+		iNumActive=vThreads.size();
+		iGeneration++;
+	}
+	cvStart.notify_all();
+
+	RunRanges(0);
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		cvDone.wait(lock,[this]{return iNumActive==0;});
+		fTask=NULL;
+	}
+	dRealTime = std::chrono::duration<Double_t>(std::chrono::steady_clock::now()-start).count();
+}
+
+//-----------------------------------------------
+//	Loop of each worker (but the caller): it waits for a new ParallelFor() and runs ranges until there are no more
+void JDTaskScheduler::Work(Int_t thread)
+{
+	ULong64_t generation=0;
+
+	while(1)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			cvStart.wait(lock,[&]{return bStop || iGeneration!=generation;});
+			if(bStop) return;
+			generation=iGeneration;
+		}
+
+		RunRanges(thread);
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if(--iNumActive==0) cvDone.notify_one();
+		}
+	}
+}
+
+//-----------------------------------------------
+//	It takes its own ranges (or steals them) until all the indices have been run. A range larger than the grain
+//	size is split in halves: the worker runs the first one and leaves the rest in its deque.
+void JDTaskScheduler::RunRanges(Int_t thread)
+{
+	Worker& worker = vWorkers[thread];
+	Range range;
+	while(iNumPending>0)
+	{
+		if(!PopRange(thread,range) && !StealRange(thread,range))
+		{
+			// the last ranges are running: wait for a split or for the end
+			std::unique_lock<std::mutex> lock(mMutex);
+			cvWork.wait_for(lock,std::chrono::milliseconds(1),[this]{return iNumPending==0 || iNumQueued>0;});
+			continue;
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		while(range.iEnd-range.iBegin>iGrainSize)
+		{
+			Range second;
+			second.iBegin = range.iBegin+(range.iEnd-range.iBegin)/2;
+			second.iEnd = range.iEnd;
+			PushRange(thread,second);
+			range.iEnd = second.iBegin;
+		}
+		for(Int_t index=range.iBegin; index<range.iEnd; index++) (*fTask)(index,thread);
+		worker.dBusyTime += std::chrono::duration<Double_t>(std::chrono::steady_clock::now()-start).count();
+		worker.iNumTasks += range.iEnd-range.iBegin;
+
+		if((iNumPending-=range.iEnd-range.iBegin)==0)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			cvWork.notify_all();
+		}
+	}
+}
+
+//-----------------------------------------------
+//	It leaves range at the back of the deque of thread, where others can steal it
+void JDTaskScheduler::PushRange(Int_t thread, const Range& range)
+{
+	{
+		std::lock_guard<std::mutex> lock(vWorkers[thread].mMutex);
+		vWorkers[thread].dRanges.push_back(range);
+	}
+	iNumQueued++;
+	cvWork.notify_one();
+}
+
+//-----------------------------------------------
+//	It takes the last (smallest, most recent) range of the deque of thread
+Bool_t JDTaskScheduler::PopRange(Int_t thread, Range& range)
+{
+	std::lock_guard<std::mutex> lock(vWorkers[thread].mMutex);
+	if(vWorkers[thread].dRanges.empty()) return 0;
+	range = vWorkers[thread].dRanges.back();
+	vWorkers[thread].dRanges.pop_back();
+	iNumQueued--;
+	return 1;
+}
+
+//-----------------------------------------------
+//	It takes the first (largest) range of the deque of another worker, starting from the next one
+Bool_t JDTaskScheduler::StealRange(Int_t thread, Range& range)
+{
+	for(Int_t i=1; i<iNumThreads; i++)
+	{
+		Worker& victim = vWorkers[(thread+i)%iNumThreads];
+		std::lock_guard<std::mutex> lock(victim.mMutex);
+		if(victim.dRanges.empty()) continue;
+		range = victim.dRanges.front();
+		victim.dRanges.pop_front();
+		iNumQueued--;
+		vWorkers[thread].iNumSteals++;
+		return 1;
+	}
+	return 0;
+}
+
+//-----------------------------------------------
+//	Fraction of the time of the last ParallelFor() that thread was running tasks
+Double_t JDTaskScheduler::GetUtilization(Int_t thread) const
+{
+	return (dRealTime>0.? vWorkers[thread].dBusyTime/dRealTime : 0.);
+}
+
+//-----------------------------------------------
+//	Mean fraction of the time of the last ParallelFor() that the threads were running tasks
+Double_t JDTaskScheduler::GetUtilization() const
+{
+	Double_t sum = 0.;
+	for(Int_t thread=0; thread<iNumThreads; thread++) sum += GetUtilization(thread);
+	return sum/iNumThreads;
+}
+
+//-----------------------------------------------
+//	It prints the tasks, steals, busy time and utilization of each thread in the last ParallelFor()
+void JDTaskScheduler::PrintUtilization() const
+{
+	cout << endl;
+	cout << "   ************************************************" << endl;
+	cout << "   ***" << endl;
+	cout << "   ***  Task scheduler: " << iNumThreads << " threads, grain " << iGrainSize << TString::Format(", %.3f s",dRealTime) << endl;
+	for(Int_t thread=0; thread<iNumThreads; thread++)
+	{
+		cout << "   ***  " << TString::Format("thread %3d: %8lld tasks, %6lld steals, %8.3f s busy (%5.1f %%)",
+				thread,GetNumTasks(thread),GetNumSteals(thread),GetBusyTime(thread),100.*GetUtilization(thread)) << endl;
+	}
+	cout << "   ***  " << TString::Format("mean utilization: %5.1f %%",100.*GetUtilization()) << endl;
+	cout << "   ***" << endl;
+	cout << "   ************************************************" << endl;
+	cout << endl;
+}
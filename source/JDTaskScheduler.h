@@ -0,0 +1,107 @@
+/*
+ * JDTaskScheduler.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 WORK-STEALING SCHEDULER OF A FIXED SET OF WORKER THREADS (THE CALLER OF ParallelFor() IS THE WORKER 0).
+ *  		 ParallelFor() SPLITS [0, numTasks) INTO ONE CONTIGUOUS RANGE PER WORKER. EACH WORKER SPLITS ITS RANGE
+ *  		 RECURSIVELY IN HALVES DOWN TO THE GRAIN SIZE, KEEPS THE FIRST HALF AND LEAVES THE OTHER ONE IN ITS
+ *  		 DEQUE: IT TAKES BACK THE SMALLEST (LAST) RANGES, WHILE AN IDLE WORKER STEALS THE LARGEST (FIRST) RANGE
+ *  		 OF ANOTHER ONE. SO SLOW TASKS (SMEARING, ACCEPTANCE, LARGE THETA...) DO NOT LEAVE THREADS WAITING AS
+ *  		 WITH A STATIC PARTITION, AND THE NUMBER OF SYNCHRONIZATIONS GROWS WITH THE STEALS, NOT WITH THE TASKS.
+ *  		 THE TASKS MUST NOT TOUCH ROOT OBJECTS THAT ARE NOT THREAD-SAFE (TF1, TF2, TGraph...) NOR CALL
+ *  		 ParallelFor() OF THE SAME SCHEDULER.
+ *  		 A SCHEDULER OF ONE THREAD STARTS NO WORKER: ITS TASKS RUN ON THE CALLER, SO IT CAN BE USED INSIDE THE
+ *  		 TASKS OF ANOTHER SCHEDULER (SEE JDCampaign).
+ *  		 THE BUSY TIME, TASKS AND STEALS OF EACH WORKER IN THE LAST ParallelFor() ARE KEPT (SEE PrintUtilization()).
+ */
+
+#ifndef JDTaskScheduler_H_
+#define JDTaskScheduler_H_
+
+#include "JDGrid.h"
+
+#include <Rtypes.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JDTaskScheduler {
+public:
+	// task(index, thread): index in [0, numTasks), thread in [0, numThreads)
+	typedef std::function<void(Int_t, Int_t)> Task;
+
+	JDTaskScheduler(Int_t numThreads=0, Int_t grainSize=1);
+	virtual ~JDTaskScheduler();
+
+	// Smallest range of indices run without splitting it again (and without letting others steal from it)
+	void SetGrainSize(Int_t grainSize)			{iGrainSize=(grainSize>0? grainSize : 1);}
+
+	Int_t GetNumThreads() const					{return iNumThreads;}
+	Int_t GetGrainSize() const					{return iGrainSize;}
+
+	void ParallelFor(Int_t numTasks, const Task& task);
+
+	// Statistics of the last ParallelFor()
+	Double_t GetRealTime() const				{return dRealTime;}
+	Double_t GetBusyTime(Int_t thread) const	{return vWorkers[thread].dBusyTime;}
+	Long64_t GetNumTasks(Int_t thread) const	{return vWorkers[thread].iNumTasks;}
+	Long64_t GetNumSteals(Int_t thread) const	{return vWorkers[thread].iNumSteals;}
+	Double_t GetUtilization(Int_t thread) const;
+	Double_t GetUtilization() const;
+	void PrintUtilization() const;
+
+	static Int_t GetDefaultNumThreads();
+
+private:
+	// Indices [iBegin, iEnd)
+	class Range {
+	public:
+		Int_t iBegin;
+		Int_t iEnd;
+	};
+
+	// Deque and statistics of one worker, on cache lines of their own
+	class alignas(kJDCacheLineSize) Worker {
+	public:
+		Worker(): dBusyTime(0.), iNumTasks(0), iNumSteals(0) {}
+
+		std::mutex mMutex;
+		std::deque<Range> dRanges;
+		Double_t dBusyTime;		// [s]
+		Long64_t iNumTasks;
+		Long64_t iNumSteals;
+	};
+
+	void Work(Int_t thread);
+	void RunRanges(Int_t thread);
+	void PushRange(Int_t thread, const Range& range);
+	Bool_t PopRange(Int_t thread, Range& range);
+	Bool_t StealRange(Int_t thread, Range& range);
+
+	Int_t iNumThreads;
+	Int_t iGrainSize;
+	std::vector<Worker> vWorkers;
+	std::vector<std::thread> vThreads;
+
+	std::mutex mRunMutex;				// one ParallelFor() at a time
+	std::mutex mMutex;
+	std::condition_variable cvStart;
+	std::condition_variable cvWork;
+	std::condition_variable cvDone;
+
+	const Task* fTask;
+	std::atomic<Int_t> iNumPending;		// indices not run yet
+	std::atomic<Int_t> iNumQueued;		// ranges in the deques
+	Int_t iNumActive;
+	ULong64_t iGeneration;
+	Bool_t bStop;
+	Double_t dRealTime;					// [s]
+};
+
+#endif /* JDTaskScheduler_H_ */
@@ -0,0 +1,251 @@
+/*
+ * JDToyMC.cc
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 MONTE CARLO PROPAGATION OF THE JFACTOR UNCERTAINTY THROUGH THE OPTIMIZATION.
+ */
+
+#include "JDToyMC.h"
+#include "JDQFactorKernel.h"
+#include "JDReduction.h"
+#include "JDTaskScheduler.h"
+
+#include <TMath.h>
+#include <TRandom3.h>
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+//-----------------------------------------------
+//	The dark matter halo (from the references, with its credible bands) and the instrument are shared, not copied:
+//	they must live longer than this object
+JDToyMC::JDToyMC(JDDarkMatter* darkMatter, JDInstrument* instrument):
+jdDarkMatter(darkMatter), jdOptimization(new JDOptimization(darkMatter,instrument)),
+iEffects(-1), iNumThreads(0), iSeed(4357), dTolerance(0.30)
+{
+}
+
+//-----------------------------------------------
+//	It deletes its JDOptimization (not the shared objects)
+JDToyMC::~JDToyMC()
+{
+	delete jdOptimization;
+}
+
+//-----------------------------------------------
+//	It samples (serially) dN/dOmega of each credible band on the axis of the profiles of the kernel, the same way as
+//	the nominal profile (see JDDarkMatter::GetTGraphdNdOmegaBand() and JDQFactorKernel::SetProfile()): the median
+//	band gives the profile of the standard optimization. Beyond the last theta of the references dN/dOmega = 0.
+//	It returns 0 if the dark matter halo has no bands.
+Bool_t JDToyMC::SetBands()
+{
+	if(!jdDarkMatter->GetIsJFactorBands()) return 0;
+
+	const JDGridAxis& axis = jdOptimization->GetQFactorKernel()->GetProfile(0).GetXaxis();
+	Double_t thetaMax = jdDarkMatter->GetThetaMax();		// [deg] the range of the TF1 of the nominal dN/dOmega
+
+	vBands.assign(JDDarkMatter::kNumBands,JDGrid1D(axis));
+	for(Int_t b=0; b<JDDarkMatter::kNumBands; b++)
+	{
+		TGraph* dNdOmega = jdDarkMatter->GetTGraphdNdOmegaBand(b);
+		if(!dNdOmega || dNdOmega->GetN()<2)
+		{
+			delete dNdOmega;
+			return 0;
+		}
+
+		for(Int_t i=0; i<axis.GetNumBins(); i++)
+		{
+			Double_t theta = axis.GetBinCenter(i);
+			vBands[b].SetBinContent(i,(theta<=thetaMax? dNdOmega->Eval(theta) : 0.));
+		}
+		delete dNdOmega;
+	}
+	return 1;
+}
+
+//-----------------------------------------------
+//	dN/dOmega of the draw with quantile z [sigmas] (|z|<=2): linear interpolation between the two bands around z
+void JDToyMC::SetProfileOfDraw(Double_t z, JDGrid1D& profile) const
+{
+	Int_t band = TMath::Min((Int_t)TMath::Floor(z+2),JDDarkMatter::kNumBands-2);
+	if(band<0) band=0;
+	Double_t weight = z+2-band;
+
+	const Double_t* low = vBands[band].GetArray();
+	const Double_t* up = vBands[band+1].GetArray();
+	Double_t* values = profile.GetArray();
+	for(Int_t i=0; i<profile.GetNumBins(); i++) values[i] = (1-weight)*low[i]+weight*up[i];
+}
+
+//-----------------------------------------------
+//	It fills the grid of the draw with quantile z and finds its optimal point (kNumValues values).
+//	It only touches the buffers of its thread.
+void JDToyMC::RunDraw(Double_t z, JDQFactorKernel& kernel, JDEvalContext& context, JDGrid1D& profile, JDGrid2D& grid, Double_t* values) const
+{
+	SetProfileOfDraw(z,profile);
+	kernel.SetProfile(0,profile);
+
+	const JDGridAxis& thetaAxis = grid.GetXaxis();
+	const JDGridAxis& wobbleAxis = grid.GetYaxis();
+	for(Int_t j=0; j<wobbleAxis.GetNumBins(); j++) kernel.EvaluateRow(iEffects,wobbleAxis.GetBinCenter(j),thetaAxis,grid.GetRow(j),context);
+
+	values[kQFactorMax] = JDOptimization::GetOptimalThetaAndWobble(grid,dTolerance,
+			values[kThetaOpt],values[kThetaOptRangMin],values[kThetaOptRangMax],values[kWobbleOpt],values[kWobbleOptRangMin],values[kWobbleOptRangMax]);
+}
+
+//-----------------------------------------------
+//	It runs numDraws draws of the profile for this QFactor type (see JDOptimization::GetListOfQFactors()), plus the
+//	median profile (z=0). It returns 0 if the type is not valid or the halo has no credible bands.
+Bool_t JDToyMC::Run(Int_t numDraws, Int_t type)
+{
+	Int_t effects = JDQFactorKernel::GetEffects(type);
+	if(effects<0 || (effects&JDQFactorKernel::kSmearing))
+	{
+		cout << "   ***********************************************" << endl;
+		cout << "   ***                                         ***" << endl;
+		cout << "   ***  WARNING:                               ***" << endl;
+		cout << "   ***  Type of QFactor not valid for JDToyMC  ***" << endl;
+		cout << "   ***  (smearing is not supported)            ***" << endl;
+		cout << "   ***                                         ***" << endl;
+		cout << "   ***********************************************" << endl;
+		return 0;
+	}
+
+	// the draws replace the uncertainty: the kernel is prepared for the type without it (profile 0)
+	iEffects = effects&~JDQFactorKernel::kUncertainty;
+	Int_t nominalType = 0;
+	for(Int_t t=type, factor=1; t>0; t/=10)
+	{
+		if(t%10==2) continue;
+		nominalType += (t%10)*factor;
+		factor *= 10;
+	}
+
+	// everything that touches ROOT objects is done here, before going parallel
+	jdOptimization->PrepareQFactorKernel(nominalType);
+	if(!SetBands())
+	{
+		cout << "   ***************************************************" << endl;
+		cout << "   ***                                             ***" << endl;
+		cout << "   ***  WARNING:                                   ***" << endl;
+		cout << "   ***  The JFactor has no credible bands          ***" << endl;
+		cout << "   ***  (only the references of Bonnivard and      ***" << endl;
+		cout << "   ***  Geringer have them)                        ***" << endl;
+		cout << "   ***                                             ***" << endl;
+		cout << "   ***************************************************" << endl;
+		return 0;
+	}
+
+	TRandom3 random(iSeed);
+	vZ.resize(numDraws);
+	for(Int_t d=0; d<numDraws; d++)
+	{
+		do vZ[d] = random.Gaus(0.,1.);
+		while(TMath::Abs(vZ[d])>2.);
+	}
+	vValues.assign(numDraws*kNumValues,0.);
+	vMedianValues.assign(kNumValues,0.);
+
+	Double_t resolution = jdOptimization->GetBinResolution();		// [deg/bin]
+	Double_t thetaMax = jdOptimization->GetThetaMax();				// [deg]
+	Double_t wobbleMax = jdOptimization->GetDistCameraCenterMax();	// [deg]
+	JDGrid2D gridModel(JDGridAxis((Int_t)(thetaMax/resolution),0.,thetaMax),JDGridAxis((Int_t)(wobbleMax/resolution),0.,wobbleMax));
+
+	// one kernel, context, profile and grid per thread, reused for all its draws
+	JDTaskScheduler scheduler(iNumThreads);
+	Int_t numThreads = scheduler.GetNumThreads();
+	vector<JDQFactorKernel> kernels(numThreads,*jdOptimization->GetQFactorKernel());
+	vector<JDEvalContext> contexts(numThreads);
+	vector<JDGrid1D> profiles(numThreads,vBands[JDDarkMatter::kMedian]);
+	vector<JDGrid2D> grids(numThreads,gridModel);
+
+	// the last task is the median profile
+	scheduler.ParallelFor(numDraws+1,[&](Int_t d, Int_t thread)
+	{
+		if(d<numDraws)	RunDraw(vZ[d],kernels[thread],contexts[thread],profiles[thread],grids[thread],&vValues[d*kNumValues]);
+		else			RunDraw(0.,kernels[thread],contexts[thread],profiles[thread],grids[thread],vMedianValues.data());
+	});
+
+	return 1;
+}
+
+//-----------------------------------------------
+//	Mean of the value (see Value) over the draws (compensated sum: it does not depend on the order of the draws)
+Double_t JDToyMC::GetMean(Int_t value)
+{
+	Int_t numDraws = GetNumDraws();
+	if(numDraws==0) return 0.;
+
+	JDNeumaierSum sum;
+	for(Int_t d=0; d<numDraws; d++) sum.Add(GetValue(d,value));
+	return sum.GetSum()/numDraws;
+}
+
+//-----------------------------------------------
+//	RMS of the value (see Value) over the draws
+Double_t JDToyMC::GetRMS(Int_t value)
+{
+	Int_t numDraws = GetNumDraws();
+	if(numDraws==0) return 0.;
+
+	Double_t mean = GetMean(value);
+	JDNeumaierSum sum;
+	for(Int_t d=0; d<numDraws; d++) sum.Add((GetValue(d,value)-mean)*(GetValue(d,value)-mean));
+	return TMath::Sqrt(sum.GetSum()/numDraws);
+}
+
+//-----------------------------------------------
+//	Quantile of the value (see Value) over the draws: probability=0.5 is the median, 0.16 and 0.84 the 68% interval
+Double_t JDToyMC::GetQuantile(Int_t value, Double_t probability)
+{
+	Int_t numDraws = GetNumDraws();
+	if(numDraws==0) return 0.;
+
+	vector<Double_t> values(numDraws);
+	for(Int_t d=0; d<numDraws; d++) values[d] = GetValue(d,value);
+	std::sort(values.begin(),values.end());
+
+	Double_t position = probability*(numDraws-1);
+	Int_t d = TMath::Min((Int_t)position,numDraws-2);
+	if(d<0) return values[0];
+	Double_t f = TMath::Min(position-d,1.);
+	return values[d]+f*(values[d+1]-values[d]);
+}
+
+//-----------------------------------------------
+//	It returns the histogram of the value (see Value) over the draws. The caller owns it.
+TH1D* JDToyMC::GetTH1Distribution(Int_t value, Int_t numBins)
+{
+	const char* names[kNumValues] = {"QFactorMax", "ThetaOpt", "ThetaOptRangMin", "ThetaOptRangMax", "WobbleOpt", "WobbleOptRangMin", "WobbleOptRangMax"};
+
+	Int_t numDraws = GetNumDraws();
+	Double_t min = GetQuantile(value,0.);
+	Double_t max = GetQuantile(value,1.);
+	if(max<=min) max = min+1.;
+
+	TH1D* distribution = new TH1D(Form("hToyMC%s",names[value]),"",numBins,min,max+1e-6*(max-min));
+	distribution->SetDirectory(0);		// the caller owns it, not gDirectory
+	for(Int_t d=0; d<numDraws; d++) distribution->Fill(GetValue(d,value));
+	return distribution;
+}
+
+//-----------------------------------------------
+//	It prints the distribution of the maximum QFactor and of the optimal theta and wobble
+void JDToyMC::Print()
+{
+	const char* names[kNumValues] = {"QFactorMax", "ThetaOpt [deg]", "ThetaOptRangMin [deg]", "ThetaOptRangMax [deg]", "WobbleOpt [deg]", "WobbleOptRangMin [deg]", "WobbleOptRangMax [deg]"};
+
+	cout << endl;
+	cout << "   JDToyMC: " << GetNumDraws() << " draws of " << jdDarkMatter->GetSourceName() << " (" << jdDarkMatter->GetCandidate() << ")" << endl;
+	cout << "      " << TString::Format("%-24s %12s %12s %12s %12s %12s %12s","","median prof.","median","16%","84%","mean","rms") << endl;
+	for(Int_t v=0; v<kNumValues; v++)
+	{
+		cout << "      " << TString::Format("%-24s %12.4g %12.4g %12.4g %12.4g %12.4g %12.4g",names[v],GetMedianValue(v),
+				GetQuantile(v,0.5),GetQuantile(v,0.16),GetQuantile(v,0.84),GetMean(v),GetRMS(v)) << endl;
+	}
+	cout << endl;
+}
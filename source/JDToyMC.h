@@ -0,0 +1,86 @@
+/*
+ * JDToyMC.h
+ *
+ *  Created on: 18/10/2026
+ *
+ *  		 MONTE CARLO PROPAGATION OF THE JFACTOR UNCERTAINTY THROUGH THE OPTIMIZATION.
+ *  		 THE REFERENCES GIVE THE MEDIAN JFACTOR AND ITS 68% AND 95% CREDIBLE BANDS VS THETA (SEE JDDarkMatter::Band).
+ *  		 EACH DRAW IS A PROFILE BETWEEN THE BANDS: A QUANTILE z [SIGMAS] IS DRAWN FROM A NORMAL DISTRIBUTION TRUNCATED
+ *  		 TO |z|<=2 AND THE PROFILE FOLLOWS THAT QUANTILE AT EVERY THETA, INTERPOLATING LINEARLY BETWEEN THE BANDS
+ *  		 AT z = -2, -1, 0, 1, 2. SINCE THE INTERPOLATION IS LINEAR, dN/dOmega OF A DRAW IS THE SAME COMBINATION OF
+ *  		 THE dN/dOmega OF THE BANDS, WHICH ARE SAMPLED ONCE.
+ *  		 FOR EACH DRAW THE QFACTOR GRID IS FILLED AND ITS OPTIMAL POINT FOUND (AS IN JDOptimization::kGridScan).
+ *  		 THE DRAWS RUN IN PARALLEL: EACH THREAD KEEPS ITS COPY OF THE KERNEL (WITH THE ACCEPTANCE TABLE), ITS
+ *  		 PROFILE AND ITS GRID FOR ALL ITS DRAWS. THE RESULTS DO NOT DEPEND ON THE NUMBER OF THREADS.
+ *  		 THE UNCERTAINTY DIGIT OF THE QFACTOR TYPE IS IGNORED (THE DRAWS REPLACE THE -1 SIGMA PROFILE) AND
+ *  		 SMEARING IS NOT SUPPORTED.
+ *  		 The macro "exampleJDToyMC.cxx" shows how to use this class.
+ */
+
+#ifndef JDToyMC_H_
+#define JDToyMC_H_
+
+#include "JDDarkMatter.h"
+#include "JDGrid.h"
+#include "JDInstrument.h"
+#include "JDOptimization.h"
+
+#include <Rtypes.h>
+#include <TH1.h>
+
+#include <vector>
+
+class JDToyMC {
+public:
+	// Values of each draw (same order as JDSurfaceStore::kNumOptimumValues)
+	enum Value {kQFactorMax=0, kThetaOpt=1, kThetaOptRangMin=2, kThetaOptRangMax=3, kWobbleOpt=4, kWobbleOptRangMin=5, kWobbleOptRangMax=6};
+	static const Int_t kNumValues = 7;
+
+	JDToyMC(JDDarkMatter* darkMatter, JDInstrument* instrument);
+	virtual ~JDToyMC();
+
+	// Threads running the draws (0: one per hardware thread)
+	void SetNumThreads(Int_t numThreads)		{iNumThreads=numThreads;}
+	Int_t GetNumThreads()						{return iNumThreads;}
+	void SetSeed(UInt_t seed)					{iSeed=seed;}
+	UInt_t GetSeed()							{return iSeed;}
+	// The optimal ranges are where the QFactor is above (1-tolerance) of its maximum (0.30 by default)
+	void SetTolerance(Double_t tolerance)		{dTolerance=tolerance;}
+	Double_t GetTolerance()						{return dTolerance;}
+
+	JDOptimization* GetOptimization()			{return jdOptimization;}
+
+	Bool_t Run(Int_t numDraws, Int_t type=0);
+
+	// Of the last Run()
+	Int_t GetNumDraws()							{return vZ.size();}
+	Double_t GetZ(Int_t draw)					{return vZ[draw];}					// quantile of the draw [sigmas]
+	Double_t GetValue(Int_t draw, Int_t value)	{return vValues[draw*kNumValues+value];}
+	Double_t GetMedianValue(Int_t value)		{return vMedianValues[value];}		// of the median profile (z=0)
+	Double_t GetMean(Int_t value);
+	Double_t GetRMS(Int_t value);
+	Double_t GetQuantile(Int_t value, Double_t probability);
+	TH1D* GetTH1Distribution(Int_t value, Int_t numBins=50);
+	void Print();
+
+private:
+	Bool_t SetBands();
+	void SetProfileOfDraw(Double_t z, JDGrid1D& profile) const;
+	void RunDraw(Double_t z, JDQFactorKernel& kernel, JDEvalContext& context, JDGrid1D& profile, JDGrid2D& grid, Double_t* values) const;
+
+	JDDarkMatter* jdDarkMatter;
+	JDOptimization* jdOptimization;
+
+	std::vector<JDGrid1D> vBands;		// dN/dOmega of each band (see JDDarkMatter::Band)
+	Int_t iEffects;
+
+	std::vector<Double_t> vZ;
+	std::vector<Double_t> vValues;		// kNumValues per draw
+	std::vector<Double_t> vMedianValues;
+
+	Int_t iNumThreads;
+	UInt_t iSeed;
+	Double_t dTolerance;
+};
+
+#endif /* JDToyMC_H_ */